@@ -0,0 +1,316 @@
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FloatParser.h"
+#include "Json.h"
+#include "ModelImporter.h"
+
+namespace
+{
+    struct TargetName
+    {
+        AnimationTarget target;
+        const char* name;
+    };
+
+    const TargetName TARGET_NAMES[] = {
+        { AnimationTarget::PointLight, "point" },
+        { AnimationTarget::SpotLight, "spot" },
+        { AnimationTarget::Lamp, "lamp" }
+    };
+
+    struct PropertyName
+    {
+        AnimationProperty property;
+        const char* name;
+    };
+
+    const PropertyName PROPERTY_NAMES[] = {
+        { AnimationProperty::Position, "position" },
+        { AnimationProperty::Direction, "direction" },
+        { AnimationProperty::Color, "color" }
+    };
+
+    glm::vec3 readVec3(const JsonValue& value, const glm::vec3& fallback)
+    {
+        if (value.Type() != JsonType::Array)
+        {
+            return fallback;
+        }
+        return glm::vec3(value[0].Number(fallback.x), value[1].Number(fallback.y), value[2].Number(fallback.z));
+    }
+
+    const LightHandle* lightHandle(const AnimationBinding& binding, const std::vector<LightHandle>& pointLights, const std::vector<LightHandle>& spotLights)
+    {
+        const auto& handles = binding.target == AnimationTarget::PointLight ? pointLights : spotLights;
+        return binding.index < handles.size() ? &handles[binding.index] : nullptr;
+    }
+}
+
+void Animator::Add(const AnimationBinding& binding, const Oscillator& oscillator)
+{
+    oscillatorChannels.push_back(addChannel(binding));
+    oscillatorOffsets.push_back(oscillator.offset);
+    oscillatorAmplitudes.push_back(oscillator.amplitude);
+    oscillatorPhases.push_back(oscillator.phase);
+    oscillatorSpeeds.push_back(oscillator.speed);
+}
+
+void Animator::Add(const AnimationBinding& binding, const Orbit& orbit)
+{
+    orbitChannels.push_back(addChannel(binding));
+    orbitCenters.push_back(orbit.center);
+    orbitStarts.push_back(orbit.start);
+    orbitSides.push_back(glm::cross(glm::normalize(orbit.axis), orbit.start));
+    orbitSpeeds.push_back(orbit.speed);
+}
+
+void Animator::Add(const AnimationBinding& binding, std::vector<Keyframe> keys, bool loop)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+    curveChannels.push_back(addChannel(binding));
+    curveFirsts.push_back(static_cast<GLuint>(keyTimes.size()));
+    curveCounts.push_back(static_cast<GLuint>(keys.size()));
+    curveLoops.push_back(loop);
+    for (const auto& key : keys)
+    {
+        keyTimes.push_back(key.time);
+        keyValues.push_back(key.value);
+    }
+}
+
+bool Animator::Load(const std::string& path, std::string& error)
+{
+    std::vector<char> file;
+    size_t size;
+    if (!ReadPaddedFile(path, file, size, error))
+    {
+        return false;
+    }
+    JsonValue document;
+    auto begin = file.data() + FLOAT_PARSER_PADDING;
+    if (!document.Parse(begin, begin + size, error))
+    {
+        error = "bad JSON: " + error;
+        return false;
+    }
+
+    const auto& channels = document["channels"];
+    if (channels.Type() != JsonType::Array)
+    {
+        error = "no channels array";
+        return false;
+    }
+    for (size_t i = 0; i < channels.Size(); ++i)
+    {
+        const auto& channel = channels[i];
+        auto where = "channel " + std::to_string(i);
+        AnimationBinding binding;
+        auto target = std::find_if(std::begin(TARGET_NAMES), std::end(TARGET_NAMES), [&](const TargetName& name)
+        {
+            return channel["target"].String() == name.name;
+        });
+        auto property = std::find_if(std::begin(PROPERTY_NAMES), std::end(PROPERTY_NAMES), [&](const PropertyName& name)
+        {
+            return channel["property"].String() == name.name;
+        });
+        if (target == std::end(TARGET_NAMES) || property == std::end(PROPERTY_NAMES) || channel["index"].Int(-1) < 0)
+        {
+            error = where + " needs a point, spot or lamp target, an index and a position, direction or color property";
+            return false;
+        }
+        binding.target = target->target;
+        binding.index = static_cast<GLuint>(channel["index"].Int());
+        binding.property = property->property;
+        if (binding.target == AnimationTarget::Lamp && binding.property != AnimationProperty::Position)
+        {
+            error = where + ": lamps only have a position";
+            return false;
+        }
+
+        if (!channel["oscillator"].IsNull())
+        {
+            const auto& source = channel["oscillator"];
+            Add(binding, Oscillator{ readVec3(source["offset"], glm::vec3(0.0f)), readVec3(source["amplitude"], glm::vec3(1.0f)),
+                                     readVec3(source["phase"], glm::vec3(0.0f)), static_cast<GLfloat>(source["speed"].Number(1.0)) });
+        }
+        else if (!channel["orbit"].IsNull())
+        {
+            const auto& source = channel["orbit"];
+            auto axis = readVec3(source["axis"], glm::vec3(0.0f, 1.0f, 0.0f));
+            if (glm::length(axis) == 0.0f)
+            {
+                error = where + " has an orbit without an axis";
+                return false;
+            }
+            Add(binding, Orbit{ readVec3(source["center"], glm::vec3(0.0f)), axis, readVec3(source["start"], glm::vec3(1.0f, 0.0f, 0.0f)),
+                                static_cast<GLfloat>(source["speed"].Number(1.0)) });
+        }
+        else if (channel["keyframes"].Type() == JsonType::Array && channel["keyframes"].Size() > 0)
+        {
+            const auto& source = channel["keyframes"];
+            std::vector<Keyframe> keys;
+            for (size_t k = 0; k < source.Size(); ++k)
+            {
+                keys.push_back({ static_cast<GLfloat>(source[k]["time"].Number()), readVec3(source[k]["value"], glm::vec3(0.0f)) });
+                if (k > 0 && keys[k].time <= keys[k - 1].time)
+                {
+                    error = where + " has keyframes out of order";
+                    return false;
+                }
+            }
+            Add(binding, std::move(keys), channel["loop"].Bool());
+        }
+        else
+        {
+            error = where + " needs an oscillator, an orbit or keyframes";
+            return false;
+        }
+    }
+    return true;
+}
+
+void Animator::SetRate(AnimationTarget target, GLuint index, GLfloat rate)
+{
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        if (bindings[i].target == target && bindings[i].index == index)
+        {
+            rates[i] = rate;
+        }
+    }
+    evaluated = false;
+}
+
+bool Animator::Animates(AnimationTarget target, GLuint index) const
+{
+    return std::any_of(bindings.begin(), bindings.end(), [&](const AnimationBinding& binding)
+    {
+        return binding.target == target && binding.index == index;
+    });
+}
+
+bool Animator::Evaluate(GLfloat time)
+{
+    if (evaluated && time == evaluatedTime)
+    {
+        return false;
+    }
+    evaluated = true;
+    evaluatedTime = time;
+
+    for (size_t i = 0; i < oscillatorChannels.size(); ++i)
+    {
+        auto channel = oscillatorChannels[i];
+        auto angle = oscillatorSpeeds[i] * rates[channel] * time;
+        values[channel] = oscillatorOffsets[i] + oscillatorAmplitudes[i] * glm::sin(glm::vec3(angle) + oscillatorPhases[i]);
+    }
+
+    for (size_t i = 0; i < orbitChannels.size(); ++i)
+    {
+        auto channel = orbitChannels[i];
+        auto angle = orbitSpeeds[i] * rates[channel] * time;
+        values[channel] = orbitCenters[i] + orbitStarts[i] * std::cos(angle) + orbitSides[i] * std::sin(angle);
+    }
+
+    for (size_t i = 0; i < curveChannels.size(); ++i)
+    {
+        auto channel = curveChannels[i];
+        auto times = keyTimes.data() + curveFirsts[i];
+        auto keys = keyValues.data() + curveFirsts[i];
+        auto count = curveCounts[i];
+        auto t = time * rates[channel];
+        auto duration = times[count - 1] - times[0];
+        if (curveLoops[i] && duration > 0.0f)
+        {
+            t = times[0] + std::fmod(std::fmod(t - times[0], duration) + duration, duration);
+        }
+
+        auto next = static_cast<GLuint>(std::upper_bound(times, times + count, t) - times);
+        if (next == 0 || next == count)
+        {
+            values[channel] = keys[next == 0 ? 0 : count - 1];
+        }
+        else
+        {
+            values[channel] = glm::mix(keys[next - 1], keys[next], (t - times[next - 1]) / (times[next] - times[next - 1]));
+        }
+    }
+    return true;
+}
+
+void Animator::Apply(LightPool& pool, const std::vector<LightHandle>& pointLights, const std::vector<LightHandle>& spotLights) const
+{
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const auto& binding = bindings[i];
+        auto handle = binding.target == AnimationTarget::Lamp ? nullptr : lightHandle(binding, pointLights, spotLights);
+        if (!handle)
+        {
+            continue;
+        }
+        switch (binding.property)
+        {
+        case AnimationProperty::Position:
+            pool.SetPosition(*handle, values[i]);
+            break;
+        case AnimationProperty::Direction:
+            if (glm::length(values[i]) > 0.0f)
+            {
+                pool.SetDirection(*handle, glm::normalize(values[i]));
+            }
+            break;
+        case AnimationProperty::Color:
+            pool.SetColor(*handle, values[i]);
+            break;
+        }
+    }
+}
+
+void Animator::Apply(const Scene& scene, StaticBatch& lamps) const
+{
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const auto& binding = bindings[i];
+        if (binding.target != AnimationTarget::Lamp || binding.index >= scene.lamps.size())
+        {
+            continue;
+        }
+        auto lamp = scene.lamps[binding.index];
+        lamp.model[3] = glm::vec4(values[i], 1.0f);
+        lamps.Move(binding.index, lamp.model, scene.Bounds(lamp));
+    }
+}
+
+Animator Animator::RoomSwings()
+{
+    const auto down = glm::vec3(0.0f, -1.0f, 0.0f);
+    const auto quarterTurn = glm::radians(90.0f);
+    Animator animator;
+    // The spot light and the first disco light swing along x, the second along z
+    animator.Add({ AnimationTarget::SpotLight, 0, AnimationProperty::Direction }, Oscillator{ down, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f), 1.0f });
+    animator.Add({ AnimationTarget::SpotLight, 1, AnimationProperty::Direction }, Oscillator{ down, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f), 2.0f });
+    animator.Add({ AnimationTarget::SpotLight, 2, AnimationProperty::Direction },
+                 Oscillator{ down, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, quarterTurn), 2.0f });
+    // The others circle around straight down
+    for (GLuint i = 3; i <= 4; ++i)
+    {
+        animator.Add({ AnimationTarget::SpotLight, i, AnimationProperty::Direction },
+                     Orbit{ down, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 2.0f });
+    }
+    return animator;
+}
+
+GLuint Animator::addChannel(const AnimationBinding& binding)
+{
+    bindings.push_back(binding);
+    rates.push_back(1.0f);
+    values.emplace_back(0.0f);
+    evaluated = false;
+    return static_cast<GLuint>(bindings.size() - 1);
+}
@@ -0,0 +1,153 @@
+/*
+    Animation.h
+
+    Light and lamp animation as data. Each channel drives one property of
+    one target from an oscillator, an orbit or a keyframe curve. Channels
+    are kept by kind in structure-of-arrays form and evaluated together for
+    one time value. The results are written into the shared light pool,
+    and the lamps are moved in the batch they are drawn from. Channels come
+    from a JSON file like this one:
+
+        { "channels": [
+            { "target": "spot", "index": 0, "property": "direction",
+              "oscillator": { "offset": [0, -1, 0], "amplitude": [1, 0, 0], "speed": 1 } },
+            { "target": "point", "index": 1, "property": "position",
+              "orbit": { "center": [0, 1, 0], "axis": [0, 1, 0], "start": [1, 0, 0], "speed": 0.5 } },
+            { "target": "lamp", "index": 1, "property": "position", "loop": true,
+              "keyframes": [ { "time": 0, "value": [0, 1, 1] }, { "time": 2, "value": [0, 1.5, 1] } ] }
+        ] }
+
+    Targets are point, spot and lamp, indexed like the scene's lists of
+    them. Properties are position, direction and color; color sets a
+    light's diffuse & specular colour. Directions are normalized.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_ANIMATION_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_ANIMATION_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "LightPool.h"
+#include "Scene.h"
+#include "StaticBatch.h"
+
+enum class AnimationTarget
+{
+    PointLight,
+    SpotLight,
+    Lamp
+};
+
+enum class AnimationProperty
+{
+    Position,
+    Direction,
+    Color
+};
+
+struct AnimationBinding
+{
+    AnimationTarget target;
+    GLuint index; // Into the scene's point lights, spot lights or lamps
+    AnimationProperty property;
+};
+
+// offset + amplitude * sin(speed * time + phase), per component
+struct Oscillator
+{
+    glm::vec3 offset;
+    glm::vec3 amplitude;
+    glm::vec3 phase;
+    GLfloat speed; // Radians a second
+};
+
+// center + start turned around axis by speed * time
+struct Orbit
+{
+    glm::vec3 center;
+    glm::vec3 axis;
+    glm::vec3 start; // At right angles to axis, its length is the radius
+    GLfloat speed; // Radians a second
+};
+
+struct Keyframe
+{
+    GLfloat time; // Seconds
+    glm::vec3 value;
+};
+
+class Animator
+{
+public:
+    void Add(const AnimationBinding& binding, const Oscillator& oscillator);
+    void Add(const AnimationBinding& binding, const Orbit& orbit);
+
+    // Keys in increasing time, interpolated linearly. Held at the ends or repeated with loop
+    void Add(const AnimationBinding& binding, std::vector<Keyframe> keys, bool loop);
+
+    // Adds the channels of a JSON file, error says what was wrong with it
+    bool Load(const std::string& path, std::string& error);
+
+    size_t Size() const
+    {
+        return bindings.size();
+    }
+
+    // Speeds up or slows down every channel driving the target
+    void SetRate(AnimationTarget target, GLuint index, GLfloat rate);
+
+    // Whether any channel drives the target, lights which are left alone can be baked
+    bool Animates(AnimationTarget target, GLuint index) const;
+
+    // Evaluates every channel at time, false when it already was
+    bool Evaluate(GLfloat time);
+
+    // Writes the lights' results into pool, through handles indexed like the scene's lights
+    void Apply(LightPool& pool, const std::vector<LightHandle>& pointLights, const std::vector<LightHandle>& spotLights) const;
+
+    // Moves the animated lamps of a batch built from scene.lamps
+    void Apply(const Scene& scene, StaticBatch& lamps) const;
+
+    // The spot light and disco light swings of the room
+    static Animator RoomSwings();
+
+private:
+    GLuint addChannel(const AnimationBinding& binding);
+
+    // Per channel
+    std::vector<AnimationBinding> bindings;
+    std::vector<GLfloat> rates;
+    std::vector<glm::vec3> values;
+
+    // Per oscillator
+    std::vector<GLuint> oscillatorChannels;
+    std::vector<glm::vec3> oscillatorOffsets;
+    std::vector<glm::vec3> oscillatorAmplitudes;
+    std::vector<glm::vec3> oscillatorPhases;
+    std::vector<GLfloat> oscillatorSpeeds;
+
+    // Per orbit, the start and its side, axis cross start, span the circle
+    std::vector<GLuint> orbitChannels;
+    std::vector<glm::vec3> orbitCenters;
+    std::vector<glm::vec3> orbitStarts;
+    std::vector<glm::vec3> orbitSides;
+    std::vector<GLfloat> orbitSpeeds;
+
+    // Per curve, its keys are keyTimes & keyValues from curveFirsts on
+    std::vector<GLuint> curveChannels;
+    std::vector<GLuint> curveFirsts;
+    std::vector<GLuint> curveCounts;
+    std::vector<char> curveLoops;
+    std::vector<GLfloat> keyTimes;
+    std::vector<glm::vec3> keyValues;
+
+    GLfloat evaluatedTime = 0.0f;
+    bool evaluated = false;
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "AntiAliasing.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "FrameStats.h"
+
+namespace
+{
+    struct ModeName
+    {
+        AntiAliasingMode mode;
+        const char* option;
+        const char* name;
+    };
+
+    const ModeName MODE_NAMES[] = {
+        { AntiAliasingMode::Off, "off", "off" },
+        { AntiAliasingMode::Msaa2, "msaa2", "MSAA 2x" },
+        { AntiAliasingMode::Msaa4, "msaa4", "MSAA 4x" },
+        { AntiAliasingMode::Msaa8, "msaa8", "MSAA 8x" },
+        { AntiAliasingMode::Fxaa, "fxaa", "FXAA" },
+        { AntiAliasingMode::Smaa, "smaa", "SMAA-style" }
+    };
+
+    GLsizei modeSamples(AntiAliasingMode mode)
+    {
+        switch (mode)
+        {
+        case AntiAliasingMode::Msaa2:
+            return 2;
+        case AntiAliasingMode::Msaa4:
+            return 4;
+        case AntiAliasingMode::Msaa8:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    GLuint colorTexture(GLenum internalFormat, GLenum format, GLsizei width, GLsizei height, GLenum filter)
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+
+    GLuint textureFramebuffer(GLuint texture)
+    {
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        return framebuffer;
+    }
+}
+
+bool ParseAntiAliasingMode(const std::string& name, AntiAliasingMode& mode)
+{
+    for (const auto& entry : MODE_NAMES)
+    {
+        if (name == entry.option)
+        {
+            mode = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* AntiAliasingModeName(AntiAliasingMode mode)
+{
+    return MODE_NAMES[static_cast<int>(mode)].name;
+}
+
+AntiAliasingMode NextAntiAliasingMode(AntiAliasingMode mode)
+{
+    return mode == AntiAliasingMode::Smaa ? AntiAliasingMode::Off : static_cast<AntiAliasingMode>(static_cast<int>(mode) + 1);
+}
+
+void AntiAliasingShaders::Setup()
+{
+    fxaa.Setup("panel.vert", "fxaa.frag");
+    smaaEdges.Setup("panel.vert", "smaa_edges.frag");
+    smaaWeights.Setup("panel.vert", "smaa_weights.frag");
+    smaaBlend.Setup("panel.vert", "smaa_blend.frag");
+}
+
+AntiAliasTarget::~AntiAliasTarget()
+{
+    release();
+    glDeleteVertexArrays(1, &vao);
+}
+
+void AntiAliasTarget::Resize(AntiAliasingMode mode, GLsizei width, GLsizei height)
+{
+    if (mode == this->mode && width == this->width && height == this->height)
+    {
+        return;
+    }
+    release();
+    this->mode = mode;
+    this->width = width;
+    this->height = height;
+    if (mode == AntiAliasingMode::Off)
+    {
+        return;
+    }
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &depth);
+    auto samples = modeSamples(mode);
+    if (samples > 0)
+    {
+        GLint maxSamples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        samples = std::min(samples, static_cast<GLsizei>(maxSamples));
+
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    }
+    else
+    {
+        // FXAA samples between texels, the SMAA-style passes read them exactly
+        color = colorTexture(GL_RGBA8, GL_RGBA, width, height, mode == AntiAliasingMode::Fxaa ? GL_LINEAR : GL_NEAREST);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: The " << AntiAliasingModeName(mode) << " framebuffer is incomplete" << std::endl;
+    }
+
+    if (mode == AntiAliasingMode::Smaa)
+    {
+        edges = colorTexture(GL_RG8, GL_RG, width, height, GL_NEAREST);
+        edgesFramebuffer = textureFramebuffer(edges);
+        weights = colorTexture(GL_RGBA8, GL_RGBA, width, height, GL_NEAREST);
+        weightsFramebuffer = textureFramebuffer(weights);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (vao == 0)
+    {
+        glGenVertexArrays(1, &vao);
+    }
+}
+
+void AntiAliasTarget::Begin(GLuint output) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, mode == AntiAliasingMode::Off ? output : framebuffer);
+}
+
+void AntiAliasTarget::End(const AntiAliasingShaders& shaders, GLuint output) const
+{
+    switch (mode)
+    {
+    case AntiAliasingMode::Off:
+        return;
+    case AntiAliasingMode::Fxaa:
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, color);
+        drawPass(shaders.fxaa);
+        break;
+    case AntiAliasingMode::Smaa:
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, color);
+        glBindFramebuffer(GL_FRAMEBUFFER, edgesFramebuffer);
+        drawPass(shaders.smaaEdges);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, edges);
+        glBindFramebuffer(GL_FRAMEBUFFER, weightsFramebuffer);
+        drawPass(shaders.smaaWeights);
+
+        glBindTexture(GL_TEXTURE_2D, weights);
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        drawPass(shaders.smaaBlend);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        break;
+    default:
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void AntiAliasTarget::release()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteFramebuffers(1, &edgesFramebuffer);
+    glDeleteFramebuffers(1, &weightsFramebuffer);
+    if (modeSamples(mode) > 0)
+    {
+        glDeleteRenderbuffers(1, &color);
+    }
+    else
+    {
+        glDeleteTextures(1, &color);
+    }
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteTextures(1, &edges);
+    glDeleteTextures(1, &weights);
+    framebuffer = color = depth = edgesFramebuffer = edges = weightsFramebuffer = weights = 0;
+}
+
+// One full screen pass, colour on unit 0 and the previous pass on unit 1
+void AntiAliasTarget::drawPass(const Shader& shader) const
+{
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    shader.Use();
+    glUniform4f(glGetUniformLocation(shader(), "rect"), -1.0f, -1.0f, 2.0f, 2.0f);
+    glUniform1i(glGetUniformLocation(shader(), "colorTexture"), 0);
+    glUniform1i(glGetUniformLocation(shader(), "passTexture"), 1);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+
+    glPolygonMode(GL_FRONT, polygonMode[0]);
+    glPolygonMode(GL_BACK, polygonMode[1]);
+}
@@ -0,0 +1,97 @@
+/*
+    AntiAliasing.h
+
+    The anti-aliasing a view is drawn with. The scene is drawn into an
+    offscreen target, then brought into the window's framebuffer. MSAA
+    modes resolve a multisampled target with a blit. FXAA and the
+    SMAA-style mode filter a single-sampled colour texture in post passes
+    over the whole view. The SMAA-style mode finds luma edges, works out
+    blend weights from the length and end shapes of each edge line, and
+    blends each pixel with its neighbours across them. Its coverage comes
+    from the revectorised line in the shader rather than SMAA's
+    precomputed area texture. With Off, the scene goes straight to the
+    window, or to whatever output it is given instead.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_ANTI_ALIASING_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_ANTI_ALIASING_H_INCLUDED
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "Shader.h"
+
+enum class AntiAliasingMode
+{
+    Off,
+    Msaa2,
+    Msaa4,
+    Msaa8,
+    Fxaa,
+    Smaa
+};
+
+// off, msaa2, msaa4, msaa8, fxaa or smaa, as --aa takes them
+bool ParseAntiAliasingMode(const std::string& name, AntiAliasingMode& mode);
+
+// For the status panel & benchmark output
+const char* AntiAliasingModeName(AntiAliasingMode mode);
+
+// The mode after mode, back to Off after the last one
+AntiAliasingMode NextAntiAliasingMode(AntiAliasingMode mode);
+
+// Post pass programs, shared by every view's target
+struct AntiAliasingShaders
+{
+    Shader fxaa;
+    Shader smaaEdges;
+    Shader smaaWeights;
+    Shader smaaBlend;
+
+    void Setup();
+};
+
+class AntiAliasTarget
+{
+public:
+    AntiAliasTarget() = default;
+    ~AntiAliasTarget();
+
+    AntiAliasTarget(const AntiAliasTarget&) = delete;
+    AntiAliasTarget& operator=(const AntiAliasTarget&) = delete;
+
+    // Mode & size of the next frame, the attachments are only remade when either changes.
+    // MSAA asks for at most the samples the implementation has
+    void Resize(AntiAliasingMode mode, GLsizei width, GLsizei height);
+
+    // Binds what the scene is drawn into, output with Off. output must have a depth buffer
+    void Begin(GLuint output = 0) const;
+
+    // Resolves or filters into output, the same size as the target, and leaves it bound
+    void End(const AntiAliasingShaders& shaders, GLuint output = 0) const;
+
+    AntiAliasingMode Mode() const
+    {
+        return mode;
+    }
+
+private:
+    void release();
+    void drawPass(const Shader& shader) const;
+
+    AntiAliasingMode mode = AntiAliasingMode::Off;
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLuint framebuffer = 0;
+    GLuint color = 0; // Renderbuffer with MSAA, texture otherwise
+    GLuint depth = 0;
+    GLuint edgesFramebuffer = 0;
+    GLuint edges = 0;
+    GLuint weightsFramebuffer = 0;
+    GLuint weights = 0;
+    GLuint vao = 0;
+};
+
+#endif
@@ -0,0 +1,368 @@
+#include "AssetPack.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    PackColor packColor(const Material& material)
+    {
+        PackColor color;
+        std::memcpy(color.ambient, &material.ambient, sizeof(color.ambient));
+        std::memcpy(color.diffuse, &material.diffuse, sizeof(color.diffuse));
+        std::memcpy(color.specular, &material.specular, sizeof(color.specular));
+        color.shininess = material.shininess;
+        return color;
+    }
+
+    Material unpackColor(const PackColor& color)
+    {
+        return Material(glm::vec3(color.ambient[0], color.ambient[1], color.ambient[2]),
+                        glm::vec3(color.diffuse[0], color.diffuse[1], color.diffuse[2]),
+                        glm::vec3(color.specular[0], color.specular[1], color.specular[2]), color.shininess);
+    }
+
+    PackObject packObject(const SceneObject& object)
+    {
+        PackObject record;
+        record.mesh = object.mesh;
+        record.material = object.material;
+        std::memcpy(record.model, &object.model[0][0], sizeof(record.model));
+        return record;
+    }
+
+    SceneObject unpackObject(const PackObject& record)
+    {
+        SceneObject object;
+        object.mesh = record.mesh;
+        object.material = record.material;
+        std::memcpy(&object.model[0][0], record.model, sizeof(record.model));
+        return object;
+    }
+
+    PackLight packLight(PackLightKind kind, const SceneLight& light)
+    {
+        PackLight record;
+        record.kind = kind;
+        std::memcpy(record.position, &light.position, sizeof(record.position));
+        std::memcpy(record.direction, &light.direction, sizeof(record.direction));
+        record.color = packColor(light.material);
+        record.constant = light.constant;
+        record.linear = light.linear;
+        record.quadratic = light.quadratic;
+        record.cutOff = light.cutOff;
+        record.outerCutOff = light.outerCutOff;
+        return record;
+    }
+
+    SceneLight unpackLight(const PackLight& record)
+    {
+        return { glm::vec3(record.position[0], record.position[1], record.position[2]),
+                 glm::vec3(record.direction[0], record.direction[1], record.direction[2]),
+                 unpackColor(record.color), record.constant, record.linear, record.quadratic, record.cutOff, record.outerCutOff };
+    }
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+bool AssetPack::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(PackHeader)))
+    {
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        Close();
+        return false;
+    }
+    data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    auto descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(PackHeader)))
+    {
+        close(descriptor);
+        return false;
+    }
+    size = static_cast<size_t>(status.st_size);
+    auto view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor); // The mapping keeps the file open
+    data = view == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(view);
+#endif
+    if (!data)
+    {
+        Close();
+        return false;
+    }
+
+    auto valid = header()->magic == ASSET_PACK_MAGIC && header()->version == ASSET_PACK_VERSION &&
+                 header()->sectionCount == static_cast<uint32_t>(PackSection::Count);
+    for (const auto& range : header()->sections)
+    {
+        valid = valid && range.offset % ASSET_PACK_ALIGNMENT == 0 && range.offset <= size && range.size <= size - range.offset;
+    }
+    if (!valid)
+    {
+        Close();
+    }
+    return valid;
+}
+
+void AssetPack::Close()
+{
+#ifdef _WIN32
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    if (file)
+    {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = nullptr;
+#else
+    if (data)
+    {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+const Vertex* AssetPack::Vertices(const PackMesh& mesh) const
+{
+    size_t count;
+    return Records<Vertex>(PackSection::Vertices, count) + mesh.firstVertex;
+}
+
+const GLuint* AssetPack::Indices(const PackMesh& mesh) const
+{
+    size_t count;
+    return Records<GLuint>(PackSection::Indices, count) + mesh.firstIndex;
+}
+
+bool LoadScene(const AssetPack& pack, Scene& scene)
+{
+    size_t vertexCount, indexCount, meshCount, lodCount, materialCount, objectCount, lampCount, lightCount;
+    pack.Records<Vertex>(PackSection::Vertices, vertexCount);
+    pack.Records<GLuint>(PackSection::Indices, indexCount);
+    auto meshes = pack.Records<PackMesh>(PackSection::Meshes, meshCount);
+    auto lods = pack.Records<PackLod>(PackSection::Lods, lodCount);
+    auto materials = pack.Records<PackMaterial>(PackSection::Materials, materialCount);
+    auto objects = pack.Records<PackObject>(PackSection::Objects, objectCount);
+    auto lamps = pack.Records<PackObject>(PackSection::Lamps, lampCount);
+    auto lights = pack.Records<PackLight>(PackSection::Lights, lightCount);
+
+    // Everything the records index is checked once up front, the rest is plain copying
+    auto valid = true;
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        const auto& mesh = meshes[i];
+        valid = valid && mesh.firstVertex <= vertexCount && mesh.vertexCount <= vertexCount - mesh.firstVertex &&
+                mesh.firstIndex <= indexCount && mesh.indexCount <= indexCount - mesh.firstIndex &&
+                mesh.lodCount > 0 && mesh.firstLod <= lodCount && mesh.lodCount <= lodCount - mesh.firstLod;
+        auto indices = pack.Indices(mesh);
+        for (GLuint j = 0; valid && j < mesh.indexCount; ++j)
+        {
+            valid = indices[j] < mesh.vertexCount;
+        }
+    }
+    for (size_t i = 0; i < lodCount; ++i)
+    {
+        valid = valid && lods[i].mesh < meshCount;
+    }
+    for (size_t i = 0; i < objectCount + lampCount; ++i)
+    {
+        const auto& object = i < objectCount ? objects[i] : lamps[i - objectCount];
+        valid = valid && object.mesh < meshCount && (object.material < materialCount || i >= objectCount);
+    }
+    if (!valid)
+    {
+        return false;
+    }
+
+    scene.meshes.resize(meshCount);
+    scene.lods.resize(meshCount);
+    for (size_t i = 0; i < meshCount; ++i)
+    {
+        const auto& record = meshes[i];
+        auto& mesh = scene.meshes[i];
+        auto vertices = pack.Vertices(record);
+        auto indices = pack.Indices(record);
+        mesh.vertices.assign(vertices, vertices + record.vertexCount);
+        mesh.indices.assign(indices, indices + record.indexCount);
+        mesh.center = glm::vec3(record.center[0], record.center[1], record.center[2]);
+        mesh.radius = record.radius;
+        for (auto j = record.firstLod; j < record.firstLod + record.lodCount; ++j)
+        {
+            scene.lods[i].push_back({ lods[j].mesh, lods[j].maxPixelRadius });
+        }
+    }
+    for (size_t i = 0; i < materialCount; ++i)
+    {
+        scene.materials.push_back({ unpackColor(materials[i].material), unpackColor(materials[i].tracked) });
+    }
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        scene.objects.push_back(unpackObject(objects[i]));
+    }
+    for (size_t i = 0; i < lampCount; ++i)
+    {
+        scene.lamps.push_back(unpackObject(lamps[i]));
+    }
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        (lights[i].kind == PackLightKind::Point ? scene.pointLights : scene.spotLights).push_back(unpackLight(lights[i]));
+    }
+    return true;
+}
+
+bool WriteAssetPack(const std::string& path, const Scene& scene)
+{
+    std::vector<PackMesh> meshes;
+    std::vector<PackLod> lods;
+    uint32_t vertexCount = 0, indexCount = 0;
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        const auto& mesh = scene.meshes[i];
+        PackMesh record = { vertexCount, static_cast<uint32_t>(mesh.vertices.size()), indexCount, static_cast<uint32_t>(mesh.indices.size()),
+                            static_cast<uint32_t>(lods.size()), static_cast<uint32_t>(scene.lods[i].size()),
+                            { mesh.center.x, mesh.center.y, mesh.center.z }, mesh.radius };
+        meshes.push_back(record);
+        for (const auto& level : scene.lods[i])
+        {
+            lods.push_back({ level.mesh, level.maxPixelRadius });
+        }
+        vertexCount += record.vertexCount;
+        indexCount += record.indexCount;
+    }
+
+    std::vector<PackMaterial> materials;
+    for (const auto& material : scene.materials)
+    {
+        materials.push_back({ packColor(material.material), packColor(material.tracked) });
+    }
+    std::vector<PackObject> objects, lamps;
+    for (const auto& object : scene.objects)
+    {
+        objects.push_back(packObject(object));
+    }
+    for (const auto& lamp : scene.lamps)
+    {
+        lamps.push_back(packObject(lamp));
+    }
+    std::vector<PackLight> lights;
+    for (const auto& light : scene.pointLights)
+    {
+        lights.push_back(packLight(PackLightKind::Point, light));
+    }
+    for (const auto& light : scene.spotLights)
+    {
+        lights.push_back(packLight(PackLightKind::Spot, light));
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // Sections follow the header in PackSection order, each padded to the alignment
+    PackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.sectionCount = static_cast<uint32_t>(PackSection::Count);
+    uint64_t offset = sizeof(PackHeader);
+    auto place = [&header, &offset](PackSection section, uint64_t size)
+    {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        header.sections[static_cast<size_t>(section)] = { offset, size };
+        offset += size;
+    };
+    place(PackSection::Vertices, vertexCount * sizeof(Vertex));
+    place(PackSection::Indices, indexCount * sizeof(GLuint));
+    place(PackSection::Meshes, meshes.size() * sizeof(PackMesh));
+    place(PackSection::Lods, lods.size() * sizeof(PackLod));
+    place(PackSection::Materials, materials.size() * sizeof(PackMaterial));
+    place(PackSection::Objects, objects.size() * sizeof(PackObject));
+    place(PackSection::Lamps, lamps.size() * sizeof(PackObject));
+    place(PackSection::Lights, lights.size() * sizeof(PackLight));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Zeros up to where the next section starts, then its contents
+    uint64_t written = sizeof(PackHeader);
+    auto seek = [&file, &header, &written](PackSection section)
+    {
+        static const char padding[ASSET_PACK_ALIGNMENT] = {};
+        auto start = header.sections[static_cast<size_t>(section)].offset;
+        file.write(padding, static_cast<std::streamsize>(start - written));
+        written = start;
+    };
+    auto write = [&file, &written](const void* bytes, uint64_t size)
+    {
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+        written += size;
+    };
+    seek(PackSection::Vertices);
+    for (const auto& mesh : scene.meshes)
+    {
+        write(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+    }
+    seek(PackSection::Indices);
+    for (const auto& mesh : scene.meshes)
+    {
+        write(mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+    }
+    seek(PackSection::Meshes);
+    write(meshes.data(), meshes.size() * sizeof(PackMesh));
+    seek(PackSection::Lods);
+    write(lods.data(), lods.size() * sizeof(PackLod));
+    seek(PackSection::Materials);
+    write(materials.data(), materials.size() * sizeof(PackMaterial));
+    seek(PackSection::Objects);
+    write(objects.data(), objects.size() * sizeof(PackObject));
+    seek(PackSection::Lamps);
+    write(lamps.data(), lamps.size() * sizeof(PackObject));
+    seek(PackSection::Lights);
+    write(lights.data(), lights.size() * sizeof(PackLight));
+    return static_cast<bool>(file);
+}
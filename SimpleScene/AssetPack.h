@@ -0,0 +1,180 @@
+/*
+    AssetPack.h
+
+    The whole scene in one versioned binary file: vertex and index blobs in
+    the layout GeometryPool uploads, mesh ranges with their levels of
+    detail, materials, objects, lamps and lights. The file is memory mapped
+    and read in place, so a scene loads without being parsed and meshes go
+    to the GPU straight from the mapping.
+
+    Layout, little endian, every section starting on ASSET_PACK_ALIGNMENT:
+        PackHeader, with the offset and size of each PackSection
+        Vertices    Vertex[]
+        Indices     GLuint[], relative to the mesh's first vertex
+        Meshes      PackMesh[]
+        Lods        PackLod[], mesh indices refer to the Meshes section
+        Materials   PackMaterial[]
+        Objects     PackObject[]
+        Lamps       PackObject[]
+        Lights      PackLight[], point lights first, then spot lights
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_ASSET_PACK_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_ASSET_PACK_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+#include "Scene.h"
+
+#define ASSET_PACK_MAGIC 0x4B505353 // "SSPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 64
+
+enum class PackSection : uint32_t
+{
+    Vertices,
+    Indices,
+    Meshes,
+    Lods,
+    Materials,
+    Objects,
+    Lamps,
+    Lights,
+    Count
+};
+
+struct PackSectionRange
+{
+    uint64_t offset; // Bytes from the start of the file
+    uint64_t size;
+};
+
+struct PackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    PackSectionRange sections[static_cast<size_t>(PackSection::Count)];
+};
+
+struct PackMesh
+{
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstLod; // The mesh's Scene::lods entry
+    uint32_t lodCount;
+    float center[3];
+    float radius;
+};
+
+struct PackLod
+{
+    uint32_t mesh;
+    float maxPixelRadius;
+};
+
+struct PackColor
+{
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float shininess;
+};
+
+struct PackMaterial
+{
+    PackColor material;
+    PackColor tracked;
+};
+
+struct PackObject
+{
+    uint32_t mesh;
+    uint32_t material;
+    float model[16]; // Column major
+};
+
+enum class PackLightKind : uint32_t
+{
+    Point,
+    Spot
+};
+
+struct PackLight
+{
+    PackLightKind kind;
+    float position[3];
+    float direction[3];
+    PackColor color;
+    float constant;
+    float linear;
+    float quadratic;
+    float cutOff; // Degrees
+    float outerCutOff;
+};
+
+static_assert(sizeof(Vertex) == 24, "Vertices are stored as GeometryPool uploads them");
+static_assert(sizeof(PackHeader) == 16 + 16 * static_cast<size_t>(PackSection::Count), "PackHeader has no padding");
+static_assert(sizeof(PackMesh) == 40 && sizeof(PackLod) == 8 && sizeof(PackMaterial) == 80, "Pack records have no padding");
+static_assert(sizeof(PackObject) == 72 && sizeof(PackLight) == 88, "Pack records have no padding");
+
+class AssetPack
+{
+public:
+    AssetPack() = default;
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // Maps the file and checks the header, and that every section lies inside it
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const
+    {
+        return data != nullptr;
+    }
+
+    // Records of a section, read in place
+    template <typename T>
+    const T* Records(PackSection section, size_t& count) const
+    {
+        const auto& range = header()->sections[static_cast<size_t>(section)];
+        count = static_cast<size_t>(range.size / sizeof(T));
+        return reinterpret_cast<const T*>(data + range.offset);
+    }
+
+    // A mesh's blobs, ready for GeometryPool::Add
+    const Vertex* Vertices(const PackMesh& mesh) const;
+    const GLuint* Indices(const PackMesh& mesh) const;
+
+private:
+    const PackHeader* header() const
+    {
+        return reinterpret_cast<const PackHeader*>(data);
+    }
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// Fills an empty scene from the pack. Mesh data is copied in bulk, there is nothing to parse.
+// False, with the scene left empty, if the records point outside their sections
+bool LoadScene(const AssetPack& pack, Scene& scene);
+
+// False if the file couldn't be written
+bool WriteAssetPack(const std::string& path, const Scene& scene);
+
+#endif
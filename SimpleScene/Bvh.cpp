@@ -0,0 +1,545 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    const GLuint SAH_BINS = 16;
+    const GLuint MAX_LEAF_SIZE = 8;
+    const GLfloat TRAVERSAL_COST = 1.0f; // Relative to one triangle test
+
+    // Trees are kept shallower than the traversal stacks
+    const GLuint MAX_DEPTH = 60;
+    const int STACK_SIZE = 64;
+
+    // Below this many triangles a subtree isn't worth handing to another thread
+    const GLuint MIN_PARALLEL_TRIANGLES = 256;
+
+    GLfloat surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        auto d = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool cullsDeterminant(GLfloat det, BvhCull cull)
+    {
+        switch (cull)
+        {
+        case BvhCull::BackFaces:
+            return det <= 0.0f;
+        case BvhCull::FrontFaces:
+            return det >= 0.0f;
+        default:
+            return det == 0.0f;
+        }
+    }
+
+    // Moller-Trumbore, the determinant is positive for rays hitting the front
+    bool intersectTriangle(const BvhTriangle& triangle, const glm::vec3& origin, const glm::vec3& direction, BvhCull cull,
+                           GLfloat& t, GLfloat& u, GLfloat& v)
+    {
+        auto p = glm::cross(direction, triangle.e2);
+        auto det = glm::dot(triangle.e1, p);
+        if (cullsDeterminant(det, cull))
+        {
+            return false;
+        }
+        auto invDet = 1.0f / det;
+        auto s = origin - triangle.v0;
+        u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+        auto q = glm::cross(s, triangle.e1);
+        v = glm::dot(direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+        t = glm::dot(triangle.e2, q) * invDet;
+        return t > 0.0f;
+    }
+
+    // Entry distance, or FLT_MAX if the ray misses the box before tMax
+    GLfloat intersectBounds(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, GLfloat tMax)
+    {
+        auto t0 = (node.boundsMin - origin) * inverse;
+        auto t1 = (node.boundsMax - origin) * inverse;
+        auto tNear = glm::min(t0, t1);
+        auto tFar = glm::max(t0, t1);
+        auto enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        auto exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    // Lanes entering the box before their tMax, with the entry distances in tNear
+    __m128 intersectBounds(const BvhNode& node, const RayPacket& packet, __m128 tMax, __m128& tNear)
+    {
+        auto enter = _mm_setzero_ps();
+        auto exit = tMax;
+        for (auto axis = 0; axis < 3; ++axis)
+        {
+            auto t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[axis]), packet.origin[axis]), packet.inverse[axis]);
+            auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[axis]), packet.origin[axis]), packet.inverse[axis]);
+            enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+            exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+        }
+        tNear = enter;
+        return _mm_cmple_ps(enter, exit);
+    }
+
+    // Four rays against one triangle, returns the lanes hitting it before tMax
+    __m128 intersectTriangle(const BvhTriangle& triangle, const RayPacket& packet, BvhCull cull, __m128 tMax,
+                             __m128& t, __m128& u, __m128& v)
+    {
+        const auto& d = packet.direction;
+        __m128 e1[3], e2[3], s[3];
+        for (auto axis = 0; axis < 3; ++axis)
+        {
+            e1[axis] = _mm_set1_ps(triangle.e1[axis]);
+            e2[axis] = _mm_set1_ps(triangle.e2[axis]);
+            s[axis] = _mm_sub_ps(packet.origin[axis], _mm_set1_ps(triangle.v0[axis]));
+        }
+
+        __m128 p[3] = {
+            _mm_sub_ps(_mm_mul_ps(d[1], e2[2]), _mm_mul_ps(d[2], e2[1])),
+            _mm_sub_ps(_mm_mul_ps(d[2], e2[0]), _mm_mul_ps(d[0], e2[2])),
+            _mm_sub_ps(_mm_mul_ps(d[0], e2[1]), _mm_mul_ps(d[1], e2[0]))
+        };
+        auto det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])), _mm_mul_ps(e1[2], p[2]));
+
+        auto zero = _mm_setzero_ps();
+        __m128 valid;
+        switch (cull)
+        {
+        case BvhCull::BackFaces:
+            valid = _mm_cmpgt_ps(det, zero);
+            break;
+        case BvhCull::FrontFaces:
+            valid = _mm_cmplt_ps(det, zero);
+            break;
+        default:
+            valid = _mm_cmpneq_ps(det, zero);
+            break;
+        }
+        auto invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0], p[0]), _mm_mul_ps(s[1], p[1])), _mm_mul_ps(s[2], p[2])), invDet);
+        __m128 q[3] = {
+            _mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(s[2], e1[1])),
+            _mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(s[0], e1[2])),
+            _mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(s[1], e1[0]))
+        };
+        v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], q[0]), _mm_mul_ps(d[1], q[1])), _mm_mul_ps(d[2], q[2])), invDet);
+        t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], q[0]), _mm_mul_ps(e2[1], q[1])), _mm_mul_ps(e2[2], q[2])), invDet);
+
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+        valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, zero));
+        return _mm_and_ps(valid, _mm_cmplt_ps(t, tMax));
+    }
+
+    __m128 select(__m128 mask, __m128 updated, __m128 old)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, updated), _mm_andnot_ps(mask, old));
+    }
+
+    // Nearest entry over the lanes in mask
+    GLfloat nearest(__m128 tNear, __m128 mask)
+    {
+        GLfloat t[4];
+        _mm_storeu_ps(t, select(mask, tNear, _mm_set1_ps(FLT_MAX)));
+        return std::min(std::min(t[0], t[1]), std::min(t[2], t[3]));
+    }
+}
+
+void Bvh::Build(std::vector<BvhTriangle> input, ThreadPool* pool)
+{
+    nodes.clear();
+    triangles.clear();
+    if (input.empty())
+    {
+        return;
+    }
+
+    auto count = static_cast<GLuint>(input.size());
+    references.resize(count);
+    for (GLuint i = 0; i < count; ++i)
+    {
+        const auto& triangle = input[i];
+        auto v1 = triangle.v0 + triangle.e1;
+        auto v2 = triangle.v0 + triangle.e2;
+        auto& reference = references[i];
+        reference.boundsMin = glm::min(triangle.v0, glm::min(v1, v2));
+        reference.boundsMax = glm::max(triangle.v0, glm::max(v1, v2));
+        reference.centroid = (reference.boundsMin + reference.boundsMax) * 0.5f;
+        reference.triangle = i;
+    }
+
+    // The top splits are made here until there is a handful of subtrees for every thread
+    nodes.reserve(2 * static_cast<size_t>(count));
+    nodes.emplace_back();
+    std::vector<Subtree> deferred;
+    auto parallel = pool && pool->Size() > 1;
+    auto parallelBelow = parallel ? std::max(count / (pool->Size() * 4), MIN_PARALLEL_TRIANGLES) : 0;
+    build(nodes, 0, 0, count, 0, parallelBelow, parallel ? &deferred : nullptr);
+
+    if (!deferred.empty())
+    {
+        std::vector<std::vector<BvhNode>> subtrees(deferred.size());
+        pool->ParallelFor(deferred.size(), [this, &deferred, &subtrees](size_t i, unsigned)
+        {
+            subtrees[i].emplace_back();
+            build(subtrees[i], 0, deferred[i].begin, deferred[i].end, deferred[i].depth, 0, nullptr);
+        });
+
+        // Local node i > 0 lands at base + i - 1, the local root replaces the placeholder
+        for (size_t i = 0; i < deferred.size(); ++i)
+        {
+            auto base = static_cast<GLuint>(nodes.size());
+            auto remap = [base](BvhNode node)
+            {
+                if (node.count == 0)
+                {
+                    node.leftFirst = base + node.leftFirst - 1;
+                }
+                return node;
+            };
+            nodes[deferred[i].node] = remap(subtrees[i][0]);
+            for (size_t j = 1; j < subtrees[i].size(); ++j)
+            {
+                nodes.push_back(remap(subtrees[i][j]));
+            }
+        }
+    }
+
+    // Leaves index straight into the triangles, so they're stored in tree order
+    triangles.reserve(count);
+    for (const auto& reference : references)
+    {
+        triangles.push_back(input[reference.triangle]);
+    }
+    references.clear();
+    references.shrink_to_fit();
+}
+
+void Bvh::build(std::vector<BvhNode>& nodes, GLuint node, GLuint begin, GLuint end, GLuint depth, GLuint parallelBelow, std::vector<Subtree>* deferred)
+{
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (auto i = begin; i < end; ++i)
+    {
+        boundsMin = glm::min(boundsMin, references[i].boundsMin);
+        boundsMax = glm::max(boundsMax, references[i].boundsMax);
+    }
+    nodes[node].boundsMin = boundsMin;
+    nodes[node].boundsMax = boundsMax;
+
+    auto count = end - begin;
+    if (deferred && count <= parallelBelow)
+    {
+        deferred->push_back({ node, begin, end, depth });
+        return;
+    }
+
+    auto middle = count > 1 && depth < MAX_DEPTH ? split(begin, end, boundsMin, boundsMax) : begin;
+    if (middle == begin || middle == end)
+    {
+        nodes[node].leftFirst = begin;
+        nodes[node].count = count;
+        return;
+    }
+
+    // Children are allocated as a pair, the right one is always left + 1
+    auto left = static_cast<GLuint>(nodes.size());
+    nodes.resize(nodes.size() + 2);
+    nodes[node].leftFirst = left;
+    nodes[node].count = 0;
+    build(nodes, left, begin, middle, depth + 1, parallelBelow, deferred);
+    build(nodes, left + 1, middle, end, depth + 1, parallelBelow, deferred);
+}
+
+GLuint Bvh::split(GLuint begin, GLuint end, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    auto count = end - begin;
+    glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+    for (auto i = begin; i < end; ++i)
+    {
+        centroidMin = glm::min(centroidMin, references[i].centroid);
+        centroidMax = glm::max(centroidMax, references[i].centroid);
+    }
+
+    struct Bin
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        GLuint count;
+    };
+
+    auto bestCost = FLT_MAX;
+    auto bestAxis = -1;
+    GLuint bestSplit = 0;
+    auto parentArea = surfaceArea(boundsMin, boundsMax);
+    for (auto axis = 0; axis < 3; ++axis)
+    {
+        auto extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        Bin bins[SAH_BINS];
+        for (auto& bin : bins)
+        {
+            bin = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), 0 };
+        }
+        auto scale = SAH_BINS / extent;
+        for (auto i = begin; i < end; ++i)
+        {
+            auto b = std::min(static_cast<GLuint>((references[i].centroid[axis] - centroidMin[axis]) * scale), SAH_BINS - 1);
+            bins[b].boundsMin = glm::min(bins[b].boundsMin, references[i].boundsMin);
+            bins[b].boundsMax = glm::max(bins[b].boundsMax, references[i].boundsMax);
+            ++bins[b].count;
+        }
+
+        // Sweep from the right first, then from the left pricing every plane between bins
+        GLfloat rightCost[SAH_BINS];
+        glm::vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+        GLuint sweepCount = 0;
+        for (auto b = SAH_BINS - 1; b > 0; --b)
+        {
+            sweepMin = glm::min(sweepMin, bins[b].boundsMin);
+            sweepMax = glm::max(sweepMax, bins[b].boundsMax);
+            sweepCount += bins[b].count;
+            rightCost[b] = sweepCount ? surfaceArea(sweepMin, sweepMax) * sweepCount : 0.0f;
+        }
+        sweepMin = glm::vec3(FLT_MAX);
+        sweepMax = glm::vec3(-FLT_MAX);
+        sweepCount = 0;
+        for (GLuint b = 1; b < SAH_BINS; ++b)
+        {
+            sweepMin = glm::min(sweepMin, bins[b - 1].boundsMin);
+            sweepMax = glm::max(sweepMax, bins[b - 1].boundsMax);
+            sweepCount += bins[b - 1].count;
+            if (sweepCount == 0 || sweepCount == count)
+            {
+                continue;
+            }
+            auto cost = surfaceArea(sweepMin, sweepMax) * sweepCount + rightCost[b];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    if (bestAxis < 0)
+    {
+        // Every centroid in one spot, halve it anyway if the leaf would be too big
+        return count > MAX_LEAF_SIZE ? begin + count / 2 : begin;
+    }
+    bestCost = TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+    if (bestCost >= count && count <= MAX_LEAF_SIZE)
+    {
+        return begin;
+    }
+
+    auto scale = SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    auto first = references.begin() + begin;
+    auto middle = std::partition(first, references.begin() + end, [&](const Reference& reference)
+    {
+        return std::min(static_cast<GLuint>((reference.centroid[bestAxis] - centroidMin[bestAxis]) * scale), SAH_BINS - 1) < bestSplit;
+    });
+    return static_cast<GLuint>(middle - references.begin());
+}
+
+bool Bvh::Intersect(const glm::vec3& origin, const glm::vec3& direction, GLuint mask, BvhCull cull, BvhHit& hit) const
+{
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    auto inverse = 1.0f / direction;
+    auto found = false;
+    if (intersectBounds(nodes[0], origin, inverse, hit.t) == FLT_MAX)
+    {
+        return false;
+    }
+
+    GLuint stack[STACK_SIZE];
+    auto top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const auto& node = nodes[stack[--top]];
+        if (node.count > 0)
+        {
+            for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+            {
+                const auto& triangle = triangles[i];
+                GLfloat t, u, v;
+                if ((triangle.mask & mask) != 0 && intersectTriangle(triangle, origin, direction, cull, t, u, v) && t < hit.t)
+                {
+                    hit = { t, u, v, triangle.id };
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top, so it can shorten the ray before the other one is opened
+        auto left = node.leftFirst;
+        auto right = left + 1;
+        auto tLeft = intersectBounds(nodes[left], origin, inverse, hit.t);
+        auto tRight = intersectBounds(nodes[right], origin, inverse, hit.t);
+        if (tLeft > tRight)
+        {
+            std::swap(left, right);
+            std::swap(tLeft, tRight);
+        }
+        if (tRight != FLT_MAX)
+        {
+            stack[top++] = right;
+        }
+        if (tLeft != FLT_MAX)
+        {
+            stack[top++] = left;
+        }
+    }
+    return found;
+}
+
+void Bvh::Intersect(const RayPacket& packet, __m128 active, GLuint mask, BvhCull cull, PacketHit& hit) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    __m128 tNear;
+    if (_mm_movemask_ps(_mm_and_ps(active, intersectBounds(nodes[0], packet, hit.t, tNear))) == 0)
+    {
+        return;
+    }
+
+    GLuint stack[STACK_SIZE];
+    auto top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const auto& node = nodes[stack[--top]];
+        if (node.count > 0)
+        {
+            for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+            {
+                const auto& triangle = triangles[i];
+                if ((triangle.mask & mask) == 0)
+                {
+                    continue;
+                }
+                __m128 t, u, v;
+                auto hits = _mm_and_ps(active, intersectTriangle(triangle, packet, cull, hit.t, t, u, v));
+                if (_mm_movemask_ps(hits) != 0)
+                {
+                    hit.t = select(hits, t, hit.t);
+                    hit.u = select(hits, u, hit.u);
+                    hit.v = select(hits, v, hit.v);
+                    hit.id = _mm_castps_si128(select(hits, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(triangle.id))), _mm_castsi128_ps(hit.id)));
+                }
+            }
+            continue;
+        }
+
+        // A child is opened if any lane enters it, the one any lane reaches first goes on top
+        auto left = node.leftFirst;
+        auto right = left + 1;
+        __m128 tLeft, tRight;
+        auto maskLeft = _mm_and_ps(active, intersectBounds(nodes[left], packet, hit.t, tLeft));
+        auto maskRight = _mm_and_ps(active, intersectBounds(nodes[right], packet, hit.t, tRight));
+        auto hitLeft = _mm_movemask_ps(maskLeft) != 0;
+        auto hitRight = _mm_movemask_ps(maskRight) != 0;
+        if (hitLeft && hitRight)
+        {
+            if (nearest(tLeft, maskLeft) > nearest(tRight, maskRight))
+            {
+                std::swap(left, right);
+            }
+            stack[top++] = right;
+            stack[top++] = left;
+        }
+        else if (hitLeft)
+        {
+            stack[top++] = left;
+        }
+        else if (hitRight)
+        {
+            stack[top++] = right;
+        }
+    }
+}
+
+__m128 Bvh::Occluded(const RayPacket& packet, __m128 active, __m128 tMax, GLuint mask) const
+{
+    auto occluded = _mm_setzero_ps();
+    if (nodes.empty())
+    {
+        return occluded;
+    }
+
+    GLuint stack[STACK_SIZE];
+    auto top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        // Lanes drop out as soon as anything blocks them
+        auto open = _mm_andnot_ps(occluded, active);
+        if (_mm_movemask_ps(open) == 0)
+        {
+            break;
+        }
+
+        const auto& node = nodes[stack[--top]];
+        __m128 tNear;
+        if (_mm_movemask_ps(_mm_and_ps(open, intersectBounds(node, packet, tMax, tNear))) == 0)
+        {
+            continue;
+        }
+        if (node.count == 0)
+        {
+            stack[top++] = node.leftFirst + 1;
+            stack[top++] = node.leftFirst;
+            continue;
+        }
+
+        for (auto i = node.leftFirst; i < node.leftFirst + node.count; ++i)
+        {
+            const auto& triangle = triangles[i];
+            if ((triangle.mask & mask) == 0)
+            {
+                continue;
+            }
+            __m128 t, u, v;
+            occluded = _mm_or_ps(occluded, _mm_and_ps(open, intersectTriangle(triangle, packet, BvhCull::None, tMax, t, u, v)));
+        }
+    }
+    return occluded;
+}
+
+RayPacket MakeRayPacket(const glm::vec3 origins[4], const glm::vec3 directions[4])
+{
+    RayPacket packet;
+    for (auto axis = 0; axis < 3; ++axis)
+    {
+        packet.origin[axis] = _mm_setr_ps(origins[0][axis], origins[1][axis], origins[2][axis], origins[3][axis]);
+        packet.direction[axis] = _mm_setr_ps(directions[0][axis], directions[1][axis], directions[2][axis], directions[3][axis]);
+        packet.inverse[axis] = _mm_div_ps(_mm_set1_ps(1.0f), packet.direction[axis]);
+    }
+    return packet;
+}
@@ -0,0 +1,134 @@
+/*
+    Bvh.h
+
+    Bounding volume hierarchy over world space triangles, split with the
+    surface area heuristic over binned centroids. The top of the tree is
+    split on the calling thread until there are enough independent subtrees
+    to keep a ThreadPool busy, then those are built in parallel and stitched
+    in. Rays are traced alone or as packets of four in SSE lanes.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_BVH_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_BVH_H_INCLUDED
+
+#include <vector>
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ThreadPool.h"
+
+#define BVH_NO_HIT 0xFFFFFFFF
+
+// A triangle is only tested by queries whose mask shares a bit with its own
+#define BVH_MASK_VISIBLE 1
+#define BVH_MASK_SHADOW_CASTER 2
+
+// Which side of a triangle a query skips, counter clockwise is the front as in GL
+enum class BvhCull
+{
+    None,
+    BackFaces,
+    FrontFaces
+};
+
+struct BvhTriangle
+{
+    glm::vec3 v0;
+    glm::vec3 e1; // v1 - v0
+    glm::vec3 e2; // v2 - v0
+    GLuint mask;
+    GLuint id; // Caller's index, handed back in hits
+};
+
+struct BvhNode
+{
+    glm::vec3 boundsMin;
+    GLuint leftFirst; // Left child, right child follows it. First triangle in a leaf
+    glm::vec3 boundsMax;
+    GLuint count; // Triangles in a leaf, 0 for inner nodes
+};
+
+struct BvhHit
+{
+    GLfloat t;
+    GLfloat u, v; // Barycentrics of v1 and v2
+    GLuint id;
+};
+
+// Four rays, one per lane
+struct RayPacket
+{
+    __m128 origin[3];
+    __m128 direction[3];
+    __m128 inverse[3];
+};
+
+struct PacketHit
+{
+    __m128 t; // Also the limit going in
+    __m128 u, v;
+    __m128i id;
+};
+
+class Bvh
+{
+public:
+    Bvh() = default;
+    ~Bvh() = default;
+
+    // Builds on the pool if one is given
+    void Build(std::vector<BvhTriangle> triangles, ThreadPool* pool = nullptr);
+
+    // Closest hit before hit.t, which the caller sets
+    bool Intersect(const glm::vec3& origin, const glm::vec3& direction, GLuint mask, BvhCull cull, BvhHit& hit) const;
+
+    // Closest hit per active lane before hit.t, lanes that miss keep their inputs
+    void Intersect(const RayPacket& packet, __m128 active, GLuint mask, BvhCull cull, PacketHit& hit) const;
+
+    // Lanes with anything in the way before tMax
+    __m128 Occluded(const RayPacket& packet, __m128 active, __m128 tMax, GLuint mask) const;
+
+    const std::vector<BvhNode>& Nodes() const
+    {
+        return nodes;
+    }
+
+    const std::vector<BvhTriangle>& Triangles() const
+    {
+        return triangles;
+    }
+
+private:
+    struct Reference
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec3 centroid;
+        GLuint triangle;
+    };
+
+    struct Subtree
+    {
+        GLuint node;
+        GLuint begin, end;
+        GLuint depth;
+    };
+
+    // Subtrees at or below parallelBelow triangles are queued in deferred instead, if given
+    void build(std::vector<BvhNode>& nodes, GLuint node, GLuint begin, GLuint end, GLuint depth, GLuint parallelBelow, std::vector<Subtree>* deferred);
+    GLuint split(GLuint begin, GLuint end, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    std::vector<BvhNode> nodes;
+    std::vector<BvhTriangle> triangles;
+    std::vector<Reference> references; // Only during Build
+};
+
+// Fills in the reciprocal directions the traversal steps with
+RayPacket MakeRayPacket(const glm::vec3 origins[4], const glm::vec3 directions[4]);
+
+#endif
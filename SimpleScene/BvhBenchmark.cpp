@@ -0,0 +1,209 @@
+#include "BvhBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "DynamicBvh.h"
+
+namespace
+{
+    const size_t BOX_COUNT = 100000;
+    const size_t QUERY_COUNT = 1000;
+    const GLfloat FIELD_SIZE = 100.0f; // Boxes lie within +-FIELD_SIZE on every axis
+    const GLfloat RAY_LENGTH = 4.0f * FIELD_SIZE;
+
+    struct Queries
+    {
+        std::vector<Frustum> frustums;
+        std::vector<glm::vec4> spheres; // Center & radius
+        std::vector<glm::vec3> rayOrigins;
+        std::vector<glm::vec3> rayDirections;
+    };
+
+    // Entry distance into the box along the ray, limit if the ray misses it before there
+    GLfloat enterBox(const BoundingBox& box, const glm::vec3& origin, const glm::vec3& inverse, GLfloat limit)
+    {
+        auto t0 = (box.min - origin) * inverse;
+        auto t1 = (box.max - origin) * inverse;
+        auto nearest = glm::min(t0, t1);
+        auto farthest = glm::max(t0, t1);
+        auto tEnter = glm::max(glm::max(nearest.x, nearest.y), glm::max(nearest.z, 0.0f));
+        auto tExit = glm::min(glm::min(farthest.x, farthest.y), glm::min(farthest.z, limit));
+        return tEnter <= tExit ? tEnter : limit;
+    }
+
+    bool sphereReaches(const BoundingBox& box, const glm::vec4& sphere)
+    {
+        auto center = glm::vec3(sphere);
+        auto offset = glm::clamp(center, box.min, box.max) - center;
+        return glm::dot(offset, offset) <= sphere.w * sphere.w;
+    }
+
+    // Median & 99th percentile of the tree's times, mean of testing every box, in microseconds
+    struct Timings
+    {
+        std::vector<double> tree;
+        double bruteForce = 0.0;
+        size_t matches = 0;
+
+        void Print(std::ostream& out, const std::string& name)
+        {
+            std::sort(tree.begin(), tree.end());
+            out << "    " << name << ": " << tree[tree.size() / 2] << " us median, "
+                << tree[tree.size() * 99 / 100] << " us p99, every box " << bruteForce / tree.size() << " us, "
+                << matches << " of " << tree.size() << " match" << std::endl;
+        }
+    };
+
+    double microsecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Runs every query through the tree and against every box, returns whether all of them agreed
+    bool compare(std::ostream& out, const DynamicBvh& tree, const std::vector<BoundingBox>& boxes, const Queries& queries)
+    {
+        Timings frustumTimes, sphereTimes, rayTimes;
+        std::vector<GLuint> found, expected;
+
+        for (const auto& frustum : queries.frustums)
+        {
+            found.clear();
+            auto start = std::chrono::steady_clock::now();
+            tree.QueryFrustum(frustum, [&](GLuint item) { found.push_back(item); });
+            frustumTimes.tree.push_back(microsecondsSince(start));
+
+            expected.clear();
+            start = std::chrono::steady_clock::now();
+            for (GLuint item = 0; item < boxes.size(); ++item)
+            {
+                if (frustum.Intersects(boxes[item]))
+                {
+                    expected.push_back(item);
+                }
+            }
+            frustumTimes.bruteForce += microsecondsSince(start);
+            std::sort(found.begin(), found.end());
+            frustumTimes.matches += found == expected ? 1 : 0;
+        }
+
+        for (const auto& sphere : queries.spheres)
+        {
+            found.clear();
+            auto start = std::chrono::steady_clock::now();
+            tree.QuerySphere(glm::vec3(sphere), sphere.w, [&](GLuint item) { found.push_back(item); });
+            sphereTimes.tree.push_back(microsecondsSince(start));
+
+            expected.clear();
+            start = std::chrono::steady_clock::now();
+            for (GLuint item = 0; item < boxes.size(); ++item)
+            {
+                if (sphereReaches(boxes[item], sphere))
+                {
+                    expected.push_back(item);
+                }
+            }
+            sphereTimes.bruteForce += microsecondsSince(start);
+            std::sort(found.begin(), found.end());
+            sphereTimes.matches += found == expected ? 1 : 0;
+        }
+
+        // The boxes themselves are the hits, so both sides look for the nearest box entered
+        for (size_t i = 0; i < queries.rayOrigins.size(); ++i)
+        {
+            const auto& origin = queries.rayOrigins[i];
+            const auto& direction = queries.rayDirections[i];
+            auto inverse = 1.0f / direction;
+            auto start = std::chrono::steady_clock::now();
+            auto nearest = tree.QueryRay(origin, direction, RAY_LENGTH, [&](GLuint item, GLfloat tMax)
+            {
+                return enterBox(boxes[item], origin, inverse, tMax);
+            });
+            rayTimes.tree.push_back(microsecondsSince(start));
+
+            auto expectedNearest = RAY_LENGTH;
+            start = std::chrono::steady_clock::now();
+            for (const auto& box : boxes)
+            {
+                expectedNearest = std::min(expectedNearest, enterBox(box, origin, inverse, RAY_LENGTH));
+            }
+            rayTimes.bruteForce += microsecondsSince(start);
+            rayTimes.matches += nearest == expectedNearest ? 1 : 0;
+        }
+
+        frustumTimes.Print(out, "frustum");
+        sphereTimes.Print(out, "sphere");
+        rayTimes.Print(out, "ray");
+        auto count = queries.frustums.size();
+        return frustumTimes.matches == count && sphereTimes.matches == count && rayTimes.matches == count;
+    }
+}
+
+bool RunBvhBenchmark(std::ostream& out)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<GLfloat> field(-FIELD_SIZE, FIELD_SIZE);
+    std::uniform_real_distribution<GLfloat> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<GLfloat> size(0.1f, 2.0f);
+    auto randomPoint = [&]() { return glm::vec3(field(random), field(random), field(random)); };
+    auto randomDirection = [&]()
+    {
+        glm::vec3 direction;
+        do
+        {
+            direction = glm::vec3(unit(random), unit(random), unit(random));
+        } while (glm::dot(direction, direction) < 0.01f);
+        return glm::normalize(direction);
+    };
+
+    std::vector<BoundingBox> boxes(BOX_COUNT);
+    for (auto& box : boxes)
+    {
+        box.min = randomPoint();
+        box.max = box.min + glm::vec3(size(random), size(random), size(random));
+    }
+
+    Queries queries;
+    auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, FIELD_SIZE);
+    for (size_t i = 0; i < QUERY_COUNT; ++i)
+    {
+        auto eye = randomPoint();
+        queries.frustums.emplace_back(projection * glm::lookAt(eye, eye + randomDirection(), glm::vec3(0.0f, 1.0f, 0.0f)));
+        queries.spheres.emplace_back(randomPoint(), 1.0f + 9.0f * (unit(random) + 1.0f) / 2.0f);
+        queries.rayOrigins.push_back(randomPoint());
+        queries.rayDirections.push_back(randomDirection());
+    }
+
+    out << "DynamicBvh, " << BOX_COUNT << " random boxes, " << QUERY_COUNT << " queries of each kind, one thread" << std::endl;
+    DynamicBvh tree;
+    auto start = std::chrono::steady_clock::now();
+    auto leaves = tree.Build(boxes);
+    out << "  built in " << microsecondsSince(start) / 1000.0 << " ms, height " << tree.Height()
+        << ", cost " << tree.Cost() << std::endl;
+    auto allMatch = compare(out, tree, boxes, queries);
+
+    // Every other box moves by up to a few of its own sizes, refitting as it goes
+    for (size_t i = 0; i < boxes.size(); i += 2)
+    {
+        auto offset = 5.0f * glm::vec3(unit(random), unit(random), unit(random));
+        boxes[i].min += offset;
+        boxes[i].max += offset;
+        tree.Update(leaves[i], boxes[i]);
+    }
+    out << "  half the boxes moved, cost " << tree.Cost() << (tree.NeedsRebuild() ? ", needs a rebuild" : "") << std::endl;
+    allMatch = compare(out, tree, boxes, queries) && allMatch;
+
+    start = std::chrono::steady_clock::now();
+    tree.Rebuild();
+    out << "  rebuilt in " << microsecondsSince(start) / 1000.0 << " ms, cost " << tree.Cost() << std::endl;
+    allMatch = compare(out, tree, boxes, queries) && allMatch;
+
+    out << (allMatch ? "Every query matched testing every box" : "Some queries differed from testing every box") << std::endl;
+    return allMatch;
+}
@@ -0,0 +1,19 @@
+/*
+    BvhBenchmark.h
+
+    Frustum, sphere and ray query times of the DynamicBvh over random boxes,
+    each query checked against testing every box. Half the boxes are then
+    moved through Update and the queries are checked again, before and after
+    a Rebuild. Run with --benchmark-bvh, no window is opened.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_BVH_BENCHMARK_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_BVH_BENCHMARK_H_INCLUDED
+
+#include <ostream>
+
+// Returns false if any query differed from testing every box
+bool RunBvhBenchmark(std::ostream& out);
+
+#endif
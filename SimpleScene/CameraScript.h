@@ -0,0 +1,90 @@
+/*
+    CameraScript.h
+
+    A camera path given as keys in time, played back by placing the camera
+    between the two keys around the current time. Positions, angles and zoom
+    are interpolated linearly, which is smooth enough for repeatable runs.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_CAMERA_SCRIPT_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_CAMERA_SCRIPT_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+struct CameraKey
+{
+    GLfloat time; // Seconds
+    glm::vec3 position;
+    GLfloat yaw;
+    GLfloat pitch;
+    GLfloat zoom;
+};
+
+class CameraScript
+{
+public:
+    CameraScript() = default;
+    ~CameraScript() = default;
+
+    // Keys in increasing time
+    explicit CameraScript(std::vector<CameraKey> keys) : keys(std::move(keys))
+    {
+    }
+
+    // Holds the first and last key outside the script
+    void Apply(GLfloat time, Camera& camera) const
+    {
+        if (keys.empty())
+        {
+            return;
+        }
+
+        size_t next = 0;
+        while (next < keys.size() && keys[next].time <= time)
+        {
+            ++next;
+        }
+        auto key = keys[next == 0 ? 0 : next - 1];
+        if (next > 0 && next < keys.size())
+        {
+            const auto& a = keys[next - 1];
+            const auto& b = keys[next];
+            auto t = (time - a.time) / (b.time - a.time);
+            key.position = glm::mix(a.position, b.position, t);
+            key.yaw = glm::mix(a.yaw, b.yaw, t);
+            key.pitch = glm::mix(a.pitch, b.pitch, t);
+            key.zoom = glm::mix(a.zoom, b.zoom, t);
+        }
+
+        camera.SetupCamera(key.position, glm::vec3(0.0f, 1.0f, 0.0f), key.yaw, key.pitch);
+        camera.Zoom = key.zoom;
+    }
+
+    GLfloat Duration() const
+    {
+        return keys.empty() ? 0.0f : keys.back().time;
+    }
+
+    // A walk around the room from the start position, past the table and back
+    static CameraScript RoomTour(GLfloat duration)
+    {
+        return CameraScript({
+            { 0.0f, glm::vec3(0.0f, 0.0f, 3.0f), YAW, PITCH, ZOOM },
+            { duration * 0.25f, glm::vec3(1.5f, 0.8f, 2.0f), -115.0f, -20.0f, 40.0f },
+            { duration * 0.5f, glm::vec3(1.0f, 0.3f, -1.5f), -200.0f, -10.0f, 35.0f },
+            { duration * 0.75f, glm::vec3(-1.5f, 1.2f, 0.5f), -20.0f, -30.0f, 45.0f },
+            { duration, glm::vec3(0.0f, 0.0f, 3.0f), YAW, PITCH, ZOOM }
+        });
+    }
+
+private:
+    std::vector<CameraKey> keys;
+};
+
+#endif
@@ -0,0 +1,312 @@
+#include "DynamicBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+    const int SAH_BINS = 16;
+
+    glm::vec3 centroid(const BoundingBox& box)
+    {
+        return (box.min + box.max) * 0.5f;
+    }
+
+    const BoundingBox emptyBox = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+}
+
+std::vector<GLuint> DynamicBvh::Build(const std::vector<BoundingBox>& boxes)
+{
+    nodes.clear();
+    root = DYNAMIC_BVH_NULL;
+    freeList = DYNAMIC_BVH_NULL;
+    leafCount = 0;
+    innerArea = 0.0f;
+    nodes.reserve(boxes.size() * 2);
+
+    // Leaves first and unlinked, Rebuild puts the inner nodes over them
+    std::vector<GLuint> leaves;
+    leaves.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        auto leaf = allocate();
+        nodes[leaf] = { boxes[i], DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, static_cast<GLuint>(i), 0 };
+        leaves.push_back(leaf);
+    }
+    leafCount = static_cast<GLuint>(boxes.size());
+    if (!leaves.empty())
+    {
+        auto order = leaves;
+        root = build(order.data(), static_cast<GLuint>(order.size()), DYNAMIC_BVH_NULL);
+    }
+    builtCost = Cost();
+    return leaves;
+}
+
+GLuint DynamicBvh::Insert(const BoundingBox& box, GLuint item)
+{
+    auto leaf = allocate();
+    nodes[leaf] = { box, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, item, 0 };
+    ++leafCount;
+    if (root == DYNAMIC_BVH_NULL)
+    {
+        root = leaf;
+        return leaf;
+    }
+
+    // Go down while sharing a new parent with a child costs less than with this node
+    auto sibling = root;
+    while (!isLeaf(sibling))
+    {
+        const auto& node = nodes[sibling];
+        auto area = SurfaceArea(node.box);
+        auto combinedArea = SurfaceArea(Union(node.box, box));
+        auto cost = 2.0f * combinedArea;
+        auto inheritance = 2.0f * (combinedArea - area); // What every node below pays for growing this one
+
+        auto childCost = [&](GLuint child)
+        {
+            auto grown = SurfaceArea(Union(nodes[child].box, box));
+            return (isLeaf(child) ? grown : grown - SurfaceArea(nodes[child].box)) + inheritance;
+        };
+        auto leftCost = childCost(node.left);
+        auto rightCost = childCost(node.right);
+        if (cost < leftCost && cost < rightCost)
+        {
+            break;
+        }
+        sibling = leftCost < rightCost ? node.left : node.right;
+    }
+
+    auto parent = allocate();
+    auto oldParent = nodes[sibling].parent;
+    nodes[parent] = { Union(nodes[sibling].box, box), oldParent, sibling, leaf, DYNAMIC_BVH_NULL, nodes[sibling].height + 1 };
+    innerArea += SurfaceArea(nodes[parent].box);
+    if (oldParent == DYNAMIC_BVH_NULL)
+    {
+        root = parent;
+    }
+    else if (nodes[oldParent].left == sibling)
+    {
+        nodes[oldParent].left = parent;
+    }
+    else
+    {
+        nodes[oldParent].right = parent;
+    }
+    nodes[sibling].parent = parent;
+    nodes[leaf].parent = parent;
+    refit(oldParent);
+    return leaf;
+}
+
+void DynamicBvh::Remove(GLuint leaf)
+{
+    --leafCount;
+    auto parent = nodes[leaf].parent;
+    release(leaf);
+    if (parent == DYNAMIC_BVH_NULL)
+    {
+        root = DYNAMIC_BVH_NULL;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    auto sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+    auto grandparent = nodes[parent].parent;
+    innerArea -= SurfaceArea(nodes[parent].box);
+    release(parent);
+    nodes[sibling].parent = grandparent;
+    if (grandparent == DYNAMIC_BVH_NULL)
+    {
+        root = sibling;
+        return;
+    }
+    if (nodes[grandparent].left == parent)
+    {
+        nodes[grandparent].left = sibling;
+    }
+    else
+    {
+        nodes[grandparent].right = sibling;
+    }
+    refit(grandparent);
+}
+
+void DynamicBvh::Update(GLuint leaf, const BoundingBox& box)
+{
+    nodes[leaf].box = box;
+    refit(nodes[leaf].parent);
+}
+
+bool DynamicBvh::NeedsRebuild() const
+{
+    if (root == DYNAMIC_BVH_NULL || isLeaf(root))
+    {
+        return false;
+    }
+    auto rootArea = SurfaceArea(nodes[root].box);
+    return rootArea > 0.0f && innerArea / rootArea > builtCost * DYNAMIC_BVH_DEGRADATION;
+}
+
+void DynamicBvh::Rebuild()
+{
+    // Keep the leaves where they are, so handles held outside stay valid
+    std::vector<GLuint> leaves;
+    leaves.reserve(leafCount);
+    for (GLuint i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i].height == DYNAMIC_BVH_NULL)
+        {
+            continue; // Free
+        }
+        if (isLeaf(i))
+        {
+            leaves.push_back(i);
+        }
+        else
+        {
+            release(i);
+        }
+    }
+    innerArea = 0.0f;
+    root = leaves.empty() ? DYNAMIC_BVH_NULL : build(leaves.data(), static_cast<GLuint>(leaves.size()), DYNAMIC_BVH_NULL);
+    builtCost = Cost();
+}
+
+GLfloat DynamicBvh::Cost() const
+{
+    if (root == DYNAMIC_BVH_NULL || isLeaf(root))
+    {
+        return 0.0f;
+    }
+    auto rootArea = SurfaceArea(nodes[root].box);
+    return rootArea > 0.0f ? innerArea / rootArea : 0.0f;
+}
+
+GLuint DynamicBvh::allocate()
+{
+    if (freeList == DYNAMIC_BVH_NULL)
+    {
+        nodes.emplace_back();
+        return static_cast<GLuint>(nodes.size() - 1);
+    }
+    auto node = freeList;
+    freeList = nodes[node].parent;
+    return node;
+}
+
+// Free nodes are marked by a null left child and a height of DYNAMIC_BVH_NULL
+void DynamicBvh::release(GLuint node)
+{
+    nodes[node] = { emptyBox, freeList, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL, DYNAMIC_BVH_NULL };
+    freeList = node;
+}
+
+// Recomputes boxes and heights from node up to the root
+void DynamicBvh::refit(GLuint node)
+{
+    while (node != DYNAMIC_BVH_NULL)
+    {
+        auto& current = nodes[node];
+        const auto& left = nodes[current.left];
+        const auto& right = nodes[current.right];
+        auto box = Union(left.box, right.box);
+        innerArea += SurfaceArea(box) - SurfaceArea(current.box);
+        current.box = box;
+        current.height = 1 + std::max(left.height, right.height);
+        node = current.parent;
+    }
+}
+
+// Top down binned SAH over the leaves' centroids, returns the subtree's root
+GLuint DynamicBvh::build(GLuint* leaves, GLuint count, GLuint parent)
+{
+    if (count == 1)
+    {
+        nodes[leaves[0]].parent = parent;
+        return leaves[0];
+    }
+
+    auto bounds = emptyBox;
+    auto centroids = emptyBox;
+    for (GLuint i = 0; i < count; ++i)
+    {
+        const auto& box = nodes[leaves[i]].box;
+        bounds = Union(bounds, box);
+        auto center = centroid(box);
+        centroids = Union(centroids, { center, center });
+    }
+
+    auto extent = centroids.max - centroids.min;
+    auto axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    GLuint split = count / 2;
+    if (extent[axis] > 0.0f)
+    {
+        BoundingBox binBoxes[SAH_BINS];
+        GLuint binCounts[SAH_BINS] = {};
+        std::fill(binBoxes, binBoxes + SAH_BINS, emptyBox);
+        auto scale = SAH_BINS / extent[axis];
+        auto binOf = [&](GLuint leaf)
+        {
+            auto bin = static_cast<int>((centroid(nodes[leaf].box)[axis] - centroids.min[axis]) * scale);
+            return std::min(bin, SAH_BINS - 1);
+        };
+        for (GLuint i = 0; i < count; ++i)
+        {
+            auto bin = binOf(leaves[i]);
+            binBoxes[bin] = Union(binBoxes[bin], nodes[leaves[i]].box);
+            ++binCounts[bin];
+        }
+
+        // Sweep from the right, then from the left, and keep the cheapest plane
+        GLfloat rightCosts[SAH_BINS];
+        auto rightBox = emptyBox;
+        GLuint rightCount = 0;
+        for (auto i = SAH_BINS - 1; i > 0; --i)
+        {
+            rightBox = Union(rightBox, binBoxes[i]);
+            rightCount += binCounts[i];
+            rightCosts[i] = rightCount ? SurfaceArea(rightBox) * rightCount : 0.0f;
+        }
+        auto leftBox = emptyBox;
+        GLuint leftCount = 0;
+        auto bestCost = FLT_MAX;
+        auto bestBin = -1;
+        for (auto i = 0; i < SAH_BINS - 1; ++i)
+        {
+            leftBox = Union(leftBox, binBoxes[i]);
+            leftCount += binCounts[i];
+            if (leftCount == 0 || leftCount == count)
+            {
+                continue;
+            }
+            auto cost = SurfaceArea(leftBox) * leftCount + rightCosts[i + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestBin = i;
+            }
+        }
+
+        if (bestBin >= 0)
+        {
+            split = static_cast<GLuint>(std::partition(leaves, leaves + count, [&](GLuint leaf) { return binOf(leaf) <= bestBin; }) - leaves);
+        }
+        else
+        {
+            // Every centroid in one bin, split at the median instead
+            std::nth_element(leaves, leaves + split, leaves + count, [&](GLuint a, GLuint b)
+            {
+                return centroid(nodes[a].box)[axis] < centroid(nodes[b].box)[axis];
+            });
+        }
+    }
+
+    auto node = allocate();
+    auto left = build(leaves, split, node);
+    auto right = build(leaves + split, count - split, node);
+    nodes[node] = { bounds, parent, left, right, DYNAMIC_BVH_NULL, 1 + std::max(nodes[left].height, nodes[right].height) };
+    innerArea += SurfaceArea(bounds);
+    return node;
+}
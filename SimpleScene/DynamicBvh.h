@@ -0,0 +1,293 @@
+/*
+    DynamicBvh.h
+
+    Bounding volume hierarchy over scene objects, one leaf per object.
+    Leaves are inserted and removed in place and a moved object only refits
+    the boxes above it, which is cheap but lets the tree loosen over time.
+    NeedsRebuild compares the tree's surface area cost against the one after
+    the last rebuild, and Rebuild redoes the inner nodes top down with binned
+    SAH, keeping the leaf handles valid. Culling, light assignment and
+    picking all query the same tree.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_DYNAMIC_BVH_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_DYNAMIC_BVH_H_INCLUDED
+
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+#define DYNAMIC_BVH_NULL 0xFFFFFFFF
+
+// How much worse than freshly built the tree may get before NeedsRebuild says so
+#define DYNAMIC_BVH_DEGRADATION 1.5f
+
+// Deep enough for any balanced tree, degenerate ones fall back to the heap
+#define DYNAMIC_BVH_STACK_SIZE 64
+
+struct DynamicBvhNode
+{
+    BoundingBox box;
+    GLuint parent;
+    GLuint left; // DYNAMIC_BVH_NULL for leaves
+    GLuint right;
+    GLuint item; // Leaves only
+    GLuint height; // 0 for leaves
+};
+
+class DynamicBvh
+{
+public:
+    DynamicBvh() = default;
+    ~DynamicBvh() = default;
+
+    // Drops everything, then adds a leaf per box for items 0..n-1 and builds the tree over them.
+    // Leaf handles come back in the order of the boxes.
+    std::vector<GLuint> Build(const std::vector<BoundingBox>& boxes);
+
+    // Returns the leaf's handle, which stays valid until it is removed
+    GLuint Insert(const BoundingBox& box, GLuint item);
+    void Remove(GLuint leaf);
+
+    // Moves a leaf's box and refits its ancestors
+    void Update(GLuint leaf, const BoundingBox& box);
+
+    bool NeedsRebuild() const;
+    void Rebuild();
+
+    // Calls visit(item) for every leaf that may be inside the frustum
+    template <typename Visit>
+    void QueryFrustum(const Frustum& frustum, Visit visit) const;
+
+    // Calls visit(item) for every leaf whose box reaches into the sphere
+    template <typename Visit>
+    void QuerySphere(const glm::vec3& center, GLfloat radius, Visit visit) const;
+
+    // Walks the leaves along the ray nearest box first. hit(item, tMax) tests the item itself and
+    // returns the distance of a hit below tMax, or tMax if there is none, which shortens the ray.
+    // Returns the distance reached, tMax if nothing was hit.
+    template <typename Hit>
+    GLfloat QueryRay(const glm::vec3& origin, const glm::vec3& direction, GLfloat tMax, Hit hit) const;
+
+    GLuint Item(GLuint leaf) const
+    {
+        return nodes[leaf].item;
+    }
+
+    const BoundingBox& Box(GLuint leaf) const
+    {
+        return nodes[leaf].box;
+    }
+
+    GLuint LeafCount() const
+    {
+        return leafCount;
+    }
+
+    GLuint Height() const
+    {
+        return root == DYNAMIC_BVH_NULL ? 0 : nodes[root].height;
+    }
+
+    // Inner node surface area over the root's, what a random ray pays to get through the tree
+    GLfloat Cost() const;
+
+private:
+    // A stack for traversal: on the caller's stack unless the tree is unusually deep
+    class TraversalStack
+    {
+    public:
+        explicit TraversalStack(GLuint height)
+        {
+            if (height >= DYNAMIC_BVH_STACK_SIZE)
+            {
+                heap.resize(height + 1);
+                items = heap.data();
+            }
+        }
+
+        void Push(GLuint node)
+        {
+            items[size++] = node;
+        }
+
+        GLuint Pop()
+        {
+            return items[--size];
+        }
+
+        bool Empty() const
+        {
+            return size == 0;
+        }
+
+    private:
+        GLuint local[DYNAMIC_BVH_STACK_SIZE];
+        std::vector<GLuint> heap;
+        GLuint* items = local;
+        GLuint size = 0;
+    };
+
+    GLuint allocate();
+    void release(GLuint node);
+    bool isLeaf(GLuint node) const
+    {
+        return nodes[node].left == DYNAMIC_BVH_NULL;
+    }
+    void refit(GLuint node);
+    GLuint build(GLuint* leaves, GLuint count, GLuint parent);
+
+    std::vector<DynamicBvhNode> nodes;
+    GLuint root = DYNAMIC_BVH_NULL;
+    GLuint freeList = DYNAMIC_BVH_NULL; // Linked through parent
+    GLuint leafCount = 0;
+    GLfloat innerArea = 0.0f; // Kept up to date as nodes change, for NeedsRebuild
+    GLfloat builtCost = 0.0f;
+};
+
+template <typename Visit>
+void DynamicBvh::QueryFrustum(const Frustum& frustum, Visit visit) const
+{
+    if (root == DYNAMIC_BVH_NULL)
+    {
+        return;
+    }
+
+    // Subtrees fully inside are reported without testing, the second stack holds them
+    TraversalStack stack(Height());
+    stack.Push(root);
+    while (!stack.Empty())
+    {
+        auto index = stack.Pop();
+        const auto& node = nodes[index];
+        if (!frustum.Intersects(node.box))
+        {
+            continue;
+        }
+        if (isLeaf(index))
+        {
+            visit(node.item);
+            continue;
+        }
+        if (!frustum.Contains(node.box))
+        {
+            stack.Push(node.left);
+            stack.Push(node.right);
+            continue;
+        }
+
+        TraversalStack inside(node.height);
+        inside.Push(index);
+        while (!inside.Empty())
+        {
+            auto child = inside.Pop();
+            if (isLeaf(child))
+            {
+                visit(nodes[child].item);
+            }
+            else
+            {
+                inside.Push(nodes[child].left);
+                inside.Push(nodes[child].right);
+            }
+        }
+    }
+}
+
+template <typename Visit>
+void DynamicBvh::QuerySphere(const glm::vec3& center, GLfloat radius, Visit visit) const
+{
+    if (root == DYNAMIC_BVH_NULL)
+    {
+        return;
+    }
+
+    TraversalStack stack(Height());
+    stack.Push(root);
+    auto radiusSquared = radius * radius;
+    while (!stack.Empty())
+    {
+        auto index = stack.Pop();
+        const auto& node = nodes[index];
+        auto closest = glm::clamp(center, node.box.min, node.box.max);
+        auto offset = closest - center;
+        if (glm::dot(offset, offset) > radiusSquared)
+        {
+            continue;
+        }
+        if (isLeaf(index))
+        {
+            visit(node.item);
+        }
+        else
+        {
+            stack.Push(node.left);
+            stack.Push(node.right);
+        }
+    }
+}
+
+template <typename Hit>
+GLfloat DynamicBvh::QueryRay(const glm::vec3& origin, const glm::vec3& direction, GLfloat tMax, Hit hit) const
+{
+    if (root == DYNAMIC_BVH_NULL)
+    {
+        return tMax;
+    }
+
+    auto inverse = 1.0f / direction;
+    // Entry distance into a box, or tMax if the ray misses it
+    auto enter = [&](const BoundingBox& box, GLfloat limit)
+    {
+        auto t0 = (box.min - origin) * inverse;
+        auto t1 = (box.max - origin) * inverse;
+        auto nearest = glm::min(t0, t1);
+        auto farthest = glm::max(t0, t1);
+        auto tEnter = glm::max(glm::max(nearest.x, nearest.y), glm::max(nearest.z, 0.0f));
+        auto tExit = glm::min(glm::min(farthest.x, farthest.y), glm::min(farthest.z, limit));
+        return tEnter <= tExit ? tEnter : limit;
+    };
+
+    TraversalStack stack(Height());
+    stack.Push(root);
+    while (!stack.Empty())
+    {
+        auto index = stack.Pop();
+        const auto& node = nodes[index];
+        if (isLeaf(index))
+        {
+            // Checked again, an earlier hit may have cut the ray short since it was pushed
+            if (enter(node.box, tMax) < tMax)
+            {
+                tMax = glm::min(tMax, hit(node.item, tMax));
+            }
+            continue;
+        }
+
+        // Nearer child on top, so it is searched first and shortens the ray for the other
+        auto left = enter(nodes[node.left].box, tMax);
+        auto right = enter(nodes[node.right].box, tMax);
+        auto first = node.left, second = node.right;
+        if (right < left)
+        {
+            std::swap(first, second);
+            std::swap(left, right);
+        }
+        if (right < tMax)
+        {
+            stack.Push(second);
+        }
+        if (left < tMax)
+        {
+            stack.Push(first);
+        }
+    }
+    return tMax;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "DynamicResolution.h"
+
+#include <cmath>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include "FrameStats.h"
+
+namespace
+{
+    // Headroom the scale is left alone in, lower to go down than to go up so it doesn't hunt
+    const double DECREASE_BELOW = 0.95;
+    const double INCREASE_ABOVE = 1.15;
+
+    // Most the scale moves in one change
+    const float MAX_DECREASE = 0.15f;
+    const float MAX_INCREASE = 0.05f;
+
+    const double AVERAGE_WEIGHT = 0.2; // Of each new frame time
+
+    const GLfloat SHARPNESS = 0.6f;
+}
+
+bool ParseUpscaleFilter(const std::string& name, UpscaleFilter& filter)
+{
+    if (name == "bilinear")
+    {
+        filter = UpscaleFilter::Bilinear;
+        return true;
+    }
+    if (name == "sharpen")
+    {
+        filter = UpscaleFilter::Sharpen;
+        return true;
+    }
+    return false;
+}
+
+void ResolutionController::Setup(double targetMilliseconds)
+{
+    target = targetMilliseconds;
+    average = 0.0;
+    scale = 1.0f;
+    settle = 0;
+}
+
+bool ResolutionController::Update(double gpuMilliseconds)
+{
+    if (!Enabled())
+    {
+        return false;
+    }
+    if (settle > 0)
+    {
+        --settle;
+        return false;
+    }
+    average = average == 0.0 ? gpuMilliseconds : average + (gpuMilliseconds - average) * AVERAGE_WEIGHT;
+
+    auto headroom = target / average;
+    if (headroom > DECREASE_BELOW && headroom < INCREASE_ABOVE)
+    {
+        return false;
+    }
+    auto wanted = glm::clamp(scale * static_cast<float>(std::sqrt(headroom)), scale - MAX_DECREASE, scale + MAX_INCREASE);
+    wanted = glm::clamp(std::round(wanted / RESOLUTION_SCALE_STEP) * RESOLUTION_SCALE_STEP, RESOLUTION_SCALE_MIN, 1.0f);
+    if (std::abs(wanted - scale) < 0.5f * RESOLUTION_SCALE_STEP)
+    {
+        return false;
+    }
+
+    // Until frames at the new scale come in, expect the time to follow the pixel count
+    wanted > scale ? ++increases : ++decreases;
+    average *= (wanted * wanted) / (scale * scale);
+    scale = wanted;
+    settle = RESOLUTION_SETTLE_FRAMES;
+    return true;
+}
+
+UpscaleTarget::~UpscaleTarget()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void UpscaleTarget::Resize(GLsizei width, GLsizei height)
+{
+    if (width == this->width && height == this->height)
+    {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+
+    if (framebuffer == 0)
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glGenTextures(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glGenVertexArrays(1, &vao);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: The upscale framebuffer is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void UpscaleTarget::Present(const Shader& upscaleShader, UpscaleFilter filter) const
+{
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    upscaleShader.Use();
+    glUniform4f(glGetUniformLocation(upscaleShader(), "rect"), -1.0f, -1.0f, 2.0f, 2.0f);
+    glUniform1i(glGetUniformLocation(upscaleShader(), "colorTexture"), 0);
+    glUniform1f(glGetUniformLocation(upscaleShader(), "sharpness"), filter == UpscaleFilter::Sharpen ? SHARPNESS : 0.0f);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPolygonMode(GL_FRONT, polygonMode[0]);
+    glPolygonMode(GL_BACK, polygonMode[1]);
+}
@@ -0,0 +1,116 @@
+/*
+    DynamicResolution.h
+
+    Holds a view to a GPU time budget by drawing it at a fraction of the
+    window's resolution. ResolutionController turns measured GPU frame
+    times into a scale. Cost follows the pixel count, so the scale moves
+    with the square root of the headroom. It drops quickly when over
+    budget, climbs back slowly, and waits out the frames still timed at
+    the old scale. UpscaleTarget holds the scaled down frame and stretches
+    it over the window, bilinear or sharpened.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_DYNAMIC_RESOLUTION_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_DYNAMIC_RESOLUTION_H_INCLUDED
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "GpuTimer.h"
+#include "Shader.h"
+
+#define RESOLUTION_SCALE_MIN 0.5f
+#define RESOLUTION_SCALE_STEP 0.05f // Scales are kept to whole steps, so targets are only remade on a step
+#define RESOLUTION_SETTLE_FRAMES (GPU_TIMER_QUERIES + 2) // Frames still timed at the old scale after a change
+
+enum class UpscaleFilter
+{
+    Bilinear,
+    Sharpen
+};
+
+// bilinear or sharpen, as --upscale takes them
+bool ParseUpscaleFilter(const std::string& name, UpscaleFilter& filter);
+
+class ResolutionController
+{
+public:
+    // A target of 0 turns the controller off, the scale then stays at 1
+    void Setup(double targetMilliseconds);
+
+    // One frame's GPU time at the current scale, true when that changes the scale
+    bool Update(double gpuMilliseconds);
+
+    bool Enabled() const
+    {
+        return target > 0.0;
+    }
+
+    float Scale() const
+    {
+        return scale;
+    }
+
+    double TargetMilliseconds() const
+    {
+        return target;
+    }
+
+    // Smoothed GPU time, carried over a change as the new scale should bring it
+    double AverageMilliseconds() const
+    {
+        return average;
+    }
+
+    int Increases() const
+    {
+        return increases;
+    }
+
+    int Decreases() const
+    {
+        return decreases;
+    }
+
+private:
+    double target = 0.0;
+    double average = 0.0;
+    float scale = 1.0f;
+    int settle = 0;
+    int increases = 0;
+    int decreases = 0;
+};
+
+class UpscaleTarget
+{
+public:
+    UpscaleTarget() = default;
+    ~UpscaleTarget();
+
+    UpscaleTarget(const UpscaleTarget&) = delete;
+    UpscaleTarget& operator=(const UpscaleTarget&) = delete;
+
+    // Colour & depth at the scaled size, only remade when it changes
+    void Resize(GLsizei width, GLsizei height);
+
+    // What the scaled down frame is drawn or resolved into
+    GLuint Framebuffer() const
+    {
+        return framebuffer;
+    }
+
+    // Stretches the frame over the current viewport, upscaleShader is the upscale shader
+    void Present(const Shader& upscaleShader, UpscaleFilter filter) const;
+
+private:
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+    GLuint vao = 0;
+};
+
+#endif
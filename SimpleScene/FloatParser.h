@@ -0,0 +1,145 @@
+/*
+    FloatParser.h
+
+    Text to numbers for the importers. Runs of digits are found and
+    converted eight at a time in SSE2 registers, and the mantissa and
+    exponent are combined in double precision, which is exact for the short
+    decimals modelling tools write. Anything longer or unusual goes to
+    strtod. Callers keep FLOAT_PARSER_PADDING readable bytes before and after
+    the text, so blocks are loaded without checking where the buffer ends.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_FLOAT_PARSER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_FLOAT_PARSER_H_INCLUDED
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define FLOAT_PARSER_PADDING 32
+
+inline int FloatParserTrailingZeros(uint32_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// Length of the run of decimal digits at p, up to 16
+inline int DigitRunLength(const char* p)
+{
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto offset = _mm_xor_si128(_mm_sub_epi8(bytes, _mm_set1_epi8('0')), _mm_set1_epi8(static_cast<char>(0x80)));
+    auto digits = _mm_movemask_epi8(_mm_cmplt_epi8(offset, _mm_set1_epi8(static_cast<char>(0x80 + 10))));
+    return FloatParserTrailingZeros(~static_cast<uint32_t>(digits) | 0x10000u);
+}
+
+// The value of count <= 8 digits at p
+inline uint32_t ParseDigits8(const char* p, int count)
+{
+    static const char keep[16] = { 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1, -1, -1, -1, -1 };
+
+    // The 8 bytes ending at the last digit, with the ones before the first masked off
+    auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + count - 8));
+    auto mask = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(keep + count));
+    auto digits = _mm_and_si128(_mm_sub_epi8(bytes, _mm_set1_epi8('0')), mask);
+
+    // Pairs, then pairs of pairs, then the two halves
+    auto pairs = _mm_madd_epi16(_mm_unpacklo_epi8(digits, _mm_setzero_si128()), _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1));
+    auto quads = _mm_madd_epi16(_mm_packs_epi32(pairs, pairs), _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    auto high = static_cast<uint32_t>(_mm_cvtsi128_si32(quads));
+    auto low = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(quads, 4)));
+    return high * 10000 + low;
+}
+
+// The value of count <= 16 digits at p
+inline double ParseDigits16(const char* p, int count)
+{
+    if (count <= 8)
+    {
+        return ParseDigits8(p, count);
+    }
+    return ParseDigits8(p, count - 8) * 1e8 + ParseDigits8(p + count - 8, 8);
+}
+
+// Parses a float at p and returns the first character after it, or p if there is no number
+inline const char* ParseFloat(const char* p, float& value)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    auto start = p;
+    auto negative = *p == '-';
+    if (*p == '-' || *p == '+')
+    {
+        ++p;
+    }
+
+    auto integerDigits = DigitRunLength(p);
+    auto mantissa = ParseDigits16(p, integerDigits);
+    p += integerDigits;
+    auto fractionDigits = 0;
+    if (*p == '.')
+    {
+        ++p;
+        fractionDigits = DigitRunLength(p);
+        mantissa = mantissa * powers[fractionDigits] + ParseDigits16(p, fractionDigits);
+        p += fractionDigits;
+    }
+
+    auto exponent = -fractionDigits;
+    auto exact = integerDigits + fractionDigits > 0 && integerDigits < 16 && fractionDigits < 16 && integerDigits + fractionDigits <= 16;
+    if (exact && (*p == 'e' || *p == 'E'))
+    {
+        auto q = p + 1;
+        auto negativeExponent = *q == '-';
+        if (*q == '-' || *q == '+')
+        {
+            ++q;
+        }
+        auto exponentDigits = DigitRunLength(q);
+        exact = exponentDigits > 0 && exponentDigits <= 3;
+        if (exact)
+        {
+            auto written = static_cast<int>(ParseDigits8(q, exponentDigits));
+            exponent += negativeExponent ? -written : written;
+            p = q + exponentDigits;
+        }
+    }
+
+    if (!exact || exponent < -22 || exponent > 22)
+    {
+        char* end;
+        value = std::strtof(start, &end);
+        return end;
+    }
+    auto result = exponent < 0 ? mantissa / powers[-exponent] : mantissa * powers[exponent];
+    value = static_cast<float>(negative ? -result : result);
+    return p;
+}
+
+// Parses a decimal integer at p and returns the first character after it, or p if there is none
+inline const char* ParseInt(const char* p, int64_t& value)
+{
+    auto negative = *p == '-';
+    auto digits = p + (*p == '-' || *p == '+' ? 1 : 0);
+    auto count = DigitRunLength(digits);
+    if (count == 0)
+    {
+        return p;
+    }
+    auto result = static_cast<int64_t>(ParseDigits16(digits, count));
+    value = negative ? -result : result;
+    return digits + count;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    FrameData.h
+
+    Per-frame uniform blocks, written into a StreamBuffer once per frame and
+    bound with glBindBufferRange. Each vec3 is paired with a float so the
+    structs match the std140 layout of the shaders byte for byte.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_FRAME_DATA_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_FRAME_DATA_H_INCLUDED
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Must match the Camera and Lights blocks in the shaders
+#define CAMERA_BLOCK_NAME "Camera"
+#define CAMERA_BLOCK_BINDING 1
+#define LIGHT_BLOCK_NAME "Lights"
+#define LIGHT_BLOCK_BINDING 2
+#define MAX_POINT_LIGHTS 2
+#define MAX_DISCO_LIGHTS 4
+
+// Multi-view shaders hold this many of each block, one per view. GL guarantees at least 16 viewports
+#define MAX_VIEWS 16
+
+struct CameraBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    GLfloat padding;
+};
+
+struct PointLightBlock
+{
+    glm::vec3 position;
+    GLfloat constant;
+    glm::vec3 ambient;
+    GLfloat linear;
+    glm::vec3 diffuse;
+    GLfloat quadratic;
+    glm::vec3 specular;
+    GLfloat padding;
+};
+
+// cutOff and outerCutOff are cosines
+struct SpotLightBlock
+{
+    glm::vec3 position;
+    GLfloat constant;
+    glm::vec3 direction;
+    GLfloat linear;
+    glm::vec3 ambient;
+    GLfloat quadratic;
+    glm::vec3 diffuse;
+    GLfloat cutOff;
+    glm::vec3 specular;
+    GLfloat outerCutOff;
+};
+
+struct LightBlock
+{
+    PointLightBlock pointLights[MAX_POINT_LIGHTS];
+    SpotLightBlock spotLight;
+    SpotLightBlock discoLights[MAX_DISCO_LIGHTS];
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must follow std140");
+static_assert(sizeof(PointLightBlock) == 64, "PointLightBlock must follow std140");
+static_assert(sizeof(SpotLightBlock) == 80, "SpotLightBlock must follow std140");
+
+#endif
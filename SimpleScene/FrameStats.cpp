@@ -0,0 +1,135 @@
+#include "FrameStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <GL/glew.h>
+
+#include "GlHooks.h"
+
+namespace
+{
+    std::atomic<bool> enabled(false);
+    uint64_t drawCalls = 0;
+    uint64_t glCalls = 0;
+    uint64_t uniformUploads = 0;
+    std::atomic<uint64_t> allocations(0); // The CPU renderers allocate on every thread
+
+    template <typename Proc>
+    struct GlHook;
+
+    // One instance per GLEW pointer, keeping the driver's entry point it replaced
+    template <typename R, typename... Args>
+    struct GlHook<R (GLAPIENTRY*)(Args...)>
+    {
+        using Proc = R (GLAPIENTRY*)(Args...);
+
+        template <Proc* Slot, GlCall Call>
+        struct Entry
+        {
+            static Proc& Original()
+            {
+                static Proc original = nullptr;
+                return original;
+            }
+
+            static R GLAPIENTRY Counted(Args... args)
+            {
+                CountGlCall(Call);
+                return Original()(args...);
+            }
+
+            static void Install()
+            {
+                // Missing entry points stay missing, so extension checks still see them
+                if (*Slot && *Slot != &Counted)
+                {
+                    Original() = *Slot;
+                    *Slot = &Counted;
+                }
+            }
+        };
+    };
+
+#define HOOK_GL(name, call) GlHook<decltype(__glew##name)>::Entry<&__glew##name, GlCall::call>::Install();
+}
+
+void EnableFrameStats()
+{
+    GL_HOOKS(HOOK_GL)
+
+    enabled = true;
+}
+
+bool FrameStatsEnabled()
+{
+    return enabled;
+}
+
+void CountGlCall(GlCall call)
+{
+    if (!enabled)
+    {
+        return;
+    }
+    ++glCalls;
+    if (call == GlCall::Draw)
+    {
+        ++drawCalls;
+    }
+    else if (call == GlCall::UniformUpload)
+    {
+        ++uniformUploads;
+    }
+}
+
+FrameCounters ReadFrameCounters()
+{
+    FrameCounters counters;
+    counters.drawCalls = drawCalls;
+    counters.glCalls = glCalls;
+    counters.uniformUploads = uniformUploads;
+    counters.allocations = allocations.load(std::memory_order_relaxed);
+    return counters;
+}
+
+// Every other form of operator new ends up in one of these two
+void* operator new(size_t size)
+{
+    if (enabled.load(std::memory_order_relaxed))
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+// C++14 calls these when it knows the size, they'd otherwise free with the library's own delete
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
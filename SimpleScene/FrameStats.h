@@ -0,0 +1,54 @@
+/*
+    FrameStats.h
+
+    Running counts of what a frame costs beyond its time: draw calls, GL
+    calls, uniform uploads and heap allocations. GL calls are counted by
+    swapping GLEW's function pointers for counting ones. Only the entry points
+    listed in GlHooks.h are swapped, and the build fails if the tree calls
+    one past GL 1.1 that isn't listed. The few 1.1 draws are counted where
+    they are made. Allocations are counted in the global operator new.
+    Nothing is counted until EnableFrameStats is called.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_FRAME_STATS_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_FRAME_STATS_H_INCLUDED
+
+#include <cstdint>
+
+struct FrameCounters
+{
+    uint64_t drawCalls = 0;
+    uint64_t glCalls = 0; // Draws & uniform uploads included
+    uint64_t uniformUploads = 0; // glUniform* and uniform buffer ranges bound
+    uint64_t allocations = 0;
+
+    FrameCounters operator-(const FrameCounters& other) const
+    {
+        FrameCounters difference;
+        difference.drawCalls = drawCalls - other.drawCalls;
+        difference.glCalls = glCalls - other.glCalls;
+        difference.uniformUploads = uniformUploads - other.uniformUploads;
+        difference.allocations = allocations - other.allocations;
+        return difference;
+    }
+};
+
+enum class GlCall
+{
+    Draw,
+    UniformUpload,
+    Other
+};
+
+// Installs the counting GL entry points, needs glewInit to have run
+void EnableFrameStats();
+bool FrameStatsEnabled();
+
+// For entry points GLEW doesn't load
+void CountGlCall(GlCall call);
+
+// Totals since EnableFrameStats, a frame's cost is the difference of two reads
+FrameCounters ReadFrameCounters();
+
+#endif
@@ -0,0 +1,48 @@
+/*
+    FrameTimer.h
+
+    Wall clock time per frame averaged over a fixed number of frames, used
+    to compare the render backends.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_FRAME_TIMER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_FRAME_TIMER_H_INCLUDED
+
+#include <chrono>
+
+class FrameTimer
+{
+public:
+    explicit FrameTimer(int interval = 120)
+        : interval(interval)
+    {
+    }
+
+    void Begin()
+    {
+        start = std::chrono::steady_clock::now();
+    }
+
+    // True once every interval frames, with the average over them in milliseconds
+    bool End(double& averageMilliseconds)
+    {
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (++frames < interval)
+        {
+            return false;
+        }
+        averageMilliseconds = total / frames;
+        total = 0.0;
+        frames = 0;
+        return true;
+    }
+
+private:
+    int interval;
+    int frames = 0;
+    double total = 0.0;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
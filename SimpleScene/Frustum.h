@@ -0,0 +1,105 @@
+/*
+    Frustum.h
+
+    The six planes of a view volume, taken from its view-projection matrix,
+    with the sphere and box tests the culling queries use.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_FRUSTUM_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_FRUSTUM_H_INCLUDED
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Axis aligned box in world space
+struct BoundingBox
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+inline BoundingBox Union(const BoundingBox& a, const BoundingBox& b)
+{
+    return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+inline GLfloat SurfaceArea(const BoundingBox& box)
+{
+    auto size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+inline bool Contains(const BoundingBox& outer, const BoundingBox& inner)
+{
+    return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+}
+
+class Frustum
+{
+public:
+    Frustum() = default;
+    ~Frustum() = default;
+
+    // Planes point inwards: left, right, bottom, top, near, far
+    explicit Frustum(const glm::mat4& viewProjection)
+    {
+        auto rows = glm::transpose(viewProjection);
+        planes[0] = rows[3] + rows[0];
+        planes[1] = rows[3] - rows[0];
+        planes[2] = rows[3] + rows[1];
+        planes[3] = rows[3] - rows[1];
+        planes[4] = rows[3] + rows[2];
+        planes[5] = rows[3] - rows[2];
+        for (auto& plane : planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    bool Intersects(const glm::vec3& center, GLfloat radius) const
+    {
+        for (const auto& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Conservative: boxes near a corner outside two planes at once can still pass
+    bool Intersects(const BoundingBox& box) const
+    {
+        for (const auto& plane : planes)
+        {
+            // The corner furthest along the plane's normal
+            auto corner = glm::mix(box.min, box.max, glm::greaterThan(glm::vec3(plane), glm::vec3(0.0f)));
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True when the box is inside every plane, so nothing under it needs testing
+    bool Contains(const BoundingBox& box) const
+    {
+        for (const auto& plane : planes)
+        {
+            auto corner = glm::mix(box.max, box.min, glm::greaterThan(glm::vec3(plane), glm::vec3(0.0f)));
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 planes[6];
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <cstddef>
+
+GeometryPool::~GeometryPool()
+{
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GeometryPool::Setup(GLuint vertexCapacity, GLuint indexCapacity)
+{
+    glGenVertexArrays(1, &vao);
+    resize(vertexCapacity, indexCapacity, false);
+}
+
+MeshHandle GeometryPool::Add(const MeshData& mesh)
+{
+    return Add(mesh.vertices.data(), static_cast<GLuint>(mesh.vertices.size()), mesh.indices.data(), static_cast<GLuint>(mesh.indices.size()));
+}
+
+MeshHandle GeometryPool::Add(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount)
+{
+    if (vertexAllocator.LargestFreeBlock() < vertexCount || indexAllocator.LargestFreeBlock() < indexCount)
+    {
+        if (vertexAllocator.FreeSize() >= vertexCount && indexAllocator.FreeSize() >= indexCount)
+        {
+            Defragment();
+        }
+        else
+        {
+            grow(std::max(vertexAllocator.Capacity() * 2, vertexAllocator.Capacity() + vertexCount),
+                 std::max(indexAllocator.Capacity() * 2, indexAllocator.Capacity() + indexCount));
+        }
+    }
+
+    auto baseVertex = vertexAllocator.Allocate(vertexCount);
+    auto firstIndex = indexAllocator.Allocate(indexCount);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(Vertex), vertexCount * sizeof(Vertex), vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(GLuint), indexCount * sizeof(GLuint), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    MeshRange range = { firstIndex, indexCount, static_cast<GLint>(baseVertex), vertexCount };
+    if (!freeHandles.empty())
+    {
+        auto handle = freeHandles.back();
+        freeHandles.pop_back();
+        ranges[handle] = range;
+        live[handle] = true;
+        return handle;
+    }
+    ranges.push_back(range);
+    live.push_back(true);
+    return static_cast<MeshHandle>(ranges.size() - 1);
+}
+
+void GeometryPool::Remove(MeshHandle mesh)
+{
+    if (mesh >= ranges.size() || !live[mesh])
+    {
+        return;
+    }
+
+    vertexAllocator.Free(static_cast<GLuint>(ranges[mesh].baseVertex), ranges[mesh].vertexCount);
+    indexAllocator.Free(ranges[mesh].firstIndex, ranges[mesh].indexCount);
+    ranges[mesh] = { 0, 0, 0, 0 };
+    live[mesh] = false;
+    freeHandles.push_back(mesh);
+}
+
+void GeometryPool::Defragment()
+{
+    resize(vertexAllocator.Capacity(), indexAllocator.Capacity(), true);
+}
+
+void GeometryPool::Bind(GLuint drawBuffer, GLuint instancesPerDraw) const
+{
+    glBindVertexArray(vao);
+    if (drawBuffer == boundDrawBuffer && instancesPerDraw == boundDivisor)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+    for (auto column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(DRAW_MODEL_ATTRIBUTE + column);
+        glVertexAttribPointer(DRAW_MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(DrawData),
+            reinterpret_cast<void*>(offsetof(DrawData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(DRAW_MODEL_ATTRIBUTE + column, instancesPerDraw);
+    }
+    glEnableVertexAttribArray(DRAW_MATERIAL_ATTRIBUTE);
+    glVertexAttribIPointer(DRAW_MATERIAL_ATTRIBUTE, 1, GL_INT, sizeof(DrawData), reinterpret_cast<void*>(offsetof(DrawData, material)));
+    glVertexAttribDivisor(DRAW_MATERIAL_ATTRIBUTE, instancesPerDraw);
+    glEnableVertexAttribArray(DRAW_BAKE_ATTRIBUTE);
+    glVertexAttribIPointer(DRAW_BAKE_ATTRIBUTE, 1, GL_INT, sizeof(DrawData), reinterpret_cast<void*>(offsetof(DrawData, bakeBase)));
+    glVertexAttribDivisor(DRAW_BAKE_ATTRIBUTE, instancesPerDraw);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    boundDrawBuffer = drawBuffer;
+    boundDivisor = instancesPerDraw;
+}
+
+// Moves the contents into new buffers. With compact set, live meshes are packed
+// to the front in order, otherwise the buffers start out empty.
+void GeometryPool::resize(GLuint vertexCapacity, GLuint indexCapacity, bool compact)
+{
+    GLuint newBuffers[2];
+    glGenBuffers(2, newBuffers);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+    vertexAllocator.Reset(vertexCapacity);
+    indexAllocator.Reset(indexCapacity);
+    if (compact)
+    {
+        for (size_t mesh = 0; mesh < ranges.size(); ++mesh)
+        {
+            if (!live[mesh])
+            {
+                continue;
+            }
+
+            auto& range = ranges[mesh];
+            auto baseVertex = vertexAllocator.Allocate(range.vertexCount);
+            auto firstIndex = indexAllocator.Allocate(range.indexCount);
+
+            glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[0]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                range.baseVertex * sizeof(Vertex), baseVertex * sizeof(Vertex), range.vertexCount * sizeof(Vertex));
+            glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[1]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                range.firstIndex * sizeof(GLuint), firstIndex * sizeof(GLuint), range.indexCount * sizeof(GLuint));
+
+            range.baseVertex = static_cast<GLint>(baseVertex);
+            range.firstIndex = firstIndex;
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    replaceBuffers(newBuffers);
+    ++generation;
+}
+
+// Copies the buffers whole into bigger ones and adds the room at the end, every mesh stays where it is
+void GeometryPool::grow(GLuint vertexCapacity, GLuint indexCapacity)
+{
+    GLuint newBuffers[2];
+    glGenBuffers(2, newBuffers);
+    glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexAllocator.Capacity() * sizeof(Vertex));
+    glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexAllocator.Capacity() * sizeof(GLuint));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    vertexAllocator.Grow(vertexCapacity);
+    indexAllocator.Grow(indexCapacity);
+    replaceBuffers(newBuffers);
+}
+
+// Deletes the current buffers and points the VAO at newBuffers, vertices then indices
+void GeometryPool::replaceBuffers(const GLuint newBuffers[2])
+{
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    vertexBuffer = newBuffers[0];
+    indexBuffer = newBuffers[1];
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, normal)));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
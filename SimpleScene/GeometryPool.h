@@ -0,0 +1,94 @@
+/*
+    GeometryPool.h
+
+    One large vertex buffer and one large index buffer shared by every mesh,
+    with a single VAO for all draws. Meshes are sub-allocated from the buffers
+    and can be added and removed at runtime.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_GEOMETRY_POOL_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_GEOMETRY_POOL_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Mesh.h"
+#include "RangeAllocator.h"
+
+#define DRAW_MODEL_ATTRIBUTE 2 // Takes locations 2 to 5
+#define DRAW_MATERIAL_ATTRIBUTE 6
+#define DRAW_BAKE_ATTRIBUTE 7
+
+typedef GLuint MeshHandle;
+
+// Where a mesh lives in the pool, in vertices and indices
+struct MeshRange
+{
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLint baseVertex;
+    GLuint vertexCount;
+};
+
+// Per-draw data, read as instanced attributes
+struct DrawData
+{
+    glm::mat4 model;
+    GLint material;
+    GLint bakeBase; // Added to gl_VertexID to find a vertex's baked lighting, -1 without any
+};
+
+class GeometryPool
+{
+public:
+    GeometryPool() = default;
+    ~GeometryPool();
+
+    // Capacities are initial sizes, the pool grows when it runs out
+    void Setup(GLuint vertexCapacity, GLuint indexCapacity);
+
+    MeshHandle Add(const MeshData& mesh);
+
+    // Same, from vertices & indices that live elsewhere, such as a mapped AssetPack
+    MeshHandle Add(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount);
+    void Remove(MeshHandle mesh);
+
+    // Moves every mesh to the front of the buffers, closing the gaps left by Remove
+    void Defragment();
+
+    const MeshRange& Range(MeshHandle mesh) const
+    {
+        return ranges[mesh];
+    }
+
+    // Changes whenever meshes move, so draw commands built from Range() know to refresh
+    GLuint Generation() const
+    {
+        return generation;
+    }
+
+    // Binds the shared VAO with its per-draw attributes sourced from drawBuffer.
+    // The attributes step once every instancesPerDraw instances, one instance per view when drawing several
+    void Bind(GLuint drawBuffer, GLuint instancesPerDraw = 1) const;
+
+private:
+    void resize(GLuint vertexCapacity, GLuint indexCapacity, bool compact);
+    void grow(GLuint vertexCapacity, GLuint indexCapacity);
+    void replaceBuffers(const GLuint newBuffers[2]);
+
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    mutable GLuint boundDrawBuffer = 0;
+    mutable GLuint boundDivisor = 1;
+    RangeAllocator vertexAllocator;
+    RangeAllocator indexAllocator;
+    std::vector<MeshRange> ranges;
+    std::vector<bool> live;
+    std::vector<MeshHandle> freeHandles;
+    GLuint generation = 0;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+    GlHooks.h
+
+    Every GL entry point past 1.1 the tree calls, and what FrameStats counts
+    each one as. This header is force-included ahead of every source file.
+    After GLEW's header has defined glXxx as GLEW_GET_FUN(__glewXxx),
+    GLEW_GET_FUN is replaced by GlHooked. GlHooked fails to compile for an
+    entry point missing from GL_HOOKS, so a new call can't go uncounted.
+    GL 1.1 functions aren't GLEW pointers; their draws are counted by hand.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_GL_HOOKS_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_GL_HOOKS_H_INCLUDED
+
+#include <type_traits>
+
+#include <GL/glew.h>
+
+// HOOK(name, call) per entry point, name without its gl prefix, call a GlCall
+#define GL_HOOKS(HOOK) \
+    HOOK(MultiDrawElementsIndirect, Draw) \
+    HOOK(DrawElementsInstancedBaseVertexBaseInstance, Draw) \
+    HOOK(DrawElementsBaseVertex, Draw) \
+    HOOK(DrawElementsInstancedBaseVertex, Draw) \
+    HOOK(DrawElementsInstanced, Draw) \
+    HOOK(DrawArraysInstanced, Draw) \
+    HOOK(DrawRangeElements, Draw) \
+    HOOK(Uniform1i, UniformUpload) \
+    HOOK(Uniform1f, UniformUpload) \
+    HOOK(Uniform3f, UniformUpload) \
+    HOOK(Uniform4f, UniformUpload) \
+    HOOK(Uniform3fv, UniformUpload) \
+    HOOK(Uniform4fv, UniformUpload) \
+    HOOK(UniformMatrix4fv, UniformUpload) \
+    HOOK(BindBufferRange, UniformUpload) \
+    HOOK(BindBufferBase, UniformUpload) \
+    HOOK(ActiveTexture, Other) \
+    HOOK(AttachShader, Other) \
+    HOOK(BeginQuery, Other) \
+    HOOK(BeginTransformFeedback, Other) \
+    HOOK(BindBuffer, Other) \
+    HOOK(BindFramebuffer, Other) \
+    HOOK(BindRenderbuffer, Other) \
+    HOOK(BindVertexArray, Other) \
+    HOOK(BlendFuncSeparate, Other) \
+    HOOK(BlitFramebuffer, Other) \
+    HOOK(BufferData, Other) \
+    HOOK(BufferStorage, Other) \
+    HOOK(BufferSubData, Other) \
+    HOOK(CheckFramebufferStatus, Other) \
+    HOOK(ClientWaitSync, Other) \
+    HOOK(CompileShader, Other) \
+    HOOK(CopyBufferSubData, Other) \
+    HOOK(CreateProgram, Other) \
+    HOOK(CreateShader, Other) \
+    HOOK(DeleteBuffers, Other) \
+    HOOK(DeleteFramebuffers, Other) \
+    HOOK(DeleteQueries, Other) \
+    HOOK(DeleteRenderbuffers, Other) \
+    HOOK(DeleteShader, Other) \
+    HOOK(DeleteSync, Other) \
+    HOOK(DeleteVertexArrays, Other) \
+    HOOK(DisableVertexAttribArray, Other) \
+    HOOK(EnableVertexAttribArray, Other) \
+    HOOK(EndQuery, Other) \
+    HOOK(EndTransformFeedback, Other) \
+    HOOK(FenceSync, Other) \
+    HOOK(FramebufferRenderbuffer, Other) \
+    HOOK(FramebufferTexture2D, Other) \
+    HOOK(GenBuffers, Other) \
+    HOOK(GenFramebuffers, Other) \
+    HOOK(GenQueries, Other) \
+    HOOK(GenRenderbuffers, Other) \
+    HOOK(GenVertexArrays, Other) \
+    HOOK(GetBufferSubData, Other) \
+    HOOK(GetProgramInfoLog, Other) \
+    HOOK(GetProgramiv, Other) \
+    HOOK(GetQueryObjectiv, Other) \
+    HOOK(GetQueryObjectui64v, Other) \
+    HOOK(GetQueryObjectuiv, Other) \
+    HOOK(GetShaderInfoLog, Other) \
+    HOOK(GetShaderiv, Other) \
+    HOOK(GetUniformBlockIndex, Other) \
+    HOOK(GetUniformLocation, Other) \
+    HOOK(LinkProgram, Other) \
+    HOOK(MapBufferRange, Other) \
+    HOOK(QueryCounter, Other) \
+    HOOK(RenderbufferStorage, Other) \
+    HOOK(RenderbufferStorageMultisample, Other) \
+    HOOK(ShaderSource, Other) \
+    HOOK(TexBuffer, Other) \
+    HOOK(TransformFeedbackVaryings, Other) \
+    HOOK(UniformBlockBinding, Other) \
+    HOOK(UnmapBuffer, Other) \
+    HOOK(UseProgram, Other) \
+    HOOK(VertexAttrib4fv, Other) \
+    HOOK(VertexAttribDivisor, Other) \
+    HOOK(VertexAttribI1i, Other) \
+    HOOK(VertexAttribIPointer, Other) \
+    HOOK(VertexAttribPointer, Other) \
+    HOOK(ViewportArrayv, Other)
+
+template <typename Proc, Proc* Slot>
+struct GlHookListed : std::false_type
+{
+};
+
+#define GL_HOOK_LISTED(name, call) \
+    template <> \
+    struct GlHookListed<decltype(__glew##name), &__glew##name> : std::true_type \
+    { \
+    };
+GL_HOOKS(GL_HOOK_LISTED)
+#undef GL_HOOK_LISTED
+
+template <typename Proc, Proc* Slot>
+inline Proc GlHooked()
+{
+    static_assert(GlHookListed<Proc, Slot>::value, "This GL entry point isn't counted, add it to GL_HOOKS");
+    return *Slot;
+}
+
+#undef GLEW_GET_FUN
+#define GLEW_GET_FUN(x) GlHooked<decltype(x), &x>()
+
+#endif
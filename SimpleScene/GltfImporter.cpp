@@ -0,0 +1,560 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FloatParser.h"
+#include "Json.h"
+
+namespace
+{
+    const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    const int COMPONENT_UNSIGNED_BYTE = 5121;
+    const int COMPONENT_UNSIGNED_SHORT = 5123;
+    const int COMPONENT_UNSIGNED_INT = 5125;
+    const int COMPONENT_FLOAT = 5126;
+
+    const int MODE_TRIANGLES = 4;
+    const int MODE_TRIANGLE_STRIP = 5;
+    const int MODE_TRIANGLE_FAN = 6;
+
+    // glTF says a primitive without a material is drawn in this
+    const Material defaultMaterial(glm::vec3(0.2f), glm::vec3(1.0f), glm::vec3(0.04f), 1.0f);
+
+    struct BufferData
+    {
+        const unsigned char* data;
+        size_t size;
+    };
+
+    // Where an accessor's elements are, already checked to lie inside their buffer
+    struct AccessorView
+    {
+        const unsigned char* data;
+        size_t count;
+        size_t stride;
+        int componentType;
+    };
+
+    struct Primitive
+    {
+        const JsonValue* json;
+        GLuint material;
+    };
+
+    uint32_t readU32(const char* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    bool decodeBase64(const char* p, const char* end, std::vector<unsigned char>& bytes)
+    {
+        static signed char table[256];
+        static bool tableReady = false;
+        if (!tableReady)
+        {
+            std::memset(table, -1, sizeof(table));
+            const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (auto i = 0; i < 64; ++i)
+            {
+                table[static_cast<unsigned char>(alphabet[i])] = static_cast<signed char>(i);
+            }
+            tableReady = true;
+        }
+
+        bytes.clear();
+        bytes.reserve((end - p) / 4 * 3);
+        uint32_t bits = 0;
+        auto bitCount = 0;
+        for (; p < end && *p != '='; ++p)
+        {
+            auto value = table[static_cast<unsigned char>(*p)];
+            if (value < 0)
+            {
+                return false;
+            }
+            bits = bits << 6 | static_cast<uint32_t>(value);
+            bitCount += 6;
+            if (bitCount >= 8)
+            {
+                bitCount -= 8;
+                bytes.push_back(static_cast<unsigned char>(bits >> bitCount));
+            }
+        }
+        return true;
+    }
+
+    std::string directoryOf(const std::string& path)
+    {
+        auto slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    int componentSize(int componentType)
+    {
+        switch (componentType)
+        {
+        case 5120:
+        case COMPONENT_UNSIGNED_BYTE: return 1;
+        case 5122:
+        case COMPONENT_UNSIGNED_SHORT: return 2;
+        case COMPONENT_UNSIGNED_INT:
+        case COMPONENT_FLOAT: return 4;
+        default: return 0;
+        }
+    }
+
+    int componentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    bool viewAccessor(const JsonValue& document, const std::vector<BufferData>& buffers, int index,
+                      AccessorView& view, std::string& error)
+    {
+        const auto& accessor = document["accessors"][index];
+        if (accessor.IsNull())
+        {
+            error = "missing accessor " + std::to_string(index);
+            return false;
+        }
+        if (!accessor["sparse"].IsNull() || accessor["bufferView"].IsNull())
+        {
+            error = "sparse accessors are not supported";
+            return false;
+        }
+
+        const auto& bufferView = document["bufferViews"][accessor["bufferView"].Int(-1)];
+        auto buffer = bufferView["buffer"].Int(-1);
+        if (bufferView.IsNull() || buffer < 0 || buffer >= static_cast<int>(buffers.size()))
+        {
+            error = "accessor " + std::to_string(index) + " has a bad buffer view";
+            return false;
+        }
+
+        view.componentType = accessor["componentType"].Int();
+        auto elementSize = static_cast<size_t>(componentSize(view.componentType) * componentCount(accessor["type"].String()));
+        view.count = static_cast<size_t>(accessor["count"].Number());
+        view.stride = static_cast<size_t>(bufferView["byteStride"].Number(static_cast<double>(elementSize)));
+        auto viewOffset = static_cast<size_t>(bufferView["byteOffset"].Number());
+        auto viewLength = static_cast<size_t>(bufferView["byteLength"].Number());
+        auto offset = static_cast<size_t>(accessor["byteOffset"].Number());
+        if (elementSize == 0 || viewOffset + viewLength > buffers[buffer].size ||
+            (view.count > 0 && offset + view.stride * (view.count - 1) + elementSize > viewLength))
+        {
+            error = "accessor " + std::to_string(index) + " runs outside its buffer";
+            return false;
+        }
+        view.data = buffers[buffer].data + viewOffset + offset;
+        return true;
+    }
+
+    // Loads every buffer: the GLB binary chunk, a base64 data URI or a file next to the model
+    bool loadBuffers(const JsonValue& document, const std::string& path, const BufferData& binaryChunk,
+                     std::vector<std::vector<unsigned char>>& storage, std::vector<BufferData>& buffers, std::string& error)
+    {
+        const auto& list = document["buffers"];
+        storage.resize(list.Size());
+        for (size_t i = 0; i < list.Size(); ++i)
+        {
+            const auto& uri = list[i]["uri"].String();
+            auto size = static_cast<size_t>(list[i]["byteLength"].Number());
+            BufferData buffer = {};
+            if (uri.empty())
+            {
+                buffer = binaryChunk;
+            }
+            else if (uri.compare(0, 5, "data:") == 0)
+            {
+                auto comma = uri.find(',');
+                if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos ||
+                    !decodeBase64(uri.data() + comma + 1, uri.data() + uri.size(), storage[i]))
+                {
+                    error = "buffer " + std::to_string(i) + " has a bad data URI";
+                    return false;
+                }
+                buffer = { storage[i].data(), storage[i].size() };
+            }
+            else
+            {
+                std::vector<char> file;
+                size_t fileSize;
+                if (!ReadPaddedFile(directoryOf(path) + uri, file, fileSize, error))
+                {
+                    return false;
+                }
+                auto start = reinterpret_cast<unsigned char*>(file.data()) + FLOAT_PARSER_PADDING;
+                storage[i].assign(start, start + fileSize);
+                buffer = { storage[i].data(), storage[i].size() };
+            }
+
+            if (buffer.size < size)
+            {
+                error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+                return false;
+            }
+            buffers.push_back(buffer);
+        }
+        return true;
+    }
+
+    // Phong from metallic-roughness: metals keep half their base colour as diffuse, there are no
+    // reflections here to carry the rest, and roughness maps to the equivalent Blinn exponent
+    Material convertMaterial(const JsonValue& material)
+    {
+        const auto& pbr = material["pbrMetallicRoughness"];
+        const auto& factor = pbr["baseColorFactor"];
+        glm::vec3 base(factor[0].Number(1.0), factor[1].Number(1.0), factor[2].Number(1.0));
+        auto metallic = static_cast<float>(pbr["metallicFactor"].Number(1.0));
+        auto roughness = static_cast<float>(pbr["roughnessFactor"].Number(1.0));
+        auto alpha = glm::max(roughness * roughness, 1e-3f);
+        auto shininess = glm::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 256.0f);
+        return Material(base * 0.2f, base * (1.0f - 0.5f * metallic), glm::mix(glm::vec3(0.04f), base, metallic), shininess);
+    }
+
+    bool readIndex(const AccessorView& view, size_t i, GLuint& index)
+    {
+        auto p = view.data + view.stride * i;
+        switch (view.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+            index = *p;
+            return true;
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            std::memcpy(&value, p, sizeof(value));
+            index = value;
+            return true;
+        }
+        case COMPONENT_UNSIGNED_INT:
+            std::memcpy(&index, p, sizeof(index));
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool buildPrimitive(const JsonValue& document, const std::vector<BufferData>& buffers, const JsonValue& primitive,
+                        MeshData& mesh, std::string& error)
+    {
+        const auto& attributes = primitive["attributes"];
+        AccessorView positions;
+        if (attributes["POSITION"].IsNull())
+        {
+            error = "primitive without positions";
+            return false;
+        }
+        if (!viewAccessor(document, buffers, attributes["POSITION"].Int(), positions, error))
+        {
+            return false;
+        }
+        if (positions.componentType != COMPONENT_FLOAT)
+        {
+            error = "positions must be floats";
+            return false;
+        }
+
+        AccessorView normals = {};
+        auto hasNormals = !attributes["NORMAL"].IsNull();
+        if (hasNormals && !viewAccessor(document, buffers, attributes["NORMAL"].Int(), normals, error))
+        {
+            return false;
+        }
+        if (hasNormals && (normals.componentType != COMPONENT_FLOAT || normals.count != positions.count))
+        {
+            error = "normals must be floats, one per position";
+            return false;
+        }
+
+        mesh.vertices.resize(positions.count);
+        for (size_t i = 0; i < positions.count; ++i)
+        {
+            std::memcpy(&mesh.vertices[i].position, positions.data + positions.stride * i, sizeof(glm::vec3));
+            if (hasNormals)
+            {
+                std::memcpy(&mesh.vertices[i].normal, normals.data + normals.stride * i, sizeof(glm::vec3));
+            }
+        }
+
+        // Indices as written, or every vertex in order
+        std::vector<GLuint> order;
+        if (primitive["indices"].IsNull())
+        {
+            order.resize(positions.count);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = static_cast<GLuint>(i);
+            }
+        }
+        else
+        {
+            AccessorView indices;
+            if (!viewAccessor(document, buffers, primitive["indices"].Int(), indices, error))
+            {
+                return false;
+            }
+            order.resize(indices.count);
+            for (size_t i = 0; i < indices.count; ++i)
+            {
+                if (!readIndex(indices, i, order[i]) || order[i] >= positions.count)
+                {
+                    error = "bad index";
+                    return false;
+                }
+            }
+        }
+
+        switch (primitive["mode"].Int(MODE_TRIANGLES))
+        {
+        case MODE_TRIANGLES:
+            order.resize(order.size() / 3 * 3);
+            mesh.indices = std::move(order);
+            break;
+        case MODE_TRIANGLE_STRIP:
+            for (size_t i = 2; i < order.size(); ++i)
+            {
+                // Every other triangle is wound the other way
+                auto odd = i % 2 == 1;
+                mesh.indices.push_back(order[i - 2]);
+                mesh.indices.push_back(order[odd ? i : i - 1]);
+                mesh.indices.push_back(order[odd ? i - 1 : i]);
+            }
+            break;
+        case MODE_TRIANGLE_FAN:
+            for (size_t i = 2; i < order.size(); ++i)
+            {
+                mesh.indices.push_back(order[0]);
+                mesh.indices.push_back(order[i - 1]);
+                mesh.indices.push_back(order[i]);
+            }
+            break;
+        }
+
+        if (!hasNormals)
+        {
+            ComputeNormals(mesh);
+        }
+        mesh.ComputeBounds();
+        return true;
+    }
+
+    glm::mat4 nodeTransform(const JsonValue& node)
+    {
+        const auto& matrix = node["matrix"];
+        if (matrix.Size() == 16)
+        {
+            GLfloat values[16];
+            for (auto i = 0; i < 16; ++i)
+            {
+                values[i] = static_cast<GLfloat>(matrix[i].Number());
+            }
+            return glm::make_mat4(values); // Column major, as glTF writes it
+        }
+
+        const auto& t = node["translation"];
+        const auto& r = node["rotation"];
+        const auto& s = node["scale"];
+        glm::quat rotation(static_cast<float>(r[3].Number(1.0)), static_cast<float>(r[0].Number()),
+                           static_cast<float>(r[1].Number()), static_cast<float>(r[2].Number()));
+        auto transform = glm::translate(glm::mat4(), glm::vec3(t[0].Number(), t[1].Number(), t[2].Number()));
+        transform *= glm::mat4_cast(rotation);
+        return glm::scale(transform, glm::vec3(s[0].Number(1.0), s[1].Number(1.0), s[2].Number(1.0)));
+    }
+}
+
+bool ImportGltf(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error)
+{
+    std::vector<char> file;
+    size_t size;
+    if (!ReadPaddedFile(path, file, size, error))
+    {
+        return false;
+    }
+    auto begin = file.data() + FLOAT_PARSER_PADDING;
+
+    // A GLB is a header, a JSON chunk and an optional binary chunk
+    auto jsonBegin = begin;
+    auto jsonEnd = begin + size;
+    BufferData binaryChunk = {};
+    if (size >= 12 && readU32(begin) == GLB_MAGIC)
+    {
+        if (readU32(begin + 4) != 2)
+        {
+            error = "only version 2 GLB files are supported";
+            return false;
+        }
+        auto length = std::min(static_cast<size_t>(readU32(begin + 8)), size);
+        auto jsonFound = false;
+        for (size_t offset = 12; offset + 8 <= length;)
+        {
+            auto chunkLength = static_cast<size_t>(readU32(begin + offset));
+            auto chunkType = readU32(begin + offset + 4);
+            auto data = begin + offset + 8;
+            if (offset + 8 + chunkLength > length)
+            {
+                error = "GLB chunk runs past the end of the file";
+                return false;
+            }
+            if (chunkType == GLB_CHUNK_JSON && !jsonFound)
+            {
+                jsonBegin = data;
+                jsonEnd = data + chunkLength;
+                jsonFound = true;
+            }
+            else if (chunkType == GLB_CHUNK_BIN && !binaryChunk.data)
+            {
+                binaryChunk = { reinterpret_cast<const unsigned char*>(data), chunkLength };
+            }
+            offset += 8 + ((chunkLength + 3) & ~static_cast<size_t>(3));
+        }
+        if (!jsonFound)
+        {
+            error = "GLB has no JSON chunk";
+            return false;
+        }
+    }
+
+    JsonValue document;
+    if (!document.Parse(jsonBegin, jsonEnd, error))
+    {
+        error = "bad JSON: " + error;
+        return false;
+    }
+    if (document["asset"]["version"].String().compare(0, 1, "2") != 0)
+    {
+        error = "only glTF 2.0 is supported";
+        return false;
+    }
+
+    std::vector<std::vector<unsigned char>> storage;
+    std::vector<BufferData> buffers;
+    if (!loadBuffers(document, path, binaryChunk, storage, buffers, error))
+    {
+        return false;
+    }
+
+    model = ImportedModel();
+    const auto& materials = document["materials"];
+    for (size_t i = 0; i < materials.Size(); ++i)
+    {
+        model.materials.push_back(convertMaterial(materials[i]));
+    }
+    auto fallback = static_cast<GLuint>(model.materials.size());
+    model.materials.push_back(defaultMaterial);
+
+    // Every triangle primitive becomes a mesh, meshPrimitives finds them from a glTF mesh
+    const auto& meshes = document["meshes"];
+    std::vector<Primitive> primitives;
+    std::vector<std::vector<GLuint>> meshPrimitives(meshes.Size());
+    for (size_t i = 0; i < meshes.Size(); ++i)
+    {
+        const auto& list = meshes[i]["primitives"];
+        for (size_t j = 0; j < list.Size(); ++j)
+        {
+            auto mode = list[j]["mode"].Int(MODE_TRIANGLES);
+            if (mode != MODE_TRIANGLES && mode != MODE_TRIANGLE_STRIP && mode != MODE_TRIANGLE_FAN)
+            {
+                std::cout << "Status: Skipping a point or line primitive in mesh " << i << std::endl;
+                continue;
+            }
+            auto material = list[j]["material"].Int(-1);
+            meshPrimitives[i].push_back(static_cast<GLuint>(primitives.size()));
+            primitives.push_back({ &list[j], material >= 0 && material < static_cast<int>(fallback) ? static_cast<GLuint>(material) : fallback });
+        }
+    }
+
+    model.meshes.resize(primitives.size());
+    std::vector<std::string> errors(primitives.size());
+    pool.ParallelFor(primitives.size(), [&](size_t i, unsigned)
+    {
+        buildPrimitive(document, buffers, *primitives[i].json, model.meshes[i], errors[i]);
+    });
+    for (const auto& primitiveError : errors)
+    {
+        if (!primitiveError.empty())
+        {
+            error = primitiveError;
+            return false;
+        }
+    }
+
+    // Walk the node hierarchy from the scene's roots, or every parentless node if there is no scene
+    const auto& nodes = document["nodes"];
+    std::vector<std::pair<int, glm::mat4>> stack;
+    const auto& scene = document["scenes"][static_cast<size_t>(document["scene"].Int(0))];
+    if (!scene.IsNull())
+    {
+        for (size_t i = 0; i < scene["nodes"].Size(); ++i)
+        {
+            stack.emplace_back(scene["nodes"][i].Int(-1), glm::mat4());
+        }
+    }
+    else
+    {
+        std::vector<bool> isChild(nodes.Size());
+        for (size_t i = 0; i < nodes.Size(); ++i)
+        {
+            for (size_t j = 0; j < nodes[i]["children"].Size(); ++j)
+            {
+                auto child = nodes[i]["children"][j].Int(-1);
+                if (child >= 0 && child < static_cast<int>(nodes.Size()))
+                {
+                    isChild[child] = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < nodes.Size(); ++i)
+        {
+            if (!isChild[i])
+            {
+                stack.emplace_back(static_cast<int>(i), glm::mat4());
+            }
+        }
+    }
+
+    // The hierarchy must be a forest, so no more nodes are visited than there are
+    size_t visited = 0;
+    while (!stack.empty())
+    {
+        auto index = stack.back().first;
+        auto parent = stack.back().second;
+        stack.pop_back();
+        const auto& node = nodes[static_cast<size_t>(index)];
+        if (index < 0 || node.IsNull() || ++visited > nodes.Size())
+        {
+            error = "bad node hierarchy";
+            return false;
+        }
+
+        auto transform = parent * nodeTransform(node);
+        auto mesh = node["mesh"].Int(-1);
+        if (mesh >= 0 && mesh < static_cast<int>(meshPrimitives.size()))
+        {
+            for (auto primitive : meshPrimitives[mesh])
+            {
+                model.instances.push_back({ primitive, primitives[primitive].material, transform });
+            }
+        }
+        for (size_t i = 0; i < node["children"].Size(); ++i)
+        {
+            stack.emplace_back(node["children"][i].Int(-1), transform);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#include "GlyphAtlas.h"
+
+#include <GL/freeglut.h>
+
+// Glyphs are packed in rows, one pixel apart so nearest sampling never bleeds
+#define ATLAS_WIDTH 512
+#define GLYPH_PADDING 1
+
+GlyphAtlas::~GlyphAtlas()
+{
+    glDeleteTextures(1, &texture);
+}
+
+void GlyphAtlas::Setup(void* font)
+{
+    cellHeight = glutBitmapHeight(font);
+    descent = cellHeight / 4;
+
+    // Lay the glyphs out first to know the atlas height
+    GLint origins[GLYPH_COUNT][2];
+    GLint x = 0, y = 0;
+    for (auto i = 0; i < GLYPH_COUNT; ++i)
+    {
+        auto width = glutBitmapWidth(font, GLYPH_FIRST + i);
+        if (x + width > ATLAS_WIDTH)
+        {
+            x = 0;
+            y += cellHeight + GLYPH_PADDING;
+        }
+        origins[i][0] = x;
+        origins[i][1] = y;
+        glyphs[i].width = static_cast<GLfloat>(width);
+        x += width + GLYPH_PADDING;
+    }
+    auto height = y + cellHeight;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glViewport(0, 0, ATLAS_WIDTH, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // The only fixed function drawing left, done once per font
+    glUseProgram(0);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, ATLAS_WIDTH, 0.0, height, -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glColor3f(1.0f, 1.0f, 1.0f);
+    for (auto i = 0; i < GLYPH_COUNT; ++i)
+    {
+        glRasterPos2i(origins[i][0], origins[i][1] + descent);
+        glutBitmapCharacter(font, GLYPH_FIRST + i);
+
+        glyphs[i].uvMin = glm::vec2(static_cast<GLfloat>(origins[i][0]) / ATLAS_WIDTH,
+                                    static_cast<GLfloat>(origins[i][1]) / height);
+        glyphs[i].uvMax = glm::vec2((origins[i][0] + glyphs[i].width) / ATLAS_WIDTH,
+                                    static_cast<GLfloat>(origins[i][1] + cellHeight) / height);
+    }
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+const Glyph& GlyphAtlas::operator[](char c) const
+{
+    if (c < GLYPH_FIRST || c > GLYPH_LAST)
+    {
+        c = ' ';
+    }
+    return glyphs[c - GLYPH_FIRST];
+}
@@ -0,0 +1,62 @@
+/*
+    GlyphAtlas.h
+
+    Printable ASCII of a GLUT bitmap font rasterized once into a single
+    channel texture, so text can be drawn as textured quads instead of one
+    glutBitmapCharacter call per character.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_GLYPH_ATLAS_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_GLYPH_ATLAS_H_INCLUDED
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '~'
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+struct Glyph
+{
+    glm::vec2 uvMin;
+    glm::vec2 uvMax;
+    GLfloat width; // Also the advance, GLUT bitmap glyphs are not kerned
+};
+
+class GlyphAtlas
+{
+public:
+    GlyphAtlas() = default;
+    ~GlyphAtlas();
+
+    // font is one of the GLUT_BITMAP_* fonts, needs a compatibility context
+    void Setup(void* font);
+
+    // Characters outside the atlas map to a space
+    const Glyph& operator[](char c) const;
+
+    // Cell height, text at y covers y - Descent() to y - Descent() + Height()
+    GLfloat Height() const
+    {
+        return static_cast<GLfloat>(cellHeight);
+    }
+
+    GLfloat Descent() const
+    {
+        return static_cast<GLfloat>(descent);
+    }
+
+    GLuint Texture() const
+    {
+        return texture;
+    }
+
+private:
+    Glyph glyphs[GLYPH_COUNT];
+    GLint cellHeight = 0;
+    GLint descent = 0;
+    GLuint texture = 0;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "GpuTimer.h"
+
+namespace
+{
+    bool hasTimerQuery()
+    {
+        return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    if (queries[0][0] != 0)
+    {
+        glDeleteQueries(2 * GPU_TIMER_QUERIES, &queries[0][0]);
+    }
+}
+
+void GpuTimer::Begin()
+{
+    if (!hasTimerQuery())
+    {
+        return;
+    }
+    if (queries[0][0] == 0)
+    {
+        glGenQueries(2 * GPU_TIMER_QUERIES, &queries[0][0]);
+    }
+
+    collect();
+    timing = !pending[next];
+    if (timing)
+    {
+        glQueryCounter(queries[next][0], GL_TIMESTAMP);
+    }
+}
+
+void GpuTimer::End()
+{
+    if (!timing)
+    {
+        return;
+    }
+    glQueryCounter(queries[next][1], GL_TIMESTAMP);
+    pending[next] = true;
+    next = (next + 1) % GPU_TIMER_QUERIES;
+    timing = false;
+}
+
+bool GpuTimer::Result(double& averageMilliseconds)
+{
+    if (frames < interval)
+    {
+        return false;
+    }
+    averageMilliseconds = total / frames;
+    total = 0.0;
+    frames = 0;
+    return true;
+}
+
+// Adds up the query pairs the GPU has got through, oldest first
+void GpuTimer::collect()
+{
+    for (auto i = 0; i < GPU_TIMER_QUERIES; ++i)
+    {
+        auto slot = (next + i) % GPU_TIMER_QUERIES;
+        if (!pending[slot])
+        {
+            continue;
+        }
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            // The end timestamp comes after the beginning, so a later pair can't be done either
+            break;
+        }
+        GLuint64 begin, end;
+        glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+        pending[slot] = false;
+        if (frames < interval)
+        {
+            total += (end - begin) / 1e6;
+            ++frames;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+    GpuTimer.h
+
+    GPU time of a stretch of commands, from a timestamp query at each end.
+    Results are picked up frames later without waiting on the GPU, from a
+    small ring of query pairs, and averaged over a fixed number of frames
+    like FrameTimer. Timestamps rather than GL_TIME_ELAPSED let timers nest
+    and run alongside the regression gate's. Without timer queries nothing
+    is ever measured.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_GPU_TIMER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_GPU_TIMER_H_INCLUDED
+
+#include <GL/glew.h>
+
+#define GPU_TIMER_QUERIES 4 // Frames a result can lag behind
+
+class GpuTimer
+{
+public:
+    explicit GpuTimer(int interval = 120)
+        : interval(interval)
+    {
+    }
+
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // A frame is skipped when every query pair is still waiting on the GPU
+    void Begin();
+    void End();
+
+    // True once every interval frames measured, with the average over them in milliseconds
+    bool Result(double& averageMilliseconds);
+
+private:
+    void collect();
+
+    int interval;
+    int frames = 0;
+    double total = 0.0;
+    GLuint queries[GPU_TIMER_QUERIES][2] = {};
+    bool pending[GPU_TIMER_QUERIES] = {};
+    int next = 0;
+    bool timing = false;
+};
+
+#endif
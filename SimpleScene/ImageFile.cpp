@@ -0,0 +1,90 @@
+#include "ImageFile.h"
+
+#include <fstream>
+
+bool WritePpm(const std::string& path, const std::vector<GLuint>& pixels, int width, int height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // PPM goes top to bottom
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<char> row(static_cast<size_t>(width) * 3);
+    for (auto y = height - 1; y >= 0; --y)
+    {
+        for (auto x = 0; x < width; ++x)
+        {
+            auto pixel = pixels[static_cast<size_t>(y) * width + x];
+            row[x * 3] = static_cast<char>(pixel & 0xFF);
+            row[x * 3 + 1] = static_cast<char>(pixel >> 8 & 0xFF);
+            row[x * 3 + 2] = static_cast<char>(pixel >> 16 & 0xFF);
+        }
+        file.write(row.data(), row.size());
+    }
+    return static_cast<bool>(file);
+}
+
+bool ReadPpm(const std::string& path, std::vector<GLuint>& pixels, int& width, int& height)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // Header fields are separated by whitespace and may have comments in between
+    std::string magic;
+    int fields[3];
+    file >> magic;
+    for (auto& field : fields)
+    {
+        while (file >> std::ws && file.peek() == '#')
+        {
+            file.ignore(1 << 16, '\n');
+        }
+        file >> field;
+    }
+    if (!file || magic != "P6" || fields[0] <= 0 || fields[1] <= 0 || fields[2] != 255)
+    {
+        return false;
+    }
+    file.get();
+
+    width = fields[0];
+    height = fields[1];
+    pixels.resize(static_cast<size_t>(width) * height);
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+    for (auto y = height - 1; y >= 0; --y)
+    {
+        if (!file.read(reinterpret_cast<char*>(row.data()), row.size()))
+        {
+            return false;
+        }
+        for (auto x = 0; x < width; ++x)
+        {
+            pixels[static_cast<size_t>(y) * width + x] = row[x * 3] | row[x * 3 + 1] << 8 | row[x * 3 + 2] << 16 | 0xFF000000u;
+        }
+    }
+    return true;
+}
+
+size_t CountDifferingPixels(const std::vector<GLuint>& a, const std::vector<GLuint>& b, int tolerance)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+    {
+        for (auto shift = 0; shift < 24; shift += 8)
+        {
+            auto difference = static_cast<int>(a[i] >> shift & 0xFF) - static_cast<int>(b[i] >> shift & 0xFF);
+            if (difference > tolerance || difference < -tolerance)
+            {
+                ++count;
+                break;
+            }
+        }
+    }
+    return count;
+}
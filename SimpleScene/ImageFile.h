@@ -0,0 +1,28 @@
+/*
+    ImageFile.h
+
+    Frames saved to disk as binary PPM, which any image viewer opens and
+    needs no library to read or write. Pixels are in the RGBA8 layout the CPU
+    renderers and glReadPixels use, bottom row first; alpha is dropped on
+    the way out and opaque on the way in.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_IMAGE_FILE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_IMAGE_FILE_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// False if the file couldn't be written
+bool WritePpm(const std::string& path, const std::vector<GLuint>& pixels, int width, int height);
+
+// False if the file is missing or not an 8 bit binary PPM
+bool ReadPpm(const std::string& path, std::vector<GLuint>& pixels, int& width, int& height);
+
+// Pixels where any channel is more than tolerance apart, both images the same size
+size_t CountDifferingPixels(const std::vector<GLuint>& a, const std::vector<GLuint>& b, int tolerance);
+
+#endif
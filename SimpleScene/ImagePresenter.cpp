@@ -0,0 +1,48 @@
+#include "ImagePresenter.h"
+
+#include "FrameStats.h"
+
+ImagePresenter::~ImagePresenter()
+{
+    glDeleteTextures(1, &texture);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void ImagePresenter::Present(const std::vector<GLuint>& pixels, GLsizei width, GLsizei height, const Shader& compositeShader)
+{
+    if (texture == 0)
+    {
+        glGenTextures(1, &texture);
+        glGenVertexArrays(1, &vao);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (width != this->width || height != this->height)
+    {
+        this->width = width;
+        this->height = height;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    compositeShader.Use();
+    glUniform4f(glGetUniformLocation(compositeShader(), "rect"), -1.0f, -1.0f, 2.0f, 2.0f);
+    glUniform1i(glGetUniformLocation(compositeShader(), "panel"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPolygonMode(GL_FRONT, polygonMode[0]);
+    glPolygonMode(GL_BACK, polygonMode[1]);
+}
@@ -0,0 +1,34 @@
+/*
+    ImagePresenter.h
+
+    Shows a frame drawn on the CPU: the pixels are streamed into a texture
+    and drawn over the whole viewport with the panel shader.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_IMAGE_PRESENTER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_IMAGE_PRESENTER_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Shader.h"
+
+class ImagePresenter
+{
+public:
+    ImagePresenter() = default;
+    ~ImagePresenter();
+
+    // pixels are RGBA8, bottom row first. compositeShader is the panel shader
+    void Present(const std::vector<GLuint>& pixels, GLsizei width, GLsizei height, const Shader& compositeShader);
+
+private:
+    GLuint texture = 0;
+    GLuint vao = 0;
+    GLsizei width = 0;
+    GLsizei height = 0;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "InputLog.h"
+
+#include <iostream>
+
+InputLog::~InputLog()
+{
+    Close();
+}
+
+bool InputLog::Record(const std::string& path)
+{
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Error: Couldn't create the input log " << path << std::endl;
+        return false;
+    }
+    InputLogHeader header = { INPUT_LOG_MAGIC, INPUT_LOG_VERSION, INPUT_TIME_STEP, 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    step = 0;
+    return true;
+}
+
+bool InputLog::Replay(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input)
+    {
+        std::cerr << "Error: Couldn't open the input log " << path << std::endl;
+        return false;
+    }
+    auto size = static_cast<size_t>(input.tellg());
+    input.seekg(0);
+
+    InputLogHeader header;
+    if (size < sizeof(header) || !input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != INPUT_LOG_MAGIC || header.version != INPUT_LOG_VERSION)
+    {
+        std::cerr << "Error: " << path << " isn't a version " << INPUT_LOG_VERSION << " input log" << std::endl;
+        return false;
+    }
+    if (header.timeStep != INPUT_TIME_STEP)
+    {
+        std::cerr << "Error: " << path << " was recorded at a time step of " << header.timeStep << " s, not " << INPUT_TIME_STEP << " s" << std::endl;
+        return false;
+    }
+
+    events.resize((size - sizeof(header)) / sizeof(InputEvent));
+    input.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(InputEvent));
+    replaying = true;
+    next = 0;
+    step = 0;
+    return true;
+}
+
+void InputLog::Close()
+{
+    if (file.is_open())
+    {
+        InputEvent end = { step, 0, InputEventType::End, 0, 0, 0 };
+        file.write(reinterpret_cast<const char*>(&end), sizeof(end));
+        file.close();
+    }
+}
+
+void InputLog::Add(int view, InputEventType type, int key, int x, int y)
+{
+    if (file.is_open())
+    {
+        InputEvent event = { step, static_cast<uint8_t>(view), type, static_cast<uint16_t>(key), static_cast<int16_t>(x), static_cast<int16_t>(y) };
+        file.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    }
+}
+
+bool InputLog::Step(const std::function<void(const InputEvent&)>& dispatch)
+{
+    if (replaying)
+    {
+        if (next == events.size())
+        {
+            return false;
+        }
+        for (; next < events.size() && events[next].step <= step; ++next)
+        {
+            if (events[next].type == InputEventType::End)
+            {
+                return false;
+            }
+            dispatch(events[next]);
+        }
+    }
+    ++step;
+    return true;
+}
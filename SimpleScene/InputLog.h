@@ -0,0 +1,113 @@
+/*
+    InputLog.h
+
+    Records what the user does in each view so a session can be played back
+    exactly, as a repeatable benchmark workload. Input changes the scene
+    only through fixed time steps while a log is recording or replaying:
+    each event is stamped with the step it comes before, and a replay runs
+    one step per frame, whatever the wall clock says, feeding each event
+    back through the same handlers just before its step.
+
+    Layout, little endian:
+        InputLogHeader
+        InputEvent[], in step order, the last one InputEventType::End
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_INPUT_LOG_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_INPUT_LOG_H_INCLUDED
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#define INPUT_LOG_MAGIC 0x4E495353 // "SSIN"
+#define INPUT_LOG_VERSION 1
+#define INPUT_TIME_STEP (1.0f / 60.0f)
+
+enum class InputEventType : uint8_t
+{
+    KeyPress,
+    KeyUp,
+    SpecialPress,
+    SpecialUp,
+    MouseMove,
+    End
+};
+
+struct InputLogHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    float timeStep;
+    uint32_t reserved;
+};
+
+struct InputEvent
+{
+    uint32_t step;
+    uint8_t view;
+    InputEventType type;
+    uint16_t key;
+    int16_t x, y; // Cursor in view pixels
+};
+
+static_assert(sizeof(InputLogHeader) == 16 && sizeof(InputEvent) == 12, "Input log records have no padding");
+
+class InputLog
+{
+public:
+    InputLog() = default;
+    ~InputLog();
+
+    InputLog(const InputLog&) = delete;
+    InputLog& operator=(const InputLog&) = delete;
+
+    bool Record(const std::string& path);
+
+    // Reads the whole log, a log cut short ends after its last event
+    bool Replay(const std::string& path);
+
+    // Writes the end marker when recording
+    void Close();
+
+    bool Recording() const
+    {
+        return file.is_open();
+    }
+
+    bool Replaying() const
+    {
+        return replaying;
+    }
+
+    // Stamps the event with the next step when recording
+    void Add(int view, InputEventType type, int key, int x, int y);
+
+    // Moves on one time step, handing a replay's events for it to dispatch first. False once a replay is over
+    bool Step(const std::function<void(const InputEvent&)>& dispatch);
+
+    uint32_t Steps() const
+    {
+        return step;
+    }
+
+    // Seconds of input time, what animations should follow instead of the wall clock
+    GLfloat Time() const
+    {
+        return step * INPUT_TIME_STEP;
+    }
+
+private:
+    std::ofstream file;
+    bool replaying = false;
+    std::vector<InputEvent> events;
+    size_t next = 0;
+    uint32_t step = 0;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const int MAX_DEPTH = 64;
+
+    void skipSpace(const char*& p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        {
+            ++p;
+        }
+    }
+
+    bool parseHex(const char* p, const char* end, unsigned& code)
+    {
+        if (end - p < 4)
+        {
+            return false;
+        }
+        code = 0;
+        for (auto i = 0; i < 4; ++i)
+        {
+            auto c = p[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                code |= c - '0';
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                code |= c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                code |= c - 'A' + 10;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendUtf8(std::string& text, unsigned code)
+    {
+        if (code < 0x80)
+        {
+            text += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            text += static_cast<char>(0xC0 | (code >> 6));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            text += static_cast<char>(0xE0 | (code >> 12));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            text += static_cast<char>(0xF0 | (code >> 18));
+            text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(const char*& p, const char* end, std::string& text)
+    {
+        ++p; // Opening quote
+        text.clear();
+        while (p < end)
+        {
+            // Copy unescaped runs in one go, embedded buffers are long base64 strings
+            auto run = p;
+            while (p < end && *p != '"' && *p != '\\')
+            {
+                ++p;
+            }
+            text.append(run, p);
+            if (p == end)
+            {
+                return false;
+            }
+            if (*p == '"')
+            {
+                ++p;
+                return true;
+            }
+
+            if (++p == end)
+            {
+                return false;
+            }
+            switch (*p++)
+            {
+            case '"': text += '"'; break;
+            case '\\': text += '\\'; break;
+            case '/': text += '/'; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u':
+            {
+                unsigned code;
+                if (!parseHex(p, end, code))
+                {
+                    return false;
+                }
+                p += 4;
+                // Surrogate pair
+                unsigned low;
+                if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    parseHex(p + 2, end, low) && low >= 0xDC00 && low < 0xE000)
+                {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                appendUtf8(text, code);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool matchWord(const char*& p, const char* end, const char* word)
+    {
+        auto length = std::strlen(word);
+        if (static_cast<size_t>(end - p) < length || std::strncmp(p, word, length) != 0)
+        {
+            return false;
+        }
+        p += length;
+        return true;
+    }
+}
+
+bool JsonValue::Parse(const char* begin, const char* end, std::string& error)
+{
+    *this = JsonValue();
+    auto p = begin;
+    if (!parse(p, end, 0, error))
+    {
+        error += " at offset " + std::to_string(p - begin);
+        return false;
+    }
+    skipSpace(p, end);
+    if (p != end)
+    {
+        error = "trailing characters at offset " + std::to_string(p - begin);
+        return false;
+    }
+    return true;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    static const JsonValue null;
+    return type == JsonType::Array && index < elements.size() ? elements[index] : null;
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+    static const JsonValue null;
+    if (type == JsonType::Object)
+    {
+        for (const auto& member : members)
+        {
+            if (member.first == key)
+            {
+                return member.second;
+            }
+        }
+    }
+    return null;
+}
+
+bool JsonValue::parse(const char*& p, const char* end, int depth, std::string& error)
+{
+    if (depth > MAX_DEPTH)
+    {
+        error = "nested too deeply";
+        return false;
+    }
+
+    skipSpace(p, end);
+    if (p == end)
+    {
+        error = "unexpected end";
+        return false;
+    }
+
+    switch (*p)
+    {
+    case '{':
+        type = JsonType::Object;
+        ++p;
+        skipSpace(p, end);
+        if (p < end && *p == '}')
+        {
+            ++p;
+            return true;
+        }
+        while (true)
+        {
+            skipSpace(p, end);
+            std::string key;
+            if (p == end || *p != '"' || !parseString(p, end, key))
+            {
+                error = "expected a member name";
+                return false;
+            }
+            skipSpace(p, end);
+            if (p == end || *p++ != ':')
+            {
+                error = "expected ':'";
+                return false;
+            }
+            members.emplace_back(std::move(key), JsonValue());
+            if (!members.back().second.parse(p, end, depth + 1, error))
+            {
+                return false;
+            }
+            skipSpace(p, end);
+            if (p < end && *p == ',')
+            {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == '}')
+            {
+                ++p;
+                return true;
+            }
+            error = "expected ',' or '}'";
+            return false;
+        }
+
+    case '[':
+        type = JsonType::Array;
+        ++p;
+        skipSpace(p, end);
+        if (p < end && *p == ']')
+        {
+            ++p;
+            return true;
+        }
+        while (true)
+        {
+            elements.emplace_back();
+            if (!elements.back().parse(p, end, depth + 1, error))
+            {
+                return false;
+            }
+            skipSpace(p, end);
+            if (p < end && *p == ',')
+            {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == ']')
+            {
+                ++p;
+                return true;
+            }
+            error = "expected ',' or ']'";
+            return false;
+        }
+
+    case '"':
+        type = JsonType::String;
+        if (!parseString(p, end, text))
+        {
+            error = "bad string";
+            return false;
+        }
+        return true;
+
+    case 't':
+    case 'f':
+        type = JsonType::Bool;
+        boolean = *p == 't';
+        if (!matchWord(p, end, boolean ? "true" : "false"))
+        {
+            error = "bad literal";
+            return false;
+        }
+        return true;
+
+    case 'n':
+        if (!matchWord(p, end, "null"))
+        {
+            error = "bad literal";
+            return false;
+        }
+        return true;
+
+    default:
+    {
+        // strtod needs a terminated copy, numbers are short
+        char digits[64];
+        auto length = 0;
+        while (p + length < end && length < 63 && std::strchr("+-0123456789.eE", p[length]))
+        {
+            digits[length] = p[length];
+            ++length;
+        }
+        digits[length] = '\0';
+        char* parsed;
+        number = std::strtod(digits, &parsed);
+        if (length == 0 || parsed != digits + length)
+        {
+            error = "bad number";
+            return false;
+        }
+        type = JsonType::Number;
+        p += length;
+        return true;
+    }
+    }
+}
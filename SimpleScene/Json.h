@@ -0,0 +1,91 @@
+/*
+    Json.h
+
+    Just enough JSON for glTF: a read-only document tree. Lookups of missing
+    members or elements give a null value, so optional properties can be read
+    with a fallback instead of a check at every step.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_JSON_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_JSON_H_INCLUDED
+
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class JsonType
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+class JsonValue
+{
+public:
+    JsonValue() = default;
+    ~JsonValue() = default;
+
+    // Parses a whole document, error says where it went wrong
+    bool Parse(const char* begin, const char* end, std::string& error);
+
+    JsonType Type() const
+    {
+        return type;
+    }
+
+    bool IsNull() const
+    {
+        return type == JsonType::Null;
+    }
+
+    // Elements of an array or members of an object
+    size_t Size() const
+    {
+        return type == JsonType::Object ? members.size() : elements.size();
+    }
+
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](int index) const
+    {
+        return (*this)[static_cast<size_t>(index)]; // Negative ones are out of range too
+    }
+    const JsonValue& operator[](const char* key) const;
+
+    double Number(double fallback = 0.0) const
+    {
+        return type == JsonType::Number ? number : fallback;
+    }
+
+    int Int(int fallback = 0) const
+    {
+        return type == JsonType::Number ? static_cast<int>(number) : fallback;
+    }
+
+    bool Bool(bool fallback = false) const
+    {
+        return type == JsonType::Bool ? boolean : fallback;
+    }
+
+    // Empty unless the value is a string
+    const std::string& String() const
+    {
+        return text;
+    }
+
+private:
+    bool parse(const char*& p, const char* end, int depth, std::string& error);
+
+    JsonType type = JsonType::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
+
+#endif
@@ -0,0 +1,413 @@
+#include "LightBaker.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "LightingKernel.h"
+#include "LightPool.h"
+
+namespace
+{
+    struct BakeHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sceneHash;
+        uint32_t layerCount;
+        uint32_t vertexCount;
+    };
+
+    struct BakeLayerHeader
+    {
+        uint32_t light;
+        uint32_t objectCount;
+        uint64_t lightHash;
+    };
+
+    // FNV-1a
+    const uint64_t HASH_START = 14695981039346656037ull;
+
+    uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size)
+    {
+        auto data = static_cast<const unsigned char*>(bytes);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    uint64_t hashValue(uint64_t hash, const T& value)
+    {
+        return hashBytes(hash, &value, sizeof(value));
+    }
+
+    // What a light adds to the bake, not its specular
+    uint64_t hashLight(const SceneLight& light, GLuint index)
+    {
+        auto hash = hashValue(HASH_START, index);
+        hash = hashValue(hash, light.position);
+        hash = hashValue(hash, light.material.ambient);
+        hash = hashValue(hash, light.material.diffuse);
+        hash = hashValue(hash, light.constant);
+        hash = hashValue(hash, light.linear);
+        return hashValue(hash, light.quadratic);
+    }
+}
+
+bool LightBaker::Bake(const Scene& scene, const DynamicBvh& tree, const std::vector<char>& baked, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool,
+                      ThreadPool& threads, const std::string& cachePath, std::string& error)
+{
+    layers.clear();
+    cachedLayers = 0;
+    layout(scene, meshHandles, pool);
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (vertexCount > static_cast<GLuint>(maxTexels))
+    {
+        error = std::to_string(vertexCount) + " vertices are more than a texture buffer holds here (" + std::to_string(maxTexels) + ")";
+        return false;
+    }
+
+    // Everything the layers depend on but the lights, the pool's layout included
+    auto sceneHash = hashValue(HASH_START, static_cast<uint32_t>(BAKE_CACHE_VERSION));
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        const auto& mesh = scene.meshes[i];
+        sceneHash = hashBytes(sceneHash, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+        sceneHash = hashBytes(sceneHash, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+        sceneHash = hashBytes(sceneHash, scene.lods[i].data(), scene.lods[i].size() * sizeof(LodLevel));
+    }
+    for (const auto& material : scene.materials)
+    {
+        sceneHash = hashValue(sceneHash, material.material);
+    }
+    sceneHash = hashBytes(sceneHash, scene.objects.data(), scene.objects.size() * sizeof(SceneObject));
+    sceneHash = hashBytes(sceneHash, objectFirstVertices.data(), objectFirstVertices.size() * sizeof(GLint));
+    sceneHash = hashBytes(sceneHash, objectSizes.data(), objectSizes.size() * sizeof(GLuint));
+
+    std::vector<BakeLayer> cached;
+    std::vector<GLint> cachedByLight(scene.pointLights.size(), -1);
+    if (!cachePath.empty() && load(cachePath, sceneHash, cached))
+    {
+        for (size_t i = 0; i < cached.size(); ++i)
+        {
+            if (cached[i].light < cachedByLight.size())
+            {
+                cachedByLight[cached[i].light] = static_cast<GLint>(i);
+            }
+        }
+    }
+
+    std::vector<GLuint> fresh; // Layers to bake
+    for (GLuint light = 0; light < scene.pointLights.size(); ++light)
+    {
+        if (light >= baked.size() || !baked[light])
+        {
+            continue;
+        }
+        auto hash = hashLight(scene.pointLights[light], light);
+        auto match = cachedByLight[light];
+        if (match >= 0 && cached[match].hash == hash)
+        {
+            layers.push_back(std::move(cached[match]));
+            ++cachedLayers;
+            continue;
+        }
+        fresh.push_back(static_cast<GLuint>(layers.size()));
+        layers.push_back({ light, hash, {}, {}, {} });
+    }
+
+    // Each fresh light's reach, then every object it reaches shaded on its own
+    std::vector<glm::vec4> bounds;
+    for (const auto& object : scene.objects)
+    {
+        bounds.push_back(scene.Bounds(object));
+    }
+    auto reaches = [&](const glm::vec3& position, GLfloat range, GLuint object)
+    {
+        return glm::length(glm::vec3(bounds[object]) - position) < range + bounds[object].w;
+    };
+    threads.ParallelFor(fresh.size(), [&](size_t i, unsigned)
+    {
+        auto& layer = layers[fresh[i]];
+        const auto& light = scene.pointLights[layer.light];
+        auto brightest = 0.0f;
+        for (const auto& color : { light.material.ambient, light.material.diffuse })
+        {
+            brightest = std::max(brightest, std::max(color.r, std::max(color.g, color.b)));
+        }
+        auto range = LightRange(light.constant, light.linear, light.quadratic, brightest);
+        if (range > 0.0f)
+        {
+            // The tree's boxes hold the objects' bounding spheres, so what they reach is narrowed to the spheres that do
+            tree.QuerySphere(light.position, range, [&](GLuint object)
+            {
+                if (reaches(light.position, range, object))
+                {
+                    layer.objects.push_back(object);
+                }
+            });
+            // In scene order, so the layout and the cache don't depend on the tree's shape
+            std::sort(layer.objects.begin(), layer.objects.end());
+        }
+        place(layer);
+    });
+
+    std::vector<BakeEntry> work;
+    for (auto index : fresh)
+    {
+        for (GLuint entry = 0; entry < layers[index].objects.size(); ++entry)
+        {
+            work.push_back({ index, entry });
+        }
+    }
+    threads.ParallelFor(work.size(), [&](size_t i, unsigned)
+    {
+        auto& layer = layers[work[i].layer];
+        auto object = layer.objects[work[i].entry];
+        const auto& sceneObject = scene.objects[object];
+        const auto& light = scene.pointLights[layer.light];
+
+        LightSet lights;
+        PointLightBlock block = {};
+        block.position = light.position;
+        block.constant = light.constant;
+        block.ambient = light.material.ambient;
+        block.linear = light.linear;
+        block.diffuse = light.material.diffuse;
+        block.quadratic = light.quadratic;
+        lights.pointLights.push_back(block);
+        auto material = scene.materials[sceneObject.material].material;
+        material.specular = glm::vec3(0.0f);
+        auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(sceneObject.model)));
+
+        std::vector<GLfloat> values;
+        for (const auto& level : scene.lods[sceneObject.mesh])
+        {
+            const auto& range = pool.Range(meshHandles[level.mesh]);
+            const auto& vertices = scene.meshes[level.mesh].vertices;
+            auto count = std::min(static_cast<size_t>(range.vertexCount), vertices.size());
+            values.resize(count * 9);
+            auto data = values.data();
+            for (size_t v = 0; v < count; ++v)
+            {
+                auto position = glm::vec3(sceneObject.model * glm::vec4(vertices[v].position, 1.0f));
+                auto normal = normalMatrix * vertices[v].normal;
+                for (auto axis = 0; axis < 3; ++axis)
+                {
+                    data[axis * count + v] = position[axis];
+                    data[(3 + axis) * count + v] = normal[axis];
+                }
+            }
+            ShadingBatch batch = { { data, data + count, data + 2 * count }, { data + 3 * count, data + 4 * count, data + 5 * count },
+                                   { data + 6 * count, data + 7 * count, data + 8 * count }, count };
+            ShadeBatch(lights, material, glm::vec3(0.0f), batch);
+
+            auto colors = layer.colors.data() + layer.offsets[work[i].entry] + (range.baseVertex - objectFirstVertices[object]);
+            for (size_t v = 0; v < count; ++v)
+            {
+                colors[v] = glm::vec3(batch.color[0][v], batch.color[1][v], batch.color[2][v]);
+            }
+        }
+    });
+
+    objectEntries.assign(objectOffsets.size(), {});
+    for (GLuint index = 0; index < layers.size(); ++index)
+    {
+        for (GLuint entry = 0; entry < layers[index].objects.size(); ++entry)
+        {
+            objectEntries[layers[index].objects[entry]].push_back({ index, entry });
+        }
+    }
+
+    if (!cachePath.empty() && !fresh.empty() && !save(cachePath, sceneHash))
+    {
+        error = "couldn't write the cache to " + cachePath;
+    }
+    return true;
+}
+
+void LightBaker::Sum(GLuint object, const std::vector<char>& on, glm::vec4* colors) const
+{
+    std::fill(colors, colors + objectSizes[object], glm::vec4(0.0f));
+    for (const auto& entry : objectEntries[object])
+    {
+        if (entry.layer >= on.size() || !on[entry.layer])
+        {
+            continue;
+        }
+        const auto& layer = layers[entry.layer];
+        auto source = layer.colors.data() + layer.offsets[entry.entry];
+        for (GLuint v = 0; v < objectSizes[object]; ++v)
+        {
+            colors[v] += glm::vec4(source[v], 0.0f);
+        }
+    }
+}
+
+// Gives each object a block spanning its levels' vertices in the pool. A chain's levels are added
+// one after another, so they sit together and the block wastes little
+void LightBaker::layout(const Scene& scene, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool)
+{
+    objectOffsets.clear();
+    objectSizes.clear();
+    objectFirstVertices.clear();
+    objectBases.clear();
+    vertexCount = 0;
+    for (const auto& object : scene.objects)
+    {
+        auto first = INT32_MAX;
+        auto end = 0;
+        for (const auto& level : scene.lods[object.mesh])
+        {
+            const auto& range = pool.Range(meshHandles[level.mesh]);
+            first = std::min(first, range.baseVertex);
+            end = std::max(end, range.baseVertex + static_cast<GLint>(range.vertexCount));
+        }
+        auto size = static_cast<GLuint>(std::max(end - first, 0));
+        objectOffsets.push_back(vertexCount);
+        objectSizes.push_back(size);
+        objectFirstVertices.push_back(size > 0 ? first : 0);
+        objectBases.push_back(static_cast<GLint>(vertexCount) - objectFirstVertices.back());
+        vertexCount += size;
+    }
+    poolGeneration = pool.Generation();
+}
+
+// Offsets & room for the colours of the layer's objects
+void LightBaker::place(BakeLayer& layer) const
+{
+    layer.offsets.clear();
+    size_t size = 0;
+    for (auto object : layer.objects)
+    {
+        layer.offsets.push_back(static_cast<GLuint>(size));
+        size += objectSizes[object];
+    }
+    layer.colors.assign(size, glm::vec3(0.0f));
+}
+
+bool LightBaker::load(const std::string& path, uint64_t sceneHash, std::vector<BakeLayer>& cached) const
+{
+    std::ifstream file(path, std::ios::binary);
+    BakeHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != BAKE_CACHE_MAGIC ||
+        header.version != BAKE_CACHE_VERSION || header.sceneHash != sceneHash || header.vertexCount != vertexCount)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.layerCount; ++i)
+    {
+        BakeLayerHeader layerHeader;
+        if (!file.read(reinterpret_cast<char*>(&layerHeader), sizeof(layerHeader)) || layerHeader.objectCount > objectSizes.size())
+        {
+            return false;
+        }
+        BakeLayer layer = { layerHeader.light, layerHeader.lightHash, std::vector<GLuint>(layerHeader.objectCount), {}, {} };
+        file.read(reinterpret_cast<char*>(layer.objects.data()), layer.objects.size() * sizeof(GLuint));
+        if (!file || std::any_of(layer.objects.begin(), layer.objects.end(), [this](GLuint object) { return object >= objectSizes.size(); }))
+        {
+            return false;
+        }
+        place(layer);
+        if (!file.read(reinterpret_cast<char*>(layer.colors.data()), layer.colors.size() * sizeof(glm::vec3)))
+        {
+            return false;
+        }
+        cached.push_back(std::move(layer));
+    }
+    return true;
+}
+
+bool LightBaker::save(const std::string& path, uint64_t sceneHash) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    BakeHeader header = { BAKE_CACHE_MAGIC, BAKE_CACHE_VERSION, sceneHash, static_cast<uint32_t>(layers.size()), vertexCount };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& layer : layers)
+    {
+        BakeLayerHeader layerHeader = { layer.light, static_cast<uint32_t>(layer.objects.size()), layer.hash };
+        file.write(reinterpret_cast<const char*>(&layerHeader), sizeof(layerHeader));
+        file.write(reinterpret_cast<const char*>(layer.objects.data()), layer.objects.size() * sizeof(GLuint));
+        file.write(reinterpret_cast<const char*>(layer.colors.data()), layer.colors.size() * sizeof(glm::vec3));
+    }
+    return static_cast<bool>(file);
+}
+
+BakedLightBuffer::~BakedLightBuffer()
+{
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &buffer);
+}
+
+void BakedLightBuffer::SetupShader(const Shader& shader)
+{
+    shader.Use();
+    glUniform1i(glGetUniformLocation(shader(), "bakedLighting"), BAKED_LIGHTING_TEXTURE_UNIT);
+}
+
+void BakedLightBuffer::Update(const LightBaker& baker, const std::vector<char>& on)
+{
+    if (!baker.Baked())
+    {
+        return;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (buffer == 0)
+    {
+        // Everything the first time
+        colors.resize(baker.VertexCount());
+        for (GLuint object = 0; object < baker.ObjectCount(); ++object)
+        {
+            baker.Sum(object, on, colors.data() + baker.ObjectOffset(object));
+        }
+        glGenBuffers(1, &buffer);
+        glGenTextures(1, &texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max(colors.size(), static_cast<size_t>(1)) * sizeof(glm::vec4), colors.data(), GL_STATIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    else if (on != summedOn)
+    {
+        touched.assign(baker.ObjectCount(), 0);
+        for (GLuint layer = 0; layer < baker.LayerCount(); ++layer)
+        {
+            if ((layer < on.size() && on[layer]) == (layer < summedOn.size() && summedOn[layer]))
+            {
+                continue;
+            }
+            for (auto object : baker.Reached(layer))
+            {
+                if (touched[object])
+                {
+                    continue;
+                }
+                touched[object] = 1;
+                auto offset = baker.ObjectOffset(object);
+                baker.Sum(object, on, colors.data() + offset);
+                glBufferSubData(GL_TEXTURE_BUFFER, offset * sizeof(glm::vec4), baker.ObjectSize(object) * sizeof(glm::vec4), colors.data() + offset);
+            }
+        }
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    summedOn = on;
+}
+
+void BakedLightBuffer::Bind(const Shader& shader, bool use) const
+{
+    glActiveTexture(GL_TEXTURE0 + BAKED_LIGHTING_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(shader(), "useBakedLighting"), use && texture != 0);
+}
@@ -0,0 +1,178 @@
+/*
+    LightBaker.h
+
+    Bakes the point lights which never move into per-vertex colours of the
+    objects, which never move either, so the lit shaders only evaluate the
+    spot, disco and animated lights at runtime. Each light gets a layer of
+    its own over just the objects in its range: a view toggling a light
+    re-sums only those objects, and the cache on disk is kept per layer
+    under a hash of the scene and one of the light, so changing one light
+    rebakes one layer. Only ambient & diffuse are baked, specular follows
+    the viewer. The colours are laid out like the objects' meshes sit in
+    the geometry pool, every level of detail included, so a vertex finds
+    its colour at its draw's bake base plus gl_VertexID.
+
+    Cache layout, little endian:
+        BakeHeader
+        per layer: BakeLayerHeader, objectCount uint32 object indices, then
+        the objects' colours as vec3, each object's block as sized by the scene
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHT_BAKER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHT_BAKER_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "DynamicBvh.h"
+#include "GeometryPool.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "ThreadPool.h"
+
+#define BAKE_CACHE_MAGIC 0x4B425353 // "SSBK"
+#define BAKE_CACHE_VERSION 1
+
+// Texture unit the lit shaders read the baked colours from, after LightPool's
+#define BAKED_LIGHTING_TEXTURE_UNIT 4
+
+class LightBaker
+{
+public:
+    // Bakes the scene's point lights set in baked, indexed like scene.pointLights, over scene.objects,
+    // finding the objects each light reaches through tree, whose items are object indices.
+    // Layers still valid in cachePath are read from it, and the result is written back when any had
+    // to be baked. An empty cachePath skips the cache. error says what went wrong, even when only writing the cache did
+    bool Bake(const Scene& scene, const DynamicBvh& tree, const std::vector<char>& baked, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool,
+              ThreadPool& threads, const std::string& cachePath, std::string& error);
+
+    bool Baked() const
+    {
+        return !layers.empty();
+    }
+
+    // Scene point light each layer holds
+    GLuint LayerCount() const
+    {
+        return static_cast<GLuint>(layers.size());
+    }
+
+    GLuint Light(GLuint layer) const
+    {
+        return layers[layer].light;
+    }
+
+    // Layers read from the cache rather than baked by the last Bake
+    GLuint CachedLayers() const
+    {
+        return cachedLayers;
+    }
+
+    // Per object of scene.objects, for StaticBatch::SetBakeBases
+    const std::vector<GLint>& Bases() const
+    {
+        return objectBases;
+    }
+
+    // Colours in all, one per vertex of every object's levels
+    GLuint VertexCount() const
+    {
+        return vertexCount;
+    }
+
+    // The pool's generation the bases were worked out for, they're wrong once meshes move
+    GLuint PoolGeneration() const
+    {
+        return poolGeneration;
+    }
+
+    GLuint ObjectCount() const
+    {
+        return static_cast<GLuint>(objectOffsets.size());
+    }
+
+    // Where an object's colours start, and how many it has
+    GLuint ObjectOffset(GLuint object) const
+    {
+        return objectOffsets[object];
+    }
+
+    GLuint ObjectSize(GLuint object) const
+    {
+        return objectSizes[object];
+    }
+
+    // Objects a layer's light reaches
+    const std::vector<GLuint>& Reached(GLuint layer) const
+    {
+        return layers[layer].objects;
+    }
+
+    // Writes the sum of the layers set in on, indexed like the layers, into an object's ObjectSize() colours
+    void Sum(GLuint object, const std::vector<char>& on, glm::vec4* colors) const;
+
+private:
+    struct BakeLayer
+    {
+        GLuint light;
+        uint64_t hash;
+        std::vector<GLuint> objects;
+        std::vector<GLuint> offsets; // Of each object's block in colors
+        std::vector<glm::vec3> colors;
+    };
+
+    struct BakeEntry
+    {
+        GLuint layer;
+        GLuint entry; // Into the layer's objects
+    };
+
+    void layout(const Scene& scene, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool);
+    void place(BakeLayer& layer) const;
+    bool load(const std::string& path, uint64_t sceneHash, std::vector<BakeLayer>& cached) const;
+    bool save(const std::string& path, uint64_t sceneHash) const;
+
+    std::vector<BakeLayer> layers;
+    std::vector<GLuint> objectOffsets;
+    std::vector<GLuint> objectSizes;
+    std::vector<GLint> objectFirstVertices; // First pool vertex of each object's levels
+    std::vector<GLint> objectBases;
+    std::vector<std::vector<BakeEntry>> objectEntries; // Layers reaching each object
+    GLuint vertexCount = 0;
+    GLuint poolGeneration = 0;
+    GLuint cachedLayers = 0;
+};
+
+// One view's sum of the layers whose lights are on, as a texture buffer the lit shaders read
+class BakedLightBuffer
+{
+public:
+    BakedLightBuffer() = default;
+    ~BakedLightBuffer();
+
+    BakedLightBuffer(const BakedLightBuffer&) = delete;
+    BakedLightBuffer& operator=(const BakedLightBuffer&) = delete;
+
+    // Sets the lit shader's sampler to its unit, once after it is linked
+    static void SetupShader(const Shader& shader);
+
+    // on is indexed like the baker's layers. Only the objects reached by lights switched since the last call are summed again
+    void Update(const LightBaker& baker, const std::vector<char>& on);
+
+    // Binds the colours and has shader add them or not, shader must be in use
+    void Bind(const Shader& shader, bool use) const;
+
+private:
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    std::vector<char> summedOn;
+    std::vector<char> touched; // Kept to avoid reallocating on every toggle
+    std::vector<glm::vec4> colors;
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include "LightPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    // Cosines a point light's cone passes everything with, see CalcSpotLight
+    const GLfloat OPEN_CUT_OFF = -2.0f;
+    const GLfloat OPEN_OUTER_CUT_OFF = -3.0f;
+
+    const GLfloat CUT_OFF_BRIGHTNESS = 256.0f;
+
+    int plane(LightPlane plane)
+    {
+        return static_cast<int>(plane);
+    }
+
+    bool bit(const std::vector<uint32_t>& bits, GLuint index)
+    {
+        return (bits[index / 32] >> (index % 32)) & 1u;
+    }
+
+    void setBit(std::vector<uint32_t>& bits, GLuint index, bool on)
+    {
+        auto mask = 1u << (index % 32);
+        bits[index / 32] = on ? bits[index / 32] | mask : bits[index / 32] & ~mask;
+    }
+}
+
+// Solves constant + linear d + quadratic d^2 = brightest * 256 for d
+GLfloat LightRange(GLfloat constant, GLfloat linear, GLfloat quadratic, GLfloat brightest)
+{
+    auto c = constant - brightest * CUT_OFF_BRIGHTNESS;
+    if (c >= 0.0f)
+    {
+        return 0.0f;
+    }
+    if (quadratic > 0.0f)
+    {
+        return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+    }
+    return linear > 0.0f ? -c / linear : FLT_MAX;
+}
+
+void LightSwitches::SetOn(LightHandle handle, bool on)
+{
+    if (handle.slot >= offGenerations.size())
+    {
+        if (on)
+        {
+            return;
+        }
+        offGenerations.resize(handle.slot + 1, 0);
+    }
+    offGenerations[handle.slot] = on ? 0 : handle.generation;
+}
+
+LightHandle LightPool::Add(const SceneLight& light, bool spot)
+{
+    if (Count() >= MAX_POOL_LIGHTS)
+    {
+        return LightHandle();
+    }
+
+    GLuint slot;
+    if (freeSlot != UINT32_MAX)
+    {
+        slot = freeSlot;
+        freeSlot = indices[slot];
+    }
+    else
+    {
+        slot = static_cast<GLuint>(indices.size());
+        indices.push_back(0);
+        generations.push_back(0);
+    }
+    auto index = Count();
+    indices[slot] = index;
+    ++generations[slot];
+    slots.push_back(slot);
+
+    planes[plane(LightPlane::Position)].emplace_back(light.position, light.constant);
+    planes[plane(LightPlane::Direction)].emplace_back(spot ? light.direction : glm::vec3(0.0f, -1.0f, 0.0f), light.linear);
+    planes[plane(LightPlane::Ambient)].emplace_back(light.material.ambient, light.quadratic);
+    planes[plane(LightPlane::Diffuse)].emplace_back(light.material.diffuse, spot ? glm::cos(glm::radians(light.cutOff)) : OPEN_CUT_OFF);
+    planes[plane(LightPlane::Specular)].emplace_back(light.material.specular, spot ? glm::cos(glm::radians(light.outerCutOff)) : OPEN_OUTER_CUT_OFF);
+    ranges.push_back(0.0f);
+    updateRange(index);
+    if (index % 32 == 0)
+    {
+        baked.push_back(0);
+    }
+
+    markDirty(index);
+    return { slot, generations[slot] };
+}
+
+bool LightPool::Remove(LightHandle handle)
+{
+    if (!Valid(handle))
+    {
+        return false;
+    }
+    auto index = indices[handle.slot];
+    auto last = Count() - 1;
+    if (index != last)
+    {
+        for (auto& values : planes)
+        {
+            values[index] = values[last];
+        }
+        ranges[index] = ranges[last];
+        setBit(baked, index, bit(baked, last));
+        slots[index] = slots[last];
+        indices[slots[index]] = index;
+        markDirty(index);
+    }
+    for (auto& values : planes)
+    {
+        values.pop_back();
+    }
+    ranges.pop_back();
+    setBit(baked, last, false);
+    if (last % 32 == 0)
+    {
+        baked.pop_back();
+    }
+    slots.pop_back();
+
+    ++generations[handle.slot];
+    indices[handle.slot] = freeSlot;
+    freeSlot = handle.slot;
+    return true;
+}
+
+bool LightPool::Valid(LightHandle handle) const
+{
+    return handle.slot < generations.size() && generations[handle.slot] == handle.generation && handle.generation % 2 == 1;
+}
+
+GLuint LightPool::Index(LightHandle handle) const
+{
+    return Valid(handle) ? indices[handle.slot] : UINT32_MAX;
+}
+
+glm::vec3 LightPool::Direction(LightHandle handle) const
+{
+    return Valid(handle) ? glm::vec3(planes[plane(LightPlane::Direction)][indices[handle.slot]]) : glm::vec3(0.0f);
+}
+
+void LightPool::SetDirection(LightHandle handle, const glm::vec3& direction)
+{
+    if (Valid(handle))
+    {
+        auto index = indices[handle.slot];
+        auto& value = planes[plane(LightPlane::Direction)][index];
+        value = glm::vec4(direction, value.w);
+        markDirty(index);
+    }
+}
+
+void LightPool::SetPosition(LightHandle handle, const glm::vec3& position)
+{
+    if (Valid(handle))
+    {
+        auto index = indices[handle.slot];
+        auto& value = planes[plane(LightPlane::Position)][index];
+        value = glm::vec4(position, value.w);
+        markDirty(index);
+    }
+}
+
+void LightPool::SetColor(LightHandle handle, const glm::vec3& color)
+{
+    if (Valid(handle))
+    {
+        auto index = indices[handle.slot];
+        for (auto colorPlane : { LightPlane::Diffuse, LightPlane::Specular })
+        {
+            auto& value = planes[plane(colorPlane)][index];
+            value = glm::vec4(color, value.w);
+        }
+        updateRange(index);
+        markDirty(index);
+    }
+}
+
+bool LightPool::IsBaked(LightHandle handle) const
+{
+    return Valid(handle) && bit(baked, indices[handle.slot]);
+}
+
+void LightPool::SetBaked(LightHandle handle, bool baked)
+{
+    if (Valid(handle))
+    {
+        setBit(this->baked, indices[handle.slot], baked);
+    }
+}
+
+void LightPool::Write(LightHandle handle, bool on, PointLightBlock& block) const
+{
+    if (!Valid(handle))
+    {
+        block = PointLightBlock();
+        block.constant = 1.0f;
+        return;
+    }
+    auto index = indices[handle.slot];
+    auto brightness = on ? 1.0f : 0.0f;
+    const auto& position = planes[plane(LightPlane::Position)][index];
+    const auto& direction = planes[plane(LightPlane::Direction)][index];
+    const auto& ambient = planes[plane(LightPlane::Ambient)][index];
+    block.position = glm::vec3(position);
+    block.constant = position.w;
+    block.ambient = glm::vec3(ambient) * brightness;
+    block.linear = direction.w;
+    block.diffuse = glm::vec3(planes[plane(LightPlane::Diffuse)][index]) * brightness;
+    block.quadratic = ambient.w;
+    block.specular = glm::vec3(planes[plane(LightPlane::Specular)][index]) * brightness;
+}
+
+void LightPool::Write(LightHandle handle, bool on, SpotLightBlock& block) const
+{
+    if (!Valid(handle))
+    {
+        block = SpotLightBlock();
+        block.constant = 1.0f;
+        block.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+        return;
+    }
+    auto index = indices[handle.slot];
+    auto brightness = on ? 1.0f : 0.0f;
+    const auto& position = planes[plane(LightPlane::Position)][index];
+    const auto& direction = planes[plane(LightPlane::Direction)][index];
+    const auto& ambient = planes[plane(LightPlane::Ambient)][index];
+    const auto& diffuse = planes[plane(LightPlane::Diffuse)][index];
+    const auto& specular = planes[plane(LightPlane::Specular)][index];
+    block.position = glm::vec3(position);
+    block.constant = position.w;
+    block.direction = glm::vec3(direction);
+    block.linear = direction.w;
+    block.ambient = glm::vec3(ambient) * brightness;
+    block.quadratic = ambient.w;
+    block.diffuse = glm::vec3(diffuse) * brightness;
+    block.cutOff = diffuse.w;
+    block.specular = glm::vec3(specular) * brightness;
+    block.outerCutOff = specular.w;
+}
+
+void LightPool::Cull(const Frustum& frustum, GLuint first, const LightSwitches& switches, std::vector<GLint>& visible, bool skipBaked) const
+{
+    visible.clear();
+    const auto* positions = planes[plane(LightPlane::Position)].data();
+    for (auto index = first; index < Count(); ++index)
+    {
+        auto slot = slots[index];
+        if (switches.IsOn({ slot, generations[slot] }) && !(skipBaked && bit(baked, index)) &&
+            ranges[index] > 0.0f && frustum.Intersects(glm::vec3(positions[index]), ranges[index]))
+        {
+            visible.push_back(static_cast<GLint>(index));
+        }
+    }
+}
+
+void LightPool::updateRange(GLuint index)
+{
+    const auto& position = planes[plane(LightPlane::Position)][index];
+    auto constant = position.w;
+    auto linear = planes[plane(LightPlane::Direction)][index].w;
+    auto quadratic = planes[plane(LightPlane::Ambient)][index].w;
+    auto brightest = 0.0f;
+    for (auto color : { LightPlane::Ambient, LightPlane::Diffuse, LightPlane::Specular })
+    {
+        auto value = glm::vec3(planes[plane(color)][index]);
+        brightest = std::max(brightest, std::max(value.r, std::max(value.g, value.b)));
+    }
+    ranges[index] = LightRange(constant, linear, quadratic, brightest);
+}
+
+LightBuffer::~LightBuffer()
+{
+    glDeleteTextures(1, &planeTexture);
+    glDeleteBuffers(1, &planeBuffer);
+}
+
+void LightBuffer::SetupShader(const Shader& shader)
+{
+    shader.Use();
+    glUniform1i(glGetUniformLocation(shader(), "lightPlanes"), LIGHT_PLANES_TEXTURE_UNIT);
+    glUniform1i(glGetUniformLocation(shader(), "visibleLights"), VISIBLE_LIGHTS_TEXTURE_UNIT);
+}
+
+void LightBuffer::Upload(LightPool& pool)
+{
+    GLuint begin, end;
+    auto grow = planeBuffer == 0 || static_cast<GLint>(pool.Count()) > stride;
+    if (!grow && !pool.Dirty(begin, end))
+    {
+        return;
+    }
+
+    if (planeBuffer == 0)
+    {
+        glGenBuffers(1, &planeBuffer);
+        glGenTextures(1, &planeTexture);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, planeBuffer);
+    if (grow)
+    {
+        // Room to spare, so lights added later still only upload themselves
+        stride = std::max(static_cast<GLint>(pool.Count()), std::min(2 * stride, static_cast<GLint>(MAX_POOL_LIGHTS)));
+        stride = std::max(stride, 1);
+        glBufferData(GL_TEXTURE_BUFFER, stride * static_cast<GLsizeiptr>(LightPlane::Count) * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, planeTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, planeBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        begin = 0;
+        end = pool.Count();
+    }
+
+    auto planeSize = static_cast<GLintptr>(stride * sizeof(glm::vec4));
+    for (auto i = 0; i < static_cast<int>(LightPlane::Count) && begin < end; ++i)
+    {
+        glBufferSubData(GL_TEXTURE_BUFFER, i * planeSize + begin * sizeof(glm::vec4), (end - begin) * sizeof(glm::vec4),
+                        pool.Plane(static_cast<LightPlane>(i)) + begin);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    pool.ClearDirty();
+}
+
+void LightBuffer::Bind(const Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + LIGHT_PLANES_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, planeTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(shader(), "lightStride"), stride);
+}
+
+VisibleLightBuffer::~VisibleLightBuffer()
+{
+    glDeleteTextures(1, &visibleTexture);
+    glDeleteBuffers(1, &visibleBuffer);
+}
+
+void VisibleLightBuffer::Upload(const std::vector<GLint>& visible)
+{
+    auto created = visibleBuffer == 0;
+    if (created)
+    {
+        glGenBuffers(1, &visibleBuffer);
+        glGenTextures(1, &visibleTexture);
+    }
+
+    visibleCount = static_cast<GLint>(visible.size());
+    glBindBuffer(GL_TEXTURE_BUFFER, visibleBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max(visible.size(), static_cast<size_t>(1)) * sizeof(GLint), visible.empty() ? nullptr : visible.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    if (created)
+    {
+        glBindTexture(GL_TEXTURE_BUFFER, visibleTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, visibleBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void VisibleLightBuffer::Bind(const Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + VISIBLE_LIGHTS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, visibleTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(shader(), "visibleLightCount"), visibleCount);
+}
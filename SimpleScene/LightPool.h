@@ -0,0 +1,197 @@
+/*
+    LightPool.h
+
+    Every light of the scene in structure-of-arrays form, shared by all the
+    views. Point and spot lights share one layout, a point light is a spot
+    whose cone lets everything through. Lights are packed at the front of
+    each array and removing one moves the last into its place, so handles
+    carry a generation and go stale once their light is removed. The arrays
+    are vec4 planes with each vec3 paired with a float, in the order of
+    SpotLightBlock's members, so LightBuffer uploads them as they are into a
+    texture buffer. The pool tracks which indices changed since the last
+    upload. Which lights are on is up to each view, kept in LightSwitches.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHT_POOL_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHT_POOL_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "FrameData.h"
+#include "Frustum.h"
+#include "Scene.h"
+#include "Shader.h"
+
+// GL only guarantees 65536 texels in a texture buffer, enough for every plane of this many
+#define MAX_POOL_LIGHTS 12288
+
+// Texture units the lit shaders read the pool from, clear of the post passes' 0 & 1
+#define LIGHT_PLANES_TEXTURE_UNIT 2
+#define VISIBLE_LIGHTS_TEXTURE_UNIT 3
+
+enum class LightPlane
+{
+    Position, // w is the constant term
+    Direction, // w is the linear term
+    Ambient, // w is the quadratic term
+    Diffuse, // w is the cosine of the cut off
+    Specular, // w is the cosine of the outer cut off
+    Count
+};
+
+// Distance past which a light of this attenuation and brightest colour channel adds under 1/256
+GLfloat LightRange(GLfloat constant, GLfloat linear, GLfloat quadratic, GLfloat brightest);
+
+struct LightHandle
+{
+    GLuint slot = 0;
+    GLuint generation = 0; // 0 is never handed out, so a default handle is always stale
+};
+
+// Which of a pool's lights one view has switched off, every light is on until then.
+// Kept per slot with the generation switched off, so a reused slot starts out on again
+class LightSwitches
+{
+public:
+    bool IsOn(LightHandle handle) const
+    {
+        return handle.slot >= offGenerations.size() || offGenerations[handle.slot] != handle.generation;
+    }
+
+    void SetOn(LightHandle handle, bool on);
+
+    void Toggle(LightHandle handle)
+    {
+        SetOn(handle, !IsOn(handle));
+    }
+
+private:
+    std::vector<GLuint> offGenerations; // 0 where the slot's light is on
+};
+
+class LightPool
+{
+public:
+    // A point light when spot is false, cutOff & outerCutOff are then ignored. Stale when the pool is full
+    LightHandle Add(const SceneLight& light, bool spot);
+    bool Remove(LightHandle handle);
+    bool Valid(LightHandle handle) const;
+
+    // Where the light sits in the planes, only until the next Remove
+    GLuint Index(LightHandle handle) const;
+
+    GLuint Count() const
+    {
+        return static_cast<GLuint>(slots.size());
+    }
+
+    // Count() entries
+    const glm::vec4* Plane(LightPlane plane) const
+    {
+        return planes[static_cast<int>(plane)].data();
+    }
+
+    glm::vec3 Direction(LightHandle handle) const;
+    void SetDirection(LightHandle handle, const glm::vec3& direction);
+    void SetPosition(LightHandle handle, const glm::vec3& position);
+
+    // Diffuse & specular
+    void SetColor(LightHandle handle, const glm::vec3& color);
+
+    // Baked lights are still written, but Cull leaves them out when asked to
+    bool IsBaked(LightHandle handle) const;
+    void SetBaked(LightHandle handle, bool baked);
+
+    // Into the Lights block's slots, black when the view has the light off
+    void Write(LightHandle handle, bool on, PointLightBlock& block) const;
+    void Write(LightHandle handle, bool on, SpotLightBlock& block) const;
+
+    // Indices from first on of the lights switches has on which reach into frustum, not baked ones with skipBaked
+    void Cull(const Frustum& frustum, GLuint first, const LightSwitches& switches, std::vector<GLint>& visible, bool skipBaked = false) const;
+
+    // Indices [begin, end) changed since ClearDirty, false if none did
+    bool Dirty(GLuint& begin, GLuint& end) const
+    {
+        begin = dirtyBegin;
+        end = std::min(dirtyEnd, Count());
+        return begin < end;
+    }
+
+    void ClearDirty()
+    {
+        dirtyBegin = UINT32_MAX;
+        dirtyEnd = 0;
+    }
+
+private:
+    void updateRange(GLuint index);
+    void markDirty(GLuint index)
+    {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+    }
+
+    std::vector<glm::vec4> planes[static_cast<int>(LightPlane::Count)];
+    std::vector<GLfloat> ranges; // Beyond which a light adds under 1/256
+    std::vector<uint32_t> baked; // One bit per light
+    std::vector<GLuint> slots; // Slot of each light
+    std::vector<GLuint> indices; // Index of each slot, or the next free slot when it is free
+    std::vector<GLuint> generations; // Of each slot, odd while it holds a light
+    GLuint freeSlot = UINT32_MAX;
+    GLuint dirtyBegin = UINT32_MAX;
+    GLuint dirtyEnd = 0;
+};
+
+// The planes of a pool as a texture buffer the lit shaders read, one for all the views
+class LightBuffer
+{
+public:
+    LightBuffer() = default;
+    ~LightBuffer();
+
+    LightBuffer(const LightBuffer&) = delete;
+    LightBuffer& operator=(const LightBuffer&) = delete;
+
+    // Sets the lit shader's samplers to their units, once after it is linked
+    static void SetupShader(const Shader& shader);
+
+    // Uploads the lights pool changed since the last call, all of them when the buffer has to grow
+    void Upload(LightPool& pool);
+
+    // Binds the planes and sets shader's stride, shader must be in use
+    void Bind(const Shader& shader) const;
+
+private:
+    GLuint planeBuffer = 0;
+    GLuint planeTexture = 0;
+    GLint stride = 0; // Lights the buffer has room for in each plane
+};
+
+// The indices of one view's visible lights, as a texture buffer the lit shaders read
+class VisibleLightBuffer
+{
+public:
+    VisibleLightBuffer() = default;
+    ~VisibleLightBuffer();
+
+    VisibleLightBuffer(const VisibleLightBuffer&) = delete;
+    VisibleLightBuffer& operator=(const VisibleLightBuffer&) = delete;
+
+    void Upload(const std::vector<GLint>& visible);
+
+    // Binds the indices and sets shader's count, shader must be in use
+    void Bind(const Shader& shader) const;
+
+private:
+    GLuint visibleBuffer = 0;
+    GLuint visibleTexture = 0;
+    GLint visibleCount = 0;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*
+    Lighting.h
+
+    The Phong model of smooth_shader.frag on the CPU, one function per GLSL
+    function and written the same way, so a change to one is easy to carry
+    over to the other. Lights come in their uniform block layout. This is the
+    reference for LightingKernel.h, which runs the same maths over batches.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHTING_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHTING_H_INCLUDED
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "FrameData.h"
+#include "Material.h"
+
+// The shaders' DirLight, unused by the scene but kept alongside the others
+struct DirLightData
+{
+    glm::vec3 direction;
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+};
+
+// Calculates the color when using a directional light.
+inline glm::vec3 CalcDirLight(const DirLightData& light, const Material& material, const glm::vec3& normal, const glm::vec3& viewDir)
+{
+    auto lightDir = glm::normalize(-light.direction);
+    // Diffuse shading
+    auto diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    // Specular shading
+    auto reflectDir = glm::reflect(-lightDir, normal);
+    auto spec = std::pow(glm::max(glm::dot(viewDir, reflectDir), 0.0f), material.shininess);
+    // Combine results
+    auto ambient = light.ambient * material.ambient;
+    auto diffuse = light.diffuse * diff * material.diffuse;
+    auto specular = light.specular * spec * material.specular;
+    return (ambient + diffuse + specular);
+}
+
+// Calculates the color when using a point light.
+inline glm::vec3 CalcPointLight(const PointLightBlock& light, const Material& material, const glm::vec3& normal, const glm::vec3& fragPos, const glm::vec3& viewDir)
+{
+    auto lightDir = glm::normalize(light.position - fragPos);
+    // Diffuse shading
+    auto diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    // Specular shading
+    auto reflectDir = glm::reflect(-lightDir, normal);
+    auto spec = std::pow(glm::max(glm::dot(viewDir, reflectDir), 0.0f), material.shininess);
+    // Attenuation
+    auto distance = glm::length(light.position - fragPos);
+    auto attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // Combine results
+    auto ambient = light.ambient * material.ambient;
+    auto diffuse = light.diffuse * diff * material.diffuse;
+    auto specular = light.specular * spec * material.specular;
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+// Calculates the color when using a spot light.
+inline glm::vec3 CalcSpotLight(const SpotLightBlock& light, const Material& material, const glm::vec3& normal, const glm::vec3& fragPos, const glm::vec3& viewDir)
+{
+    auto lightDir = glm::normalize(light.position - fragPos);
+    // Diffuse shading
+    auto diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    // Specular shading
+    auto reflectDir = glm::reflect(-lightDir, normal);
+    auto spec = std::pow(glm::max(glm::dot(viewDir, reflectDir), 0.0f), material.shininess);
+    // Attenuation
+    auto distance = glm::length(light.position - fragPos);
+    auto attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // Spotlight intensity
+    auto theta = glm::dot(lightDir, glm::normalize(-light.direction));
+    auto epsilon = light.cutOff - light.outerCutOff;
+    auto intensity = glm::clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
+    // Combine results
+    auto ambient = light.ambient * material.ambient;
+    auto diffuse = light.diffuse * diff * material.diffuse;
+    auto specular = light.specular * spec * material.specular;
+    return (ambient + diffuse + specular) * (attenuation * intensity);
+}
+
+// Sum over every light in the block, the body of main() in the shaders
+inline glm::vec3 CalcLighting(const LightBlock& lights, const Material& material, const glm::vec3& normal, const glm::vec3& fragPos, const glm::vec3& viewPos)
+{
+    auto norm = glm::normalize(normal);
+    auto viewDir = glm::normalize(viewPos - fragPos);
+    glm::vec3 result(0.0f);
+    for (const auto& light : lights.pointLights)
+    {
+        result += CalcPointLight(light, material, norm, fragPos, viewDir);
+    }
+    result += CalcSpotLight(lights.spotLight, material, norm, fragPos, viewDir);
+    for (const auto& light : lights.discoLights)
+    {
+        result += CalcSpotLight(light, material, norm, fragPos, viewDir);
+    }
+    return result;
+}
+
+#endif
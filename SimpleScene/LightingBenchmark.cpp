@@ -0,0 +1,119 @@
+#include "LightingBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "LightingKernel.h"
+#include "LightProperties.h"
+
+namespace
+{
+    const size_t VERTEX_COUNT = 1 << 16;
+    const double MIN_SECONDS = 0.25;
+
+    struct Case
+    {
+        std::string name;
+        LightSet lights;
+    };
+
+    std::vector<Case> benchmarkCases()
+    {
+        PointLightBlock point = { lightPositions[0], lightConstant, lightMaterials[0].ambient, lightAttenuation[1][0],
+                                  lightMaterials[0].diffuse, lightAttenuation[1][1], lightMaterials[0].specular, 0.0f };
+        SpotLightBlock spot = { spotLightPos, lightConstant, glm::normalize(spotLightDir), spotLightAttenuation[0],
+                                spotLightMaterial.ambient, spotLightAttenuation[1], spotLightMaterial.diffuse, glm::cos(glm::radians(spotLightCutOff)),
+                                spotLightMaterial.specular, glm::cos(glm::radians(spotLightOuterCutOff)) };
+        DirLightData dir = { glm::vec3(-0.2f, -1.0f, -0.3f), glm::vec3(0.05f), glm::vec3(0.4f), glm::vec3(0.5f) };
+
+        std::vector<Case> cases(4);
+        cases[0].name = "directional";
+        cases[0].lights.dirLights.push_back(dir);
+        cases[1].name = "point";
+        cases[1].lights.pointLights.push_back(point);
+        cases[2].name = "spot";
+        cases[2].lights.spotLights.push_back(spot);
+        // The scene's set: 2 point lights, the spot light and 4 disco lights
+        cases[3].name = "scene (7 lights)";
+        cases[3].lights.pointLights.assign(2, point);
+        cases[3].lights.spotLights.assign(5, spot);
+        return cases;
+    }
+}
+
+void RunLightingBenchmark(std::ostream& out)
+{
+    // Points spread through the room with random normals
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<GLfloat> unit(-1.0f, 1.0f);
+    std::vector<GLfloat> soa[9];
+    for (auto& array : soa)
+    {
+        array.resize(VERTEX_COUNT);
+    }
+    for (size_t i = 0; i < VERTEX_COUNT; ++i)
+    {
+        for (auto k = 0; k < 3; ++k)
+        {
+            soa[k][i] = unit(random);
+            soa[3 + k][i] = unit(random);
+        }
+    }
+    std::vector<GLfloat> reference[3];
+    for (auto& array : reference)
+    {
+        array.resize(VERTEX_COUNT);
+    }
+
+    Material material(glm::vec3(0.2f, 0.1f, 0.1f), glm::vec3(0.8f, 0.3f, 0.3f), glm::vec3(0.5f), 32.0f);
+    glm::vec3 viewPos(0.0f, 0.0f, 3.0f);
+    ShadingBatch batch = { { soa[0].data(), soa[1].data(), soa[2].data() }, { soa[3].data(), soa[4].data(), soa[5].data() },
+                           { soa[6].data(), soa[7].data(), soa[8].data() }, VERTEX_COUNT };
+    ShadingBatch referenceBatch = batch;
+    for (auto k = 0; k < 3; ++k)
+    {
+        referenceBatch.color[k] = reference[k].data();
+    }
+
+    std::vector<LightingIsa> isas = { LightingIsa::Scalar, LightingIsa::SSE };
+    if (BestLightingIsa() == LightingIsa::AVX2)
+    {
+        isas.push_back(LightingIsa::AVX2);
+    }
+
+    out << "Lighting kernel, " << VERTEX_COUNT << " vertices per batch, one thread" << std::endl;
+    for (const auto& test : benchmarkCases())
+    {
+        ShadeBatch(test.lights, material, viewPos, referenceBatch, LightingIsa::Scalar);
+        auto lightCount = test.lights.dirLights.size() + test.lights.pointLights.size() + test.lights.spotLights.size();
+        for (auto isa : isas)
+        {
+            size_t vertices = 0;
+            auto start = std::chrono::steady_clock::now();
+            double seconds;
+            do
+            {
+                ShadeBatch(test.lights, material, viewPos, batch, isa);
+                vertices += VERTEX_COUNT;
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (seconds < MIN_SECONDS);
+
+            GLfloat maxError = 0.0f;
+            for (auto k = 0; k < 3; ++k)
+            {
+                for (size_t i = 0; i < VERTEX_COUNT; ++i)
+                {
+                    maxError = std::max(maxError, std::abs(batch.color[k][i] - reference[k][i]));
+                }
+            }
+
+            out << "  " << test.name << ", " << LightingIsaName(isa) << ": "
+                << vertices / seconds / 1e6 << " M vertices/s, "
+                << vertices * lightCount / seconds / 1e6
+                << " M vertex-lights/s, max error " << maxError << std::endl;
+        }
+    }
+}
@@ -0,0 +1,17 @@
+/*
+    LightingBenchmark.h
+
+    Single-threaded throughput of the lighting kernel per light type and
+    instruction set, in vertices per second, checked against the scalar
+    reference. Run with --benchmark-lighting, no window is opened.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHTING_BENCHMARK_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHTING_BENCHMARK_H_INCLUDED
+
+#include <ostream>
+
+void RunLightingBenchmark(std::ostream& out);
+
+#endif
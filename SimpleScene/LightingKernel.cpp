@@ -0,0 +1,162 @@
+#include "LightingKernel.h"
+
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include "LightingKernelSimd.h"
+
+namespace
+{
+    struct SseOps
+    {
+        typedef __m128 Float;
+        static const size_t Width = 4;
+
+        static Float Set(float x) { return _mm_set1_ps(x); }
+        static Float Load(const float* p) { return _mm_loadu_ps(p); }
+        static void Store(float* p, Float x) { _mm_storeu_ps(p, x); }
+        static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+        static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+        static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+        static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+        static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+        static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+        static Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+
+        // Exponent from the bits, polynomial over the mantissa in [1, 2)
+        static Float Log2(Float x)
+        {
+            auto bits = _mm_castps_si128(x);
+            auto exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            auto m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+            return Add(Mul(LIGHTING_LOG2_POLY(m), Sub(m, Set(1.0f))), exponent);
+        }
+
+        // Integer part into the exponent bits, polynomial over the fraction
+        static Float Exp2(Float x)
+        {
+            x = Max(Min(x, Set(129.0f)), Set(-126.99999f));
+            auto whole = _mm_cvtps_epi32(Sub(x, Set(0.5f)));
+            auto f = Sub(x, _mm_cvtepi32_ps(whole));
+            auto scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+            return Mul(scale, LIGHTING_EXP2_POLY(f));
+        }
+    };
+
+    bool cpuSupportsAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        auto osxsave = (info[2] & (1 << 27)) != 0;
+        auto avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        auto avx2 = (info[1] & (1 << 5)) != 0;
+        // The OS has to save the upper halves of the YMM registers
+        return osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6;
+#else
+        unsigned a, b, c, d;
+        if (!__get_cpuid(1, &a, &b, &c, &d))
+        {
+            return false;
+        }
+        auto osxsave = (c & (1u << 27)) != 0;
+        auto avx = (c & (1u << 28)) != 0;
+        if (!osxsave || !avx || !__get_cpuid_count(7, 0, &a, &b, &c, &d) || (b & (1u << 5)) == 0)
+        {
+            return false;
+        }
+        // The OS has to save the upper halves of the YMM registers
+        unsigned xcr0, xcr0High;
+        __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        return (xcr0 & 6) == 6;
+#endif
+    }
+}
+
+LightingIsa BestLightingIsa()
+{
+    static const auto best = Avx2KernelCompiled() && cpuSupportsAvx2() ? LightingIsa::AVX2 : LightingIsa::SSE;
+    return best;
+}
+
+const char* LightingIsaName(LightingIsa isa)
+{
+    switch (isa)
+    {
+    case LightingIsa::AVX2:
+        return "AVX2";
+    case LightingIsa::SSE:
+        return "SSE";
+    default:
+        return "scalar";
+    }
+}
+
+LightSet::LightSet(const LightBlock& lights)
+    : pointLights(std::begin(lights.pointLights), std::end(lights.pointLights))
+{
+    spotLights.push_back(lights.spotLight);
+    spotLights.insert(spotLights.end(), std::begin(lights.discoLights), std::end(lights.discoLights));
+}
+
+size_t ShadeBatchSse(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch)
+{
+    return LightingKernelSimd<SseOps>::Shade(lights, material, viewPos, batch);
+}
+
+void ShadeBatch(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch, LightingIsa isa)
+{
+    size_t done = 0;
+    if (isa == LightingIsa::AVX2)
+    {
+        done = ShadeBatchAvx2(lights, material, viewPos, batch);
+    }
+    if (isa != LightingIsa::Scalar)
+    {
+        // Whatever is left is narrower than an AVX2 vector, SSE can still take some of it
+        ShadingBatch rest = batch;
+        for (auto k = 0; k < 3; ++k)
+        {
+            rest.position[k] += done;
+            rest.normal[k] += done;
+            rest.color[k] += done;
+        }
+        rest.count -= done;
+        done += ShadeBatchSse(lights, material, viewPos, rest);
+    }
+
+    // Scalar path and the tail, straight from Lighting.h
+    for (auto i = done; i < batch.count; ++i)
+    {
+        auto fragPos = glm::vec3(batch.position[0][i], batch.position[1][i], batch.position[2][i]);
+        auto norm = glm::normalize(glm::vec3(batch.normal[0][i], batch.normal[1][i], batch.normal[2][i]));
+        auto viewDir = glm::normalize(viewPos - fragPos);
+        glm::vec3 result(0.0f);
+        for (const auto& light : lights.dirLights)
+        {
+            result += CalcDirLight(light, material, norm, viewDir);
+        }
+        for (const auto& light : lights.pointLights)
+        {
+            result += CalcPointLight(light, material, norm, fragPos, viewDir);
+        }
+        for (const auto& light : lights.spotLights)
+        {
+            result += CalcSpotLight(light, material, norm, fragPos, viewDir);
+        }
+        batch.color[0][i] = result.x;
+        batch.color[1][i] = result.y;
+        batch.color[2][i] = result.z;
+    }
+}
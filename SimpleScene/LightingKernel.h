@@ -0,0 +1,60 @@
+/*
+    LightingKernel.h
+
+    Lighting.h over structure-of-arrays batches, 4 entries at a time with SSE
+    or 8 with AVX2 and one at a time otherwise. Used wherever the CPU lights
+    many points with one material: the software rasterizer, vertex lighting
+    and baking. The scalar path is Lighting.h itself, so it doubles as the
+    reference the vector paths are checked against.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHTING_KERNEL_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHTING_KERNEL_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "FrameData.h"
+#include "Lighting.h"
+#include "Material.h"
+
+enum class LightingIsa
+{
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// Widest instruction set this CPU and OS support, checked once
+LightingIsa BestLightingIsa();
+const char* LightingIsaName(LightingIsa isa);
+
+// The lights a batch is lit by, every kind summed as in the shaders' main()
+struct LightSet
+{
+    std::vector<DirLightData> dirLights;
+    std::vector<PointLightBlock> pointLights;
+    std::vector<SpotLightBlock> spotLights;
+
+    LightSet() = default;
+
+    // The point lights, then the spot light followed by the disco lights
+    explicit LightSet(const LightBlock& lights);
+};
+
+// count entries per array. Normals need not be normalized, colors are overwritten
+struct ShadingBatch
+{
+    const GLfloat* position[3];
+    const GLfloat* normal[3];
+    GLfloat* color[3];
+    size_t count;
+};
+
+void ShadeBatch(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch, LightingIsa isa = BestLightingIsa());
+
+#endif
@@ -0,0 +1,74 @@
+/*
+    Built with AVX2 code generation enabled for this file only, see the
+    project file. Nothing here runs unless BestLightingIsa() found AVX2.
+*/
+
+#include "LightingKernel.h"
+#include "LightingKernelSimd.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx2Ops
+    {
+        typedef __m256 Float;
+        static const size_t Width = 8;
+
+        static Float Set(float x) { return _mm256_set1_ps(x); }
+        static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+        static void Store(float* p, Float x) { _mm256_storeu_ps(p, x); }
+        static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+        static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+        static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+        static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+        static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+        static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+        static Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+
+        // Exponent from the bits, polynomial over the mantissa in [1, 2)
+        static Float Log2(Float x)
+        {
+            auto bits = _mm256_castps_si256(x);
+            auto exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+            auto m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+            return Add(Mul(LIGHTING_LOG2_POLY(m), Sub(m, Set(1.0f))), exponent);
+        }
+
+        // Integer part into the exponent bits, polynomial over the fraction
+        static Float Exp2(Float x)
+        {
+            x = Max(Min(x, Set(129.0f)), Set(-126.99999f));
+            auto whole = _mm256_cvtps_epi32(Sub(x, Set(0.5f)));
+            auto f = Sub(x, _mm256_cvtepi32_ps(whole));
+            auto scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(whole, _mm256_set1_epi32(127)), 23));
+            return Mul(scale, LIGHTING_EXP2_POLY(f));
+        }
+    };
+}
+
+size_t ShadeBatchAvx2(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch)
+{
+    return LightingKernelSimd<Avx2Ops>::Shade(lights, material, viewPos, batch);
+}
+
+bool Avx2KernelCompiled()
+{
+    return true;
+}
+
+#else
+
+size_t ShadeBatchAvx2(const LightSet&, const Material&, const glm::vec3&, const ShadingBatch&)
+{
+    return 0;
+}
+
+bool Avx2KernelCompiled()
+{
+    return false;
+}
+
+#endif
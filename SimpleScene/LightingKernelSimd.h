@@ -0,0 +1,173 @@
+/*
+    LightingKernelSimd.h
+
+    The body of the vector paths of LightingKernel.h, written once against an
+    Ops type wrapping one instruction set. Only included by the translation
+    unit compiled for that instruction set.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LIGHTING_KERNEL_SIMD_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LIGHTING_KERNEL_SIMD_H_INCLUDED
+
+#include "LightingKernel.h"
+
+// Ops provides Float, Width, Set, Load, Store, Add, Sub, Mul, Div, Min, Max, Sqrt, Log2 and Exp2
+template <typename Ops>
+struct LightingKernelSimd
+{
+    typedef typename Ops::Float F;
+
+    struct V3
+    {
+        F x, y, z;
+    };
+
+    static V3 set(const glm::vec3& v)
+    {
+        return { Ops::Set(v.x), Ops::Set(v.y), Ops::Set(v.z) };
+    }
+
+    static V3 add(const V3& a, const V3& b)
+    {
+        return { Ops::Add(a.x, b.x), Ops::Add(a.y, b.y), Ops::Add(a.z, b.z) };
+    }
+
+    static V3 sub(const V3& a, const V3& b)
+    {
+        return { Ops::Sub(a.x, b.x), Ops::Sub(a.y, b.y), Ops::Sub(a.z, b.z) };
+    }
+
+    static V3 scale(const V3& a, F s)
+    {
+        return { Ops::Mul(a.x, s), Ops::Mul(a.y, s), Ops::Mul(a.z, s) };
+    }
+
+    static F dot(const V3& a, const V3& b)
+    {
+        return Ops::Add(Ops::Add(Ops::Mul(a.x, b.x), Ops::Mul(a.y, b.y)), Ops::Mul(a.z, b.z));
+    }
+
+    static F length(const V3& a)
+    {
+        return Ops::Sqrt(dot(a, a));
+    }
+
+    static V3 normalize(const V3& a)
+    {
+        return scale(a, Ops::Div(Ops::Set(1.0f), length(a)));
+    }
+
+    // reflect(i, n) = i - 2 * dot(n, i) * n
+    static V3 reflect(const V3& i, const V3& n)
+    {
+        return sub(i, scale(n, Ops::Mul(Ops::Set(2.0f), dot(n, i))));
+    }
+
+    static F pow(F x, F y)
+    {
+        return Ops::Exp2(Ops::Mul(y, Ops::Log2(Ops::Max(x, Ops::Set(1e-30f)))));
+    }
+
+    // ambient + diff * diffuse + spec * specular, the tail shared by every light
+    static V3 combine(const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, F diff, F spec)
+    {
+        return {
+            Ops::Add(Ops::Set(ambient.x), Ops::Add(Ops::Mul(diff, Ops::Set(diffuse.x)), Ops::Mul(spec, Ops::Set(specular.x)))),
+            Ops::Add(Ops::Set(ambient.y), Ops::Add(Ops::Mul(diff, Ops::Set(diffuse.y)), Ops::Mul(spec, Ops::Set(specular.y)))),
+            Ops::Add(Ops::Set(ambient.z), Ops::Add(Ops::Mul(diff, Ops::Set(diffuse.z)), Ops::Mul(spec, Ops::Set(specular.z))))
+        };
+    }
+
+    static F attenuation(GLfloat constant, GLfloat linear, GLfloat quadratic, F distance)
+    {
+        auto denominator = Ops::Add(Ops::Set(constant), Ops::Add(Ops::Mul(Ops::Set(linear), distance), Ops::Mul(Ops::Set(quadratic), Ops::Mul(distance, distance))));
+        return Ops::Div(Ops::Set(1.0f), denominator);
+    }
+
+    static V3 dirLight(const DirLightData& light, const Material& material, const V3& normal, const V3& viewDir)
+    {
+        auto lightDir = set(glm::normalize(-light.direction));
+        auto diff = Ops::Max(dot(normal, lightDir), Ops::Set(0.0f));
+        auto reflectDir = reflect(sub(set(glm::vec3(0.0f)), lightDir), normal);
+        auto spec = pow(Ops::Max(dot(viewDir, reflectDir), Ops::Set(0.0f)), Ops::Set(material.shininess));
+        return combine(light.ambient * material.ambient, light.diffuse * material.diffuse, light.specular * material.specular, diff, spec);
+    }
+
+    static V3 pointLight(const PointLightBlock& light, const Material& material, const V3& normal, const V3& fragPos, const V3& viewDir)
+    {
+        auto toLight = sub(set(light.position), fragPos);
+        auto distance = length(toLight);
+        auto lightDir = scale(toLight, Ops::Div(Ops::Set(1.0f), distance));
+        auto diff = Ops::Max(dot(normal, lightDir), Ops::Set(0.0f));
+        auto reflectDir = reflect(sub(set(glm::vec3(0.0f)), lightDir), normal);
+        auto spec = pow(Ops::Max(dot(viewDir, reflectDir), Ops::Set(0.0f)), Ops::Set(material.shininess));
+        auto color = combine(light.ambient * material.ambient, light.diffuse * material.diffuse, light.specular * material.specular, diff, spec);
+        return scale(color, attenuation(light.constant, light.linear, light.quadratic, distance));
+    }
+
+    static V3 spotLight(const SpotLightBlock& light, const Material& material, const V3& normal, const V3& fragPos, const V3& viewDir)
+    {
+        auto toLight = sub(set(light.position), fragPos);
+        auto distance = length(toLight);
+        auto lightDir = scale(toLight, Ops::Div(Ops::Set(1.0f), distance));
+        auto diff = Ops::Max(dot(normal, lightDir), Ops::Set(0.0f));
+        auto reflectDir = reflect(sub(set(glm::vec3(0.0f)), lightDir), normal);
+        auto spec = pow(Ops::Max(dot(viewDir, reflectDir), Ops::Set(0.0f)), Ops::Set(material.shininess));
+        auto theta = dot(lightDir, set(glm::normalize(-light.direction)));
+        auto epsilon = Ops::Set(light.cutOff - light.outerCutOff);
+        auto intensity = Ops::Min(Ops::Max(Ops::Div(Ops::Sub(theta, Ops::Set(light.outerCutOff)), epsilon), Ops::Set(0.0f)), Ops::Set(1.0f));
+        auto color = combine(light.ambient * material.ambient, light.diffuse * material.diffuse, light.specular * material.specular, diff, spec);
+        return scale(color, Ops::Mul(attenuation(light.constant, light.linear, light.quadratic, distance), intensity));
+    }
+
+    // Shades whole vectors from the start of the batch and returns how many entries it covered
+    static size_t Shade(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch)
+    {
+        auto eye = set(viewPos);
+        size_t i = 0;
+        for (; i + Ops::Width <= batch.count; i += Ops::Width)
+        {
+            V3 fragPos = { Ops::Load(batch.position[0] + i), Ops::Load(batch.position[1] + i), Ops::Load(batch.position[2] + i) };
+            V3 normal = { Ops::Load(batch.normal[0] + i), Ops::Load(batch.normal[1] + i), Ops::Load(batch.normal[2] + i) };
+            normal = normalize(normal);
+            auto viewDir = normalize(sub(eye, fragPos));
+
+            auto result = set(glm::vec3(0.0f));
+            for (const auto& light : lights.dirLights)
+            {
+                result = add(result, dirLight(light, material, normal, viewDir));
+            }
+            for (const auto& light : lights.pointLights)
+            {
+                result = add(result, pointLight(light, material, normal, fragPos, viewDir));
+            }
+            for (const auto& light : lights.spotLights)
+            {
+                result = add(result, spotLight(light, material, normal, fragPos, viewDir));
+            }
+
+            Ops::Store(batch.color[0] + i, result.x);
+            Ops::Store(batch.color[1] + i, result.y);
+            Ops::Store(batch.color[2] + i, result.z);
+        }
+        return i;
+    }
+};
+
+// Polynomial log2 and exp2 shared by the vector paths, accurate to about 1e-6 relative,
+// in the same spirit as the GPU's own pow
+#define LIGHTING_LOG2_POLY(m) \
+    Add(Mul(Add(Mul(Add(Mul(Add(Mul(Add(Mul(Set(-3.4436006e-2f), m), Set(3.1821337e-1f)), m), Set(-1.2315303f)), m), Set(2.5988452f)), m), Set(-3.3241990f)), m), Set(3.1157899f))
+
+#define LIGHTING_EXP2_POLY(f) \
+    Add(Mul(Add(Mul(Add(Mul(Add(Mul(Add(Mul(Set(1.8775767e-3f), f), Set(8.9893397e-3f)), f), Set(5.5826318e-2f)), f), Set(2.4015361e-1f)), f), Set(6.9315308e-1f)), f), Set(9.9999994e-1f))
+
+// Vector paths, each returns how many entries from the start of the batch it shaded
+size_t ShadeBatchSse(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch);
+size_t ShadeBatchAvx2(const LightSet& lights, const Material& material, const glm::vec3& viewPos, const ShadingBatch& batch);
+
+// False if the compiler was not allowed to emit AVX2 for LightingKernelAvx2.cpp
+bool Avx2KernelCompiled();
+
+#endif
@@ -0,0 +1,67 @@
+/*
+    Lod.h
+
+    Level-of-detail selection from an object's projected size on screen.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_LOD_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_LOD_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// How far past a threshold the projected radius has to go before the level changes
+const GLfloat LOD_HYSTERESIS = 0.15f;
+
+// Aim for tessellated edges of about this many pixels
+const GLfloat LOD_PIXELS_PER_SEGMENT = 6.0f;
+
+struct LodLevel
+{
+    GLuint mesh;
+    GLfloat maxPixelRadius; // Level is fine enough up to this projected radius
+};
+
+// Largest projected radius at which a curved surface with this many segments still looks round
+inline GLfloat LodMaxPixelRadius(int segments)
+{
+    return segments * LOD_PIXELS_PER_SEGMENT / (2.0f * glm::pi<GLfloat>());
+}
+
+// Radius in pixels of a world space bounding sphere, works for both perspective and ortho projections
+inline GLfloat ProjectedRadius(const glm::vec3& center, GLfloat radius, const glm::mat4& view, const glm::mat4& projection, GLfloat viewportHeight)
+{
+    auto w = 1.0f;
+    if (projection[3][3] == 0.0f)
+    {
+        // Perspective, the clip w is the distance along the view direction
+        auto viewCenter = view * glm::vec4(center, 1.0f);
+        w = glm::max(-viewCenter.z - radius, 0.01f);
+    }
+    return radius * projection[1][1] * viewportHeight * 0.5f / w;
+}
+
+// Steps from the current level towards the one the projected radius needs, finest level first in levels
+inline GLuint SelectLodLevel(const std::vector<LodLevel>& levels, GLuint current, GLfloat pixelRadius)
+{
+    auto count = static_cast<GLuint>(levels.size());
+    if (current >= count)
+    {
+        current = 0;
+    }
+    while (current + 1 < count && pixelRadius < levels[current + 1].maxPixelRadius * (1.0f - LOD_HYSTERESIS))
+    {
+        ++current;
+    }
+    while (current > 0 && pixelRadius > levels[current].maxPixelRadius * (1.0f + LOD_HYSTERESIS))
+    {
+        --current;
+    }
+    return current;
+}
+
+#endif
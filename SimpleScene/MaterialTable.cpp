@@ -0,0 +1,56 @@
+#include "MaterialTable.h"
+
+#include <iostream>
+
+MaterialTable::~MaterialTable()
+{
+    glDeleteBuffers(2, buffers);
+}
+
+GLuint MaterialTable::Add(const Material& material, const Material& tracked)
+{
+    if (materials.size() >= MAX_MATERIALS)
+    {
+        std::cout << "ERROR::MATERIAL_TABLE::FULL" << std::endl;
+        return MAX_MATERIALS - 1;
+    }
+
+    materials.push_back(material);
+    trackedMaterials.push_back(tracked);
+    return static_cast<GLuint>(materials.size() - 1);
+}
+
+void MaterialTable::Upload()
+{
+    const std::vector<Material>* tables[2] = { &materials, &trackedMaterials };
+
+    if (buffers[0] == 0)
+    {
+        glGenBuffers(2, buffers);
+    }
+
+    for (auto i = 0; i < 2; ++i)
+    {
+        std::vector<MaterialBlock> blocks;
+        blocks.reserve(tables[i]->size());
+        for (const auto& material : *tables[i])
+        {
+            blocks.push_back({
+                glm::vec4(material.ambient, 0.0f),
+                glm::vec4(material.diffuse, 0.0f),
+                glm::vec4(material.specular, material.shininess)
+            });
+        }
+
+        // The block is declared with MAX_MATERIALS entries, so the buffer has to be that big
+        glBindBuffer(GL_UNIFORM_BUFFER, buffers[i]);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(MaterialBlock), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, blocks.size() * sizeof(MaterialBlock), blocks.data());
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void MaterialTable::Bind(bool useColorTracking) const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, buffers[useColorTracking ? 1 : 0]);
+}
@@ -0,0 +1,57 @@
+/*
+    MaterialTable.h
+
+    Every Material in the scene lives once in a uniform buffer. Draws only pass
+    an index into it, and colour tracking switches to a second table.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_MATERIAL_TABLE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_MATERIAL_TABLE_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Material.h"
+
+// Must match the Materials block and NR_MATERIALS in the shaders
+#define MATERIAL_BLOCK_NAME "Materials"
+#define MATERIAL_BLOCK_BINDING 0
+#define MAX_MATERIALS 256
+
+// std140 layout of one entry, shininess is packed into specular.w
+struct MaterialBlock
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+class MaterialTable
+{
+public:
+    MaterialTable() = default;
+    ~MaterialTable();
+
+    // Registers a material and the one drawn in its place while colour tracking is on
+    GLuint Add(const Material& material, const Material& tracked);
+
+    // Uploads both tables, call once after every material has been added
+    void Upload();
+
+    // Binds the regular or the colour tracked table to MATERIAL_BLOCK_BINDING
+    void Bind(bool useColorTracking) const;
+
+    GLuint Size() const
+    {
+        return static_cast<GLuint>(materials.size());
+    }
+
+private:
+    std::vector<Material> materials;
+    std::vector<Material> trackedMaterials;
+    GLuint buffers[2] = { 0, 0 };
+};
+
+#endif
@@ -0,0 +1,111 @@
+/*
+    Mesh.h
+
+    Indexed triangle mesh kept on the CPU, the form every mesh takes before it
+    is uploaded.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_MESH_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_MESH_H_INCLUDED
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+
+    // Bounding sphere in model space
+    glm::vec3 center;
+    GLfloat radius = 0.0f;
+
+    void ComputeBounds()
+    {
+        if (vertices.empty())
+        {
+            return;
+        }
+
+        auto minimum = vertices[0].position;
+        auto maximum = vertices[0].position;
+        for (const auto& vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.position);
+            maximum = glm::max(maximum, vertex.position);
+        }
+        center = (minimum + maximum) * 0.5f;
+        radius = 0.0f;
+        for (const auto& vertex : vertices)
+        {
+            radius = glm::max(radius, glm::length(vertex.position - center));
+        }
+    }
+
+    // Builds a mesh from separate position and normal arrays of unindexed triangles
+    static MeshData FromArrays(const GLfloat* positions, const GLfloat* normals, int vertexCount)
+    {
+        std::vector<Vertex> triangles(vertexCount);
+        for (auto i = 0; i < vertexCount; ++i)
+        {
+            triangles[i].position = glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+            triangles[i].normal = glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+        }
+        return FromTriangles(triangles);
+    }
+
+    // Builds a mesh from unindexed triangles, welding vertices which are exactly equal
+    static MeshData FromTriangles(const std::vector<Vertex>& triangles)
+    {
+        struct VertexHash
+        {
+            size_t operator()(const Vertex& vertex) const
+            {
+                GLuint bits[6];
+                std::memcpy(bits, &vertex, sizeof(bits));
+                size_t hash = 0;
+                for (auto bit : bits)
+                {
+                    hash = hash * 31 + bit;
+                }
+                return hash;
+            }
+        };
+        struct VertexEqual
+        {
+            bool operator()(const Vertex& a, const Vertex& b) const
+            {
+                return a.position == b.position && a.normal == b.normal;
+            }
+        };
+
+        MeshData mesh;
+        std::unordered_map<Vertex, GLuint, VertexHash, VertexEqual> welded;
+        mesh.indices.reserve(triangles.size());
+        for (const auto& vertex : triangles)
+        {
+            auto found = welded.find(vertex);
+            if (found == welded.end())
+            {
+                found = welded.emplace(vertex, static_cast<GLuint>(mesh.vertices.size())).first;
+                mesh.vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(found->second);
+        }
+        mesh.ComputeBounds();
+        return mesh;
+    }
+};
+
+#endif
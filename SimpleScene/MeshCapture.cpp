@@ -0,0 +1,53 @@
+#include "MeshCapture.h"
+
+#include <GL/freeglut.h>
+
+void MeshCapture::Setup()
+{
+    captureShader.Setup("capture", { "capturedPosition", "capturedNormal" });
+}
+
+MeshData MeshCapture::Capture(const std::function<void()>& draw) const
+{
+    GLuint query, feedbackBuffer;
+    GLuint primitives = 0;
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    captureShader.Use();
+    glutSetVertexAttribCoord3(0);
+    glutSetVertexAttribNormal(1);
+
+    // First pass counts the triangles so the feedback buffer can be sized
+    glGenQueries(1, &query);
+    glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+    draw();
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &primitives);
+    glDeleteQueries(1, &query);
+
+    std::vector<Vertex> triangles(primitives * 3);
+    if (primitives > 0)
+    {
+        glGenBuffers(1, &feedbackBuffer);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedbackBuffer);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, triangles.size() * sizeof(Vertex), nullptr, GL_STATIC_READ);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedbackBuffer);
+
+        // Strips and fans come out as separate triangles
+        glBeginTransformFeedback(GL_TRIANGLES);
+        draw();
+        glEndTransformFeedback();
+
+        glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, triangles.size() * sizeof(Vertex), triangles.data());
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+        glDeleteBuffers(1, &feedbackBuffer);
+    }
+
+    glutSetVertexAttribCoord3(-1);
+    glutSetVertexAttribNormal(-1);
+    glUseProgram(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    return MeshData::FromTriangles(triangles);
+}
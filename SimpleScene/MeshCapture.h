@@ -0,0 +1,33 @@
+/*
+    MeshCapture.h
+
+    Records the triangles of a GLUT solid (teapot, sphere, ...) into a MeshData
+    with transform feedback, so GLUT shapes can share buffers with our own meshes.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_MESH_CAPTURE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_MESH_CAPTURE_H_INCLUDED
+
+#include <functional>
+
+#include "Mesh.h"
+#include "Shader.h"
+
+class MeshCapture
+{
+public:
+    MeshCapture() = default;
+    ~MeshCapture() = default;
+
+    // Needs a current context
+    void Setup();
+
+    // Runs draw once with rasterization off and returns what it drew
+    MeshData Capture(const std::function<void()>& draw) const;
+
+private:
+    Shader captureShader;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+#include "FloatParser.h"
+#include "MaterialTable.h"
+
+namespace
+{
+    std::string lowerExtension(const std::string& path)
+    {
+        auto dot = path.find_last_of('.');
+        if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos)
+        {
+            return "";
+        }
+        auto extension = path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+}
+
+bool ImportModel(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error)
+{
+    auto extension = lowerExtension(path);
+    if (extension == "obj")
+    {
+        return ImportObj(path, pool, model, error);
+    }
+    if (extension == "gltf" || extension == "glb")
+    {
+        return ImportGltf(path, pool, model, error);
+    }
+    error = "unknown model format '" + extension + "'";
+    return false;
+}
+
+bool AddModelToScene(const ImportedModel& model, const glm::mat4& placement, Scene& scene, std::string& error)
+{
+    // Colour tracking shows the diffuse colour, as it does for the room. Files often repeat a
+    // material under several names, each one is only added once
+    std::vector<SceneMaterial> added;
+    std::vector<GLuint> materials(model.materials.size());
+    for (size_t i = 0; i < model.materials.size(); ++i)
+    {
+        const auto& material = model.materials[i];
+        Material tracked(material.diffuse, material.diffuse, material.diffuse, material.shininess);
+        auto matches = [&](const SceneMaterial& existing) { return existing.material == material && existing.tracked == tracked; };
+        auto found = std::find_if(scene.materials.begin(), scene.materials.end(), matches);
+        if (found != scene.materials.end())
+        {
+            materials[i] = static_cast<GLuint>(found - scene.materials.begin());
+            continue;
+        }
+        auto foundAdded = std::find_if(added.begin(), added.end(), matches);
+        materials[i] = static_cast<GLuint>(scene.materials.size() + (foundAdded - added.begin()));
+        if (foundAdded == added.end())
+        {
+            added.push_back({ material, tracked });
+        }
+    }
+    if (scene.materials.size() + added.size() > MAX_MATERIALS)
+    {
+        error = std::to_string(added.size()) + " new materials would take the scene past " + std::to_string(MAX_MATERIALS);
+        return false;
+    }
+
+    for (const auto& material : added)
+    {
+        scene.AddMaterial(material.material, material.material.diffuse);
+    }
+    std::vector<GLuint> meshes(model.meshes.size());
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        meshes[i] = scene.AddMesh(model.meshes[i]);
+    }
+    for (const auto& instance : model.instances)
+    {
+        scene.AddObject(meshes[instance.mesh], materials[instance.material], placement * instance.transform);
+    }
+    return true;
+}
+
+bool ReadPaddedFile(const std::string& path, std::vector<char>& text, size_t& size, std::string& error)
+{
+    auto file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    // ftell is 32 bits on Windows, so big files need the 64 bit versions
+#ifdef _WIN32
+    _fseeki64(file, 0, SEEK_END);
+    auto length = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_SET);
+#else
+    fseeko(file, 0, SEEK_END);
+    auto length = ftello(file);
+    fseeko(file, 0, SEEK_SET);
+#endif
+    if (length < 0)
+    {
+        std::fclose(file);
+        error = "cannot read " + path;
+        return false;
+    }
+
+    size = static_cast<size_t>(length);
+    text.assign(size + 2 * FLOAT_PARSER_PADDING, '\0');
+    auto read = std::fread(text.data() + FLOAT_PARSER_PADDING, 1, size, file);
+    std::fclose(file);
+    if (read != size)
+    {
+        error = "cannot read " + path;
+        return false;
+    }
+    return true;
+}
+
+void ComputeNormals(MeshData& mesh)
+{
+    for (auto& vertex : mesh.vertices)
+    {
+        vertex.normal = glm::vec3(0.0f);
+    }
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        auto& a = mesh.vertices[mesh.indices[i]];
+        auto& b = mesh.vertices[mesh.indices[i + 1]];
+        auto& c = mesh.vertices[mesh.indices[i + 2]];
+        // Unnormalised, so bigger triangles count for more
+        auto normal = glm::cross(b.position - a.position, c.position - a.position);
+        a.normal += normal;
+        b.normal += normal;
+        c.normal += normal;
+    }
+    for (auto& vertex : mesh.vertices)
+    {
+        auto length = glm::length(vertex.normal);
+        vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
@@ -0,0 +1,59 @@
+/*
+    ModelImporter.h
+
+    Loads Wavefront OBJ (with its MTL materials) and glTF 2.0 (.gltf with
+    embedded or external buffers, or binary .glb) into meshes and materials
+    the scene can take. Files are read in one go and parsed in parallel on
+    the thread pool; numbers are parsed with the SIMD parser in FloatParser.h
+    and vertices are welded with flat hash tables, so nothing is allocated
+    per vertex.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_MODEL_IMPORTER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_MODEL_IMPORTER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Material.h"
+#include "Mesh.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+
+// A mesh placed with a material, indices are into the model's own lists
+struct ModelInstance
+{
+    GLuint mesh;
+    GLuint material;
+    glm::mat4 transform;
+};
+
+struct ImportedModel
+{
+    std::vector<MeshData> meshes;
+    std::vector<Material> materials;
+    std::vector<ModelInstance> instances;
+};
+
+// Picks the format from the extension (.obj, .gltf or .glb)
+bool ImportModel(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error);
+
+bool ImportObj(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error);
+
+bool ImportGltf(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error);
+
+// Adds the model's meshes, materials and instances, every instance moved by placement. Materials the
+// scene already has are shared, fails without adding anything if the rest won't fit in MAX_MATERIALS
+bool AddModelToScene(const ImportedModel& model, const glm::mat4& placement, Scene& scene, std::string& error);
+
+// Reads a whole file with FLOAT_PARSER_PADDING zero bytes either side of it, the text starts at
+// text.data() + FLOAT_PARSER_PADDING and is size bytes long
+bool ReadPaddedFile(const std::string& path, std::vector<char>& text, size_t& size, std::string& error);
+
+// Area weighted vertex normals from the triangles
+void ComputeNormals(MeshData& mesh);
+
+#endif
@@ -0,0 +1,119 @@
+#include "MultiView.h"
+
+#include <iostream>
+
+#include "FrameData.h"
+#include "FrameStats.h"
+
+bool MultiViewSupported()
+{
+    return (GLEW_VERSION_4_1 || GLEW_ARB_viewport_array) &&
+           (GLEW_ARB_shader_viewport_layer_array || GLEW_AMD_vertex_shader_viewport_index);
+}
+
+std::string MultiViewDefines()
+{
+    return "#define MULTI_VIEW\n#define MAX_VIEWS " + std::to_string(MAX_VIEWS) + "\n";
+}
+
+MultiViewTarget::~MultiViewTarget()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void MultiViewTarget::Resize(const std::vector<glm::ivec2>& sizes)
+{
+    if (sizes == this->sizes)
+    {
+        return;
+    }
+    this->sizes = sizes;
+
+    offsets.clear();
+    glm::ivec2 size(0);
+    for (const auto& view : sizes)
+    {
+        offsets.push_back(size.x);
+        size.x += view.x;
+        size.y = glm::max(size.y, view.y);
+    }
+    if (size == this->size)
+    {
+        return;
+    }
+    this->size = size;
+
+    if (framebuffer == 0)
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glGenTextures(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glGenVertexArrays(1, &vao);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: The multi-view framebuffer is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void MultiViewTarget::Begin() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, size.x, size.y);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    std::vector<GLfloat> viewports;
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        viewports.insert(viewports.end(), { static_cast<GLfloat>(offsets[i]), 0.0f, static_cast<GLfloat>(sizes[i].x), static_cast<GLfloat>(sizes[i].y) });
+    }
+    glViewportArrayv(0, static_cast<GLsizei>(sizes.size()), viewports.data());
+}
+
+void MultiViewTarget::End() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void MultiViewTarget::Present(GLuint view, const Shader& compositeShader) const
+{
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    // The whole texture, scaled and shifted so the view's part lands on the viewport and the rest falls outside
+    auto viewSize = glm::vec2(sizes[view]);
+    compositeShader.Use();
+    glUniform4f(glGetUniformLocation(compositeShader(), "rect"), -1.0f - 2.0f * offsets[view] / viewSize.x, -1.0f,
+                2.0f * size.x / viewSize.x, 2.0f * size.y / viewSize.y);
+    glUniform1i(glGetUniformLocation(compositeShader(), "panel"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPolygonMode(GL_FRONT, polygonMode[0]);
+    glPolygonMode(GL_BACK, polygonMode[1]);
+}
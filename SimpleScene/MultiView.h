@@ -0,0 +1,66 @@
+/*
+    MultiView.h
+
+    Draws every view of the scene in one pass. The views sit side by side
+    in one framebuffer, each with its own viewport of a viewport array.
+    Shaders built with MultiViewDefines draw every object once per view as
+    instances. Instance i goes to viewport i through gl_ViewportIndex, with
+    camera and lights from entry i of the Camera and Lights blocks. Each
+    window then shows its view's part of the colour texture.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_MULTI_VIEW_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_MULTI_VIEW_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// Viewport arrays, and gl_ViewportIndex written by the vertex shader
+bool MultiViewSupported();
+
+// For Shader::Setup, turns on the MULTI_VIEW paths of the scene shaders
+std::string MultiViewDefines();
+
+class MultiViewTarget
+{
+public:
+    MultiViewTarget() = default;
+    ~MultiViewTarget();
+
+    MultiViewTarget(const MultiViewTarget&) = delete;
+    MultiViewTarget& operator=(const MultiViewTarget&) = delete;
+
+    // One view per size, left to right. The attachments are only remade when a size changes
+    void Resize(const std::vector<glm::ivec2>& sizes);
+
+    // Binds the framebuffer with a viewport per view and clears it
+    void Begin() const;
+
+    // Back to the window's framebuffer
+    void End() const;
+
+    // Fills the current viewport with one view, compositeShader is the panel shader
+    void Present(GLuint view, const Shader& compositeShader) const;
+
+    GLuint Views() const
+    {
+        return static_cast<GLuint>(sizes.size());
+    }
+
+private:
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+    GLuint vao = 0;
+    glm::ivec2 size = glm::ivec2(0);
+    std::vector<glm::ivec2> sizes;
+    std::vector<GLint> offsets; // Left edge of each view
+};
+
+#endif
@@ -0,0 +1,486 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include "FloatParser.h"
+
+namespace
+{
+    // Chunks are cut at line breaks, a few per thread so stealing evens out the dense parts of a file
+    const size_t MIN_CHUNK_SIZE = 1 << 20;
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    // Big single material meshes are split so they weld in parallel and stay a sensible draw size
+    const size_t MAX_MESH_TRIANGLES = 1 << 18;
+
+    const GLuint NO_NORMAL = 0xFFFFFFFF;
+    const uint64_t EMPTY_SLOT = ~0ull;
+
+    // Used where the file names no material or one its libraries do not have
+    const Material defaultMaterial(glm::vec3(0.1f), glm::vec3(0.7f), glm::vec3(0.3f), 32.0f);
+
+    struct Corner
+    {
+        GLuint position;
+        GLuint normal;
+    };
+
+    struct MaterialSwitch
+    {
+        size_t triangle; // First triangle drawn with it
+        std::string name;
+    };
+
+    struct ObjChunk
+    {
+        const char* begin;
+        const char* end;
+        size_t positionCount = 0;
+        size_t normalCount = 0;
+        size_t triangleCount = 0;
+        size_t firstPosition = 0;
+        size_t firstNormal = 0;
+        size_t firstTriangle = 0;
+        std::vector<MaterialSwitch> switches;
+        std::vector<std::string> libraries;
+        std::string error;
+    };
+
+    // Triangles [first, first + count) in one material
+    struct TriangleRange
+    {
+        size_t first;
+        size_t count;
+        GLuint material;
+    };
+
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool isLineEnd(char c)
+    {
+        return c == '\n' || c == '\0' || c == '#';
+    }
+
+    const char* skipBlanks(const char* p)
+    {
+        while (isBlank(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    const char* nextLine(const char* p, const char* end)
+    {
+        auto newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        return newline ? newline + 1 : end;
+    }
+
+    bool startsWith(const char* p, const char* keyword)
+    {
+        auto length = std::strlen(keyword);
+        return std::strncmp(p, keyword, length) == 0 && (isBlank(p[length]) || isLineEnd(p[length]));
+    }
+
+    // The rest of the line without surrounding blanks or a comment
+    std::string restOfLine(const char* p)
+    {
+        p = skipBlanks(p);
+        auto end = p;
+        while (!isLineEnd(*end))
+        {
+            ++end;
+        }
+        while (end > p && isBlank(end[-1]))
+        {
+            --end;
+        }
+        return std::string(p, end);
+    }
+
+    // First pass: how much of everything the chunk holds, so the second can write in place
+    void countChunk(ObjChunk& chunk)
+    {
+        for (auto line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end))
+        {
+            auto p = skipBlanks(line);
+            if (p[0] == 'v' && isBlank(p[1]))
+            {
+                ++chunk.positionCount;
+            }
+            else if (p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+            {
+                ++chunk.normalCount;
+            }
+            else if (p[0] == 'f' && isBlank(p[1]))
+            {
+                size_t corners = 0;
+                for (p = skipBlanks(p + 1); !isLineEnd(*p); p = skipBlanks(p))
+                {
+                    ++corners;
+                    while (!isBlank(*p) && !isLineEnd(*p))
+                    {
+                        ++p;
+                    }
+                }
+                chunk.triangleCount += corners >= 3 ? corners - 2 : 0;
+            }
+        }
+    }
+
+    // Turns a 1 based or negative (relative) OBJ index into a 0 based one, seen is how many came before the line
+    bool resolveIndex(int64_t index, size_t seen, size_t total, GLuint& resolved)
+    {
+        auto value = index > 0 ? index - 1 : static_cast<int64_t>(seen) + index;
+        if (index == 0 || value < 0 || value >= static_cast<int64_t>(total))
+        {
+            return false;
+        }
+        resolved = static_cast<GLuint>(value);
+        return true;
+    }
+
+    // Second pass: parses into the shared arrays at the offsets the counts gave
+    void parseChunk(ObjChunk& chunk, size_t totalPositions, size_t totalNormals,
+                    glm::vec3* positions, glm::vec3* normals, Corner* corners)
+    {
+        auto position = chunk.firstPosition;
+        auto normal = chunk.firstNormal;
+        auto corner = corners + chunk.firstTriangle * 3;
+        for (auto line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end))
+        {
+            auto p = skipBlanks(line);
+            if (p[0] == 'v' && (isBlank(p[1]) || (p[1] == 'n' && isBlank(p[2]))))
+            {
+                glm::vec3 value;
+                auto isNormal = p[1] == 'n';
+                p += isNormal ? 2 : 1;
+                for (auto axis = 0; axis < 3; ++axis)
+                {
+                    p = skipBlanks(p);
+                    auto parsed = ParseFloat(p, value[axis]);
+                    if (parsed == p)
+                    {
+                        chunk.error = "bad vertex '" + restOfLine(line) + "'";
+                        return;
+                    }
+                    p = parsed;
+                }
+                if (isNormal)
+                {
+                    normals[normal++] = value;
+                }
+                else
+                {
+                    positions[position++] = value;
+                }
+            }
+            else if (p[0] == 'f' && isBlank(p[1]))
+            {
+                // Fan out from the first corner, no list of corners is kept
+                Corner first = {}, previous = {};
+                auto count = 0;
+                for (p = skipBlanks(p + 1); !isLineEnd(*p); p = skipBlanks(p))
+                {
+                    int64_t index;
+                    auto parsed = ParseInt(p, index);
+                    Corner current = { 0, NO_NORMAL };
+                    if (parsed == p || !resolveIndex(index, position, totalPositions, current.position))
+                    {
+                        chunk.error = "bad face '" + restOfLine(line) + "'";
+                        return;
+                    }
+                    p = parsed;
+                    if (*p == '/')
+                    {
+                        // Texture coordinates are not used
+                        p = ParseInt(p + 1, index);
+                        if (*p == '/')
+                        {
+                            // "v/vt/" leaves the normal out like "v/vt" does
+                            parsed = ParseInt(++p, index);
+                            if (parsed != p && !resolveIndex(index, normal, totalNormals, current.normal))
+                            {
+                                chunk.error = "bad face '" + restOfLine(line) + "'";
+                                return;
+                            }
+                            p = parsed;
+                        }
+                    }
+
+                    if (count == 0)
+                    {
+                        first = current;
+                    }
+                    else if (count >= 2)
+                    {
+                        corner[0] = first;
+                        corner[1] = previous;
+                        corner[2] = current;
+                        corner += 3;
+                    }
+                    previous = current;
+                    ++count;
+                }
+            }
+            else if (startsWith(p, "usemtl"))
+            {
+                auto triangle = chunk.firstTriangle + (corner - corners - chunk.firstTriangle * 3) / 3;
+                chunk.switches.push_back({ triangle, restOfLine(p + 6) });
+            }
+            else if (startsWith(p, "mtllib"))
+            {
+                chunk.libraries.push_back(restOfLine(p + 6));
+            }
+        }
+    }
+
+    // Reads Ka, Kd, Ks and Ns of every material in an MTL file
+    void loadMaterialLibrary(const std::string& path, ImportedModel& model, std::unordered_map<std::string, GLuint>& names)
+    {
+        std::vector<char> text;
+        size_t size;
+        std::string error;
+        if (!ReadPaddedFile(path, text, size, error))
+        {
+            std::cerr << "Warning: " << error << ", using the default material" << std::endl;
+            return;
+        }
+
+        const char* begin = text.data() + FLOAT_PARSER_PADDING;
+        auto end = begin + size;
+        Material* material = nullptr;
+        for (auto line = begin; line < end; line = nextLine(line, end))
+        {
+            auto p = skipBlanks(line);
+            if (startsWith(p, "newmtl"))
+            {
+                names[restOfLine(p + 6)] = static_cast<GLuint>(model.materials.size());
+                model.materials.push_back(defaultMaterial);
+                material = &model.materials.back();
+            }
+            else if (material && p[0] == 'K' && (p[1] == 'a' || p[1] == 'd' || p[1] == 's') && isBlank(p[2]))
+            {
+                auto& color = p[1] == 'a' ? material->ambient : p[1] == 'd' ? material->diffuse : material->specular;
+                p += 2;
+                auto channel = 0;
+                for (; channel < 3; ++channel)
+                {
+                    // A failed parse can still write its value, so it goes through a copy
+                    auto number = skipBlanks(p);
+                    float value;
+                    p = ParseFloat(number, value);
+                    if (p == number)
+                    {
+                        break;
+                    }
+                    color[channel] = value;
+                }
+                // Green & blue default to red, so "Kd 0.5" is a grey
+                for (auto missing = channel; channel > 0 && missing < 3; ++missing)
+                {
+                    color[missing] = color[0];
+                }
+            }
+            else if (material && p[0] == 'N' && p[1] == 's' && isBlank(p[2]))
+            {
+                ParseFloat(skipBlanks(p + 2), material->shininess);
+            }
+        }
+    }
+
+    std::string directoryOf(const std::string& path)
+    {
+        auto slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    uint64_t cornerKey(const Corner& corner)
+    {
+        return static_cast<uint64_t>(corner.position) << 32 | corner.normal;
+    }
+
+    // Welds the corners of the triangles in range into an indexed mesh with an open addressing table
+    MeshData buildMesh(const TriangleRange& range, const Corner* corners, const glm::vec3* positions,
+                       const glm::vec3* normals, const glm::vec3* smoothNormals)
+    {
+        auto cornerCount = range.count * 3;
+        size_t capacity = 16;
+        while (capacity < cornerCount * 2)
+        {
+            capacity <<= 1;
+        }
+        auto shift = 64;
+        for (auto size = capacity; size > 1; size >>= 1)
+        {
+            --shift;
+        }
+        std::vector<uint64_t> keys(capacity, EMPTY_SLOT);
+        std::vector<GLuint> slots(capacity);
+
+        MeshData mesh;
+        mesh.vertices.reserve(cornerCount);
+        mesh.indices.resize(cornerCount);
+        auto first = corners + range.first * 3;
+        for (size_t i = 0; i < cornerCount; ++i)
+        {
+            const auto& corner = first[i];
+            auto key = cornerKey(corner);
+            auto slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+            while (keys[slot] != EMPTY_SLOT && keys[slot] != key)
+            {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (keys[slot] == EMPTY_SLOT)
+            {
+                keys[slot] = key;
+                slots[slot] = static_cast<GLuint>(mesh.vertices.size());
+                auto normal = corner.normal == NO_NORMAL ? smoothNormals[corner.position] : normals[corner.normal];
+                mesh.vertices.push_back({ positions[corner.position], normal });
+            }
+            mesh.indices[i] = slots[slot];
+        }
+        mesh.vertices.shrink_to_fit();
+        mesh.ComputeBounds();
+        return mesh;
+    }
+}
+
+bool ImportObj(const std::string& path, ThreadPool& pool, ImportedModel& model, std::string& error)
+{
+    std::vector<char> text;
+    size_t size;
+    if (!ReadPaddedFile(path, text, size, error))
+    {
+        return false;
+    }
+    const char* begin = text.data() + FLOAT_PARSER_PADDING;
+    auto end = begin + size;
+
+    // Cut the file into chunks at line breaks
+    auto chunkSize = std::max(MIN_CHUNK_SIZE, size / (pool.Size() * CHUNKS_PER_THREAD) + 1);
+    std::vector<ObjChunk> chunks;
+    for (auto p = begin; p < end;)
+    {
+        ObjChunk chunk;
+        chunk.begin = p;
+        chunk.end = static_cast<size_t>(end - p) <= chunkSize ? end : nextLine(p + chunkSize, end);
+        p = chunk.end;
+        chunks.push_back(std::move(chunk));
+    }
+
+    pool.ParallelFor(chunks.size(), [&](size_t i, unsigned)
+    {
+        countChunk(chunks[i]);
+    });
+
+    size_t positionCount = 0, normalCount = 0, triangleCount = 0;
+    for (auto& chunk : chunks)
+    {
+        chunk.firstPosition = positionCount;
+        chunk.firstNormal = normalCount;
+        chunk.firstTriangle = triangleCount;
+        positionCount += chunk.positionCount;
+        normalCount += chunk.normalCount;
+        triangleCount += chunk.triangleCount;
+    }
+    if (positionCount >= NO_NORMAL || normalCount >= NO_NORMAL)
+    {
+        error = "too many vertices";
+        return false;
+    }
+
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec3> normals(normalCount);
+    std::vector<Corner> corners(triangleCount * 3);
+    pool.ParallelFor(chunks.size(), [&](size_t i, unsigned)
+    {
+        parseChunk(chunks[i], positionCount, normalCount, positions.data(), normals.data(), corners.data());
+    });
+    for (const auto& chunk : chunks)
+    {
+        if (!chunk.error.empty())
+        {
+            error = chunk.error;
+            return false;
+        }
+    }
+
+    // Materials, then which triangles use which
+    model = ImportedModel();
+    std::unordered_map<std::string, GLuint> materialNames;
+    std::vector<std::string> loaded;
+    for (const auto& chunk : chunks)
+    {
+        for (const auto& library : chunk.libraries)
+        {
+            if (std::find(loaded.begin(), loaded.end(), library) == loaded.end())
+            {
+                loadMaterialLibrary(directoryOf(path) + library, model, materialNames);
+                loaded.push_back(library);
+            }
+        }
+    }
+    auto fallback = static_cast<GLuint>(model.materials.size());
+    model.materials.push_back(defaultMaterial);
+
+    std::vector<TriangleRange> ranges;
+    auto addRange = [&](size_t first, size_t last, GLuint material)
+    {
+        for (auto start = first; start < last; start += MAX_MESH_TRIANGLES)
+        {
+            ranges.push_back({ start, std::min(MAX_MESH_TRIANGLES, last - start), material });
+        }
+    };
+    size_t rangeStart = 0;
+    auto material = fallback;
+    for (const auto& chunk : chunks)
+    {
+        for (const auto& change : chunk.switches)
+        {
+            addRange(rangeStart, change.triangle, material);
+            auto found = materialNames.find(change.name);
+            material = found == materialNames.end() ? fallback : found->second;
+            rangeStart = change.triangle;
+        }
+    }
+    addRange(rangeStart, triangleCount, material);
+
+    // Faces without normals are smoothed over the triangles sharing their positions
+    std::vector<glm::vec3> smoothNormals;
+    if (std::any_of(corners.begin(), corners.end(), [](const Corner& corner) { return corner.normal == NO_NORMAL; }))
+    {
+        smoothNormals.assign(positionCount, glm::vec3(0.0f));
+        for (size_t i = 0; i < corners.size(); i += 3)
+        {
+            const auto& a = positions[corners[i].position];
+            auto normal = glm::cross(positions[corners[i + 1].position] - a, positions[corners[i + 2].position] - a);
+            for (auto j = 0; j < 3; ++j)
+            {
+                smoothNormals[corners[i + j].position] += normal;
+            }
+        }
+        for (auto& normal : smoothNormals)
+        {
+            auto length = glm::length(normal);
+            normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    model.meshes.resize(ranges.size());
+    pool.ParallelFor(ranges.size(), [&](size_t i, unsigned)
+    {
+        model.meshes[i] = buildMesh(ranges[i], corners.data(), positions.data(), normals.data(), smoothNormals.data());
+    });
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        model.instances.push_back({ static_cast<GLuint>(i), ranges[i].material, glm::mat4() });
+    }
+    return true;
+}
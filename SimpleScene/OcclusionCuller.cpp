@@ -0,0 +1,277 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <emmintrin.h>
+
+#include "Lod.h"
+
+namespace
+{
+    // A box test looks for the level where its rectangle spans at most this many texels
+    const int TEST_TEXELS = 4;
+
+    const GLfloat NEAR_W = 1e-5f;
+}
+
+void OcclusionCuller::Setup(const Scene& scene)
+{
+    this->scene = &scene;
+    occluders.clear();
+    objectOccluder.assign(scene.objects.size(), DYNAMIC_BVH_NULL);
+    for (size_t i = 0; i < scene.objects.size(); ++i)
+    {
+        const auto& object = scene.objects[i];
+        if (scene.Bounds(object).w >= OCCLUDER_MIN_RADIUS && scene.meshes[object.mesh].indices.size() <= OCCLUDER_MAX_TRIANGLES * 3)
+        {
+            objectOccluder[i] = static_cast<GLuint>(occluders.size());
+            occluders.push_back(object);
+        }
+    }
+    rendered.assign(occluders.size(), 0);
+
+    levels.clear();
+    levelSizes.clear();
+    glm::ivec2 size(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    while (true)
+    {
+        levels.emplace_back(size.x * size.y);
+        levelSizes.push_back(size);
+        if (size.x == 1 && size.y == 1)
+        {
+            break;
+        }
+        size = glm::max((size + 1) / 2, glm::ivec2(1));
+    }
+}
+
+void OcclusionCuller::Render(const DynamicBvh& tree, const glm::mat4& view, const glm::mat4& projection, const RasterSettings& settings)
+{
+    viewProjection = projection * view;
+    std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+    std::fill(rendered.begin(), rendered.end(), 0);
+
+    tree.QueryFrustum(Frustum(viewProjection), [&](GLuint item)
+    {
+        auto occluder = objectOccluder[item];
+        if (occluder == DYNAMIC_BVH_NULL)
+        {
+            return;
+        }
+        auto bounds = scene->Bounds(scene->objects[item]);
+        if (ProjectedRadius(glm::vec3(bounds), bounds.w, view, projection, OCCLUSION_HEIGHT) < OCCLUDER_MIN_PIXELS)
+        {
+            return;
+        }
+        rendered[occluder] = 1;
+        rasterize(scene->objects[item], viewProjection, settings);
+    });
+
+    buildPyramid();
+}
+
+bool OcclusionCuller::IsVisible(GLuint object) const
+{
+    // An occluder's own depth could round to just in front of its box and hide it
+    auto occluder = objectOccluder[object];
+    if (occluder != DYNAMIC_BVH_NULL && rendered[occluder])
+    {
+        return true;
+    }
+    return testBox(scene->Box(scene->objects[object]));
+}
+
+bool OcclusionCuller::testBox(const BoundingBox& box) const
+{
+    // Screen rectangle and nearest depth of the box's corners
+    glm::vec2 minimum(1.0f), maximum(-1.0f);
+    auto nearest = 1.0f;
+    for (auto i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+        auto clip = viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w <= NEAR_W || clip.z < -clip.w)
+        {
+            return true; // Reaches past the near plane
+        }
+        auto ndc = glm::vec3(clip) / clip.w;
+        minimum = glm::min(minimum, glm::vec2(ndc));
+        maximum = glm::max(maximum, glm::vec2(ndc));
+        nearest = glm::min(nearest, ndc.z);
+    }
+
+    auto toPixels = [](const glm::vec2& ndc)
+    {
+        return (ndc * 0.5f + 0.5f) * glm::vec2(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    };
+    auto low = glm::max(glm::ivec2(glm::floor(toPixels(minimum))) - 1, glm::ivec2(0));
+    auto high = glm::min(glm::ivec2(glm::floor(toPixels(maximum))) + 1, glm::ivec2(OCCLUSION_WIDTH - 1, OCCLUSION_HEIGHT - 1));
+    if (low.x > high.x || low.y > high.y)
+    {
+        return true; // Off screen, that's for frustum culling to say
+    }
+
+    size_t level = 0;
+    while (level + 1 < levels.size() && (high.x - low.x >= TEST_TEXELS || high.y - low.y >= TEST_TEXELS))
+    {
+        low /= 2;
+        high /= 2;
+        ++level;
+    }
+
+    const auto& depth = levels[level];
+    auto width = levelSizes[level].x;
+    for (auto y = low.y; y <= high.y; ++y)
+    {
+        for (auto x = low.x; x <= high.x; ++x)
+        {
+            if (depth[y * width + x] >= nearest)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void OcclusionCuller::rasterize(const SceneObject& object, const glm::mat4& viewProjection, const RasterSettings& settings)
+{
+    const auto& mesh = scene->meshes[object.mesh];
+    auto modelViewProjection = viewProjection * object.model;
+    clipScratch.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        clipScratch[i] = modelViewProjection * glm::vec4(mesh.vertices[i].position, 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        glm::vec4 in[3] = { clipScratch[mesh.indices[i]], clipScratch[mesh.indices[i + 1]], clipScratch[mesh.indices[i + 2]] };
+
+        // Clip against the near plane, z >= -w, the only plane that needs real clipping
+        glm::vec4 out[4];
+        auto count = 0;
+        for (auto j = 0; j < 3; ++j)
+        {
+            const auto& current = in[j];
+            const auto& next = in[(j + 1) % 3];
+            auto d0 = current.z + current.w;
+            auto d1 = next.z + next.w;
+            if (d0 >= 0.0f)
+            {
+                out[count++] = current;
+            }
+            if ((d0 >= 0.0f) != (d1 >= 0.0f))
+            {
+                out[count++] = glm::mix(current, next, d0 / (d0 - d1));
+            }
+        }
+        for (auto j = 1; j + 1 < count; ++j)
+        {
+            glm::vec4 triangle[3] = { out[0], out[j], out[j + 1] };
+            rasterizeTriangle(triangle, settings);
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4* clip, const RasterSettings& settings)
+{
+    glm::vec2 screen[3];
+    GLfloat z[3];
+    for (auto i = 0; i < 3; ++i)
+    {
+        auto w = glm::max(clip[i].w, NEAR_W);
+        screen[i] = (glm::vec2(clip[i]) / w * 0.5f + 0.5f) * glm::vec2(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+        z[i] = clip[i].z / w;
+    }
+
+    // Counter-clockwise on screen is front facing, as in GL
+    auto area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+    if (area == 0.0f || (settings.useBackfaceCulling && (area > 0.0f) == settings.cullFrontFace))
+    {
+        return;
+    }
+    if (area < 0.0f)
+    {
+        std::swap(screen[1], screen[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    auto minX = std::max(static_cast<int>(std::floor(std::min({ screen[0].x, screen[1].x, screen[2].x }))), 0);
+    auto maxX = std::min(static_cast<int>(std::ceil(std::max({ screen[0].x, screen[1].x, screen[2].x }))), OCCLUSION_WIDTH - 1);
+    auto minY = std::max(static_cast<int>(std::floor(std::min({ screen[0].y, screen[1].y, screen[2].y }))), 0);
+    auto maxY = std::min(static_cast<int>(std::ceil(std::max({ screen[0].y, screen[1].y, screen[2].y }))), OCCLUSION_HEIGHT - 1);
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    // Edge i is opposite vertex i, positive inside
+    GLfloat a[3], b[3], c[3];
+    for (auto i = 0; i < 3; ++i)
+    {
+        const auto& p = screen[(i + 1) % 3];
+        const auto& q = screen[(i + 2) % 3];
+        a[i] = p.y - q.y;
+        b[i] = q.x - p.x;
+        c[i] = p.x * q.y - p.y * q.x;
+    }
+
+    // NDC depth is affine in screen space, so everything steps by a constant along a row
+    auto invArea = 1.0f / area;
+    auto zx = (a[0] * z[0] + a[1] * z[1] + a[2] * z[2]) * invArea;
+    auto zy = (b[0] * z[0] + b[1] * z[1] + b[2] * z[2]) * invArea;
+    auto zc = (c[0] * z[0] + c[1] * z[1] + c[2] * z[2]) * invArea;
+    // Four pixels at a time, the width is a multiple of four so the last group stays in the row
+    minX &= ~3;
+    auto offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    auto zero = _mm_setzero_ps();
+    __m128 step[4] = { _mm_set1_ps(a[0] * 4.0f), _mm_set1_ps(a[1] * 4.0f), _mm_set1_ps(a[2] * 4.0f), _mm_set1_ps(zx * 4.0f) };
+    for (auto y = minY; y <= maxY; ++y)
+    {
+        auto px = _mm_add_ps(_mm_set1_ps(static_cast<GLfloat>(minX)), offsets);
+        auto py = y + 0.5f;
+        auto w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), _mm_set1_ps(b[0] * py + c[0]));
+        auto w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), _mm_set1_ps(b[1] * py + c[1]));
+        auto w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), _mm_set1_ps(b[2] * py + c[2]));
+        auto pixelDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zx), px), _mm_set1_ps(zy * py + zc));
+        auto row = &levels[0][y * OCCLUSION_WIDTH];
+        for (auto x = minX; x <= maxX; x += 4)
+        {
+            auto inside = _mm_cmpge_ps(_mm_min_ps(_mm_min_ps(w0, w1), w2), zero);
+            auto stored = _mm_loadu_ps(row + x);
+            auto nearer = _mm_min_ps(stored, pixelDepth);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+            w0 = _mm_add_ps(w0, step[0]);
+            w1 = _mm_add_ps(w1, step[1]);
+            w2 = _mm_add_ps(w2, step[2]);
+            pixelDepth = _mm_add_ps(pixelDepth, step[3]);
+        }
+    }
+}
+
+// Each texel keeps the farthest of the (up to) four below it
+void OcclusionCuller::buildPyramid()
+{
+    for (size_t level = 1; level < levels.size(); ++level)
+    {
+        const auto& below = levels[level - 1];
+        auto belowSize = levelSizes[level - 1];
+        auto size = levelSizes[level];
+        auto& depth = levels[level];
+        for (auto y = 0; y < size.y; ++y)
+        {
+            auto y0 = std::min(y * 2, belowSize.y - 1);
+            auto y1 = std::min(y * 2 + 1, belowSize.y - 1);
+            for (auto x = 0; x < size.x; ++x)
+            {
+                auto x0 = std::min(x * 2, belowSize.x - 1);
+                auto x1 = std::min(x * 2 + 1, belowSize.x - 1);
+                depth[y * size.x + x] = std::max(std::max(below[y0 * belowSize.x + x0], below[y0 * belowSize.x + x1]),
+                                                 std::max(below[y1 * belowSize.x + x0], below[y1 * belowSize.x + x1]));
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+    OcclusionCuller.h
+
+    Occlusion culling against a hierarchical depth buffer built on the CPU.
+    The big, simple objects (walls, the table) are picked once as occluders.
+    Each frame the ones in view are rasterized into a small depth buffer,
+    which is reduced into a pyramid of farthest depths. An object is hidden
+    when its box is behind every texel of the pyramid level where its screen
+    rectangle covers a few texels. Occluders are sampled at pixel centres, so
+    tests take one extra texel around the rectangle to stay on the safe side.
+
+    The GL path also draws the occluders that were rasterized as a depth
+    prepass, so fragments behind them fail the depth test before shading.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_OCCLUSION_CULLER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_OCCLUSION_CULLER_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "DynamicBvh.h"
+#include "Frustum.h"
+#include "Scene.h"
+#include "SoftwareRasterizer.h"
+
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 192
+
+// Objects at least this big, with at most this many triangles, are occluders
+#define OCCLUDER_MIN_RADIUS 1.0f
+#define OCCLUDER_MAX_TRIANGLES 256
+
+// Occluders smaller than this on screen, in depth buffer pixels, hide too little to be worth drawing
+#define OCCLUDER_MIN_PIXELS 4.0f
+
+class OcclusionCuller
+{
+public:
+    OcclusionCuller() = default;
+    ~OcclusionCuller() = default;
+
+    // Picks the occluders from the scene's objects, the scene must outlive the culler
+    void Setup(const Scene& scene);
+
+    // Rasterizes the occluders the tree finds in view, culling faces the way settings say GL does
+    void Render(const DynamicBvh& tree, const glm::mat4& view, const glm::mat4& projection, const RasterSettings& settings);
+
+    // False only when the scene object is certainly behind the occluders, occluders drawn this frame always pass
+    bool IsVisible(GLuint object) const;
+
+    const std::vector<SceneObject>& Occluders() const
+    {
+        return occluders;
+    }
+
+    // Indexed like Occluders, set for the ones the last Render drew
+    const std::vector<char>& Rendered() const
+    {
+        return rendered;
+    }
+
+private:
+    void rasterize(const SceneObject& object, const glm::mat4& viewProjection, const RasterSettings& settings);
+    void rasterizeTriangle(const glm::vec4* clip, const RasterSettings& settings);
+    void buildPyramid();
+    bool testBox(const BoundingBox& box) const;
+
+    const Scene* scene = nullptr;
+    std::vector<SceneObject> occluders;
+    std::vector<GLuint> objectOccluder; // Scene object to occluder index, or DYNAMIC_BVH_NULL
+    std::vector<char> rendered;
+    std::vector<glm::vec4> clipScratch;
+
+    glm::mat4 viewProjection;
+    std::vector<std::vector<GLfloat>> levels; // NDC depth, farthest of the level below
+    std::vector<glm::ivec2> levelSizes;
+};
+
+#endif
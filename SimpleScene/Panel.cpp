@@ -0,0 +1,125 @@
+#include "Panel.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrameStats.h"
+
+Panel::~Panel()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void Panel::Setup(const GlyphAtlas& atlas, const Shader& textShader, const glm::vec4& background)
+{
+    text.Setup(atlas);
+    this->textShader = &textShader;
+    this->background = background;
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenTextures(1, &texture);
+    // The composite quad is generated from gl_VertexID, the VAO stays empty
+    glGenVertexArrays(1, &vao);
+}
+
+void Panel::SetSize(GLsizei width, GLsizei height)
+{
+    if (width == this->width && height == this->height)
+    {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    dirty = true;
+}
+
+void Panel::SetLabels(const std::vector<TextLabel>& labels)
+{
+    if (text.Set(labels))
+    {
+        dirty = true;
+    }
+}
+
+void Panel::Draw(const Shader& compositeShader, GLint x, GLint y)
+{
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+
+    GLint polygonMode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    if (dirty)
+    {
+        render();
+        dirty = false;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    auto rect = glm::vec4(2.0f * x / viewport[2] - 1.0f, 2.0f * y / viewport[3] - 1.0f,
+                          2.0f * width / viewport[2], 2.0f * height / viewport[3]);
+
+    compositeShader.Use();
+    glUniform4fv(glGetUniformLocation(compositeShader(), "rect"), 1, &rect[0]);
+    glUniform1i(glGetUniformLocation(compositeShader(), "panel"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // The panel texture holds premultiplied colour
+    auto opaque = background.a >= 1.0f;
+    if (!opaque)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+
+    glPolygonMode(GL_FRONT, polygonMode[0]);
+    glPolygonMode(GL_BACK, polygonMode[1]);
+}
+
+void Panel::render()
+{
+    GLint drawFramebuffer;
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glClearColor(background.r * background.a, background.g * background.a, background.b * background.a, background.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Same pixel mapping the instruction window used with gluOrtho2D
+    auto projection = glm::ortho(-1.0f, static_cast<GLfloat>(width), -1.0f, static_cast<GLfloat>(height));
+    text.Draw(*textShader, projection);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
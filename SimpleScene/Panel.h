@@ -0,0 +1,53 @@
+/*
+    Panel.h
+
+    A UI overlay rendered once into its own texture and composited from
+    there on every redisplay. The texture is only re-rendered when the
+    labels or the size change, so static help text and rarely changing
+    status readouts cost one textured quad per frame.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_PANEL_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_PANEL_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GlyphAtlas.h"
+#include "Shader.h"
+#include "TextBlock.h"
+
+class Panel
+{
+public:
+    Panel() = default;
+    ~Panel();
+
+    // textShader renders the labels, background is not premultiplied
+    void Setup(const GlyphAtlas& atlas, const Shader& textShader, const glm::vec4& background);
+
+    void SetSize(GLsizei width, GLsizei height);
+    void SetLabels(const std::vector<TextLabel>& labels);
+
+    // Re-renders if needed, then composites the panel with its bottom left at x, y
+    // of the current viewport. compositeShader is the panel shader
+    void Draw(const Shader& compositeShader, GLint x, GLint y);
+
+private:
+    void render();
+
+    TextBlock text;
+    const Shader* textShader = nullptr;
+    glm::vec4 background;
+    GLsizei width = 0;
+    GLsizei height = 0;
+    bool dirty = true;
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+    GLuint vao = 0;
+};
+
+#endif
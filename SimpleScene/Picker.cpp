@@ -0,0 +1,115 @@
+#include "Picker.h"
+
+void Picker::Build(const Scene& scene, ThreadPool* pool)
+{
+    this->scene = &scene;
+    meshBvhs.clear();
+    meshBvhs.resize(scene.meshes.size());
+
+    // Only the finest level is picked, whatever level is on screen
+    std::vector<char> used(scene.meshes.size(), 0);
+    for (const auto& object : scene.objects)
+    {
+        used[object.mesh] = 1;
+    }
+
+    auto build = [&](size_t mesh, ThreadPool* buildPool)
+    {
+        const auto& data = scene.meshes[mesh];
+        std::vector<BvhTriangle> triangles;
+        triangles.reserve(data.indices.size() / 3);
+        for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+        {
+            auto v0 = data.vertices[data.indices[i]].position;
+            auto e1 = data.vertices[data.indices[i + 1]].position - v0;
+            auto e2 = data.vertices[data.indices[i + 2]].position - v0;
+            if (glm::cross(e1, e2) != glm::vec3(0.0f))
+            {
+                triangles.push_back({ v0, e1, e2, BVH_MASK_VISIBLE, static_cast<GLuint>(i / 3) });
+            }
+        }
+        meshBvhs[mesh].Build(std::move(triangles), buildPool);
+    };
+
+    // Big meshes one at a time across the pool, the rest side by side as the pool can't nest
+    std::vector<size_t> small;
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        if (!used[i])
+        {
+            continue;
+        }
+        if (pool && scene.meshes[i].indices.size() >= PICK_PARALLEL_BUILD_TRIANGLES * 3)
+        {
+            build(i, pool);
+        }
+        else
+        {
+            small.push_back(i);
+        }
+    }
+    if (pool)
+    {
+        pool->ParallelFor(small.size(), [&](size_t i, unsigned) { build(small[i], nullptr); });
+    }
+    else
+    {
+        for (auto mesh : small)
+        {
+            build(mesh, nullptr);
+        }
+    }
+}
+
+bool Picker::Pick(const DynamicBvh& tree, const glm::vec3& origin, const glm::vec3& direction, GLfloat tMax, BvhCull cull, PickHit& hit) const
+{
+    hit = PickHit();
+    auto t = tree.QueryRay(origin, direction, tMax, [&](GLuint item, GLfloat tMax)
+    {
+        const auto& object = scene->objects[item];
+        const auto& bvh = meshBvhs[object.mesh];
+
+        // An affine transform keeps the ray parameter, so the object space t is the world space one
+        auto inverse = glm::inverse(object.model);
+        auto localOrigin = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+        auto localDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+
+        // A mirrored transform flips which side faces the camera
+        auto localCull = cull;
+        if (cull != BvhCull::None && glm::determinant(glm::mat3(object.model)) < 0.0f)
+        {
+            localCull = cull == BvhCull::BackFaces ? BvhCull::FrontFaces : BvhCull::BackFaces;
+        }
+
+        BvhHit meshHit;
+        meshHit.t = tMax;
+        if (!bvh.Intersect(localOrigin, localDirection, BVH_MASK_VISIBLE, localCull, meshHit))
+        {
+            return tMax;
+        }
+        hit.object = item;
+        hit.triangle = meshHit.id;
+        return meshHit.t;
+    });
+
+    if (hit.object == PICK_NO_HIT)
+    {
+        return false;
+    }
+    hit.t = t;
+    hit.position = origin + direction * t;
+    return true;
+}
+
+bool Picker::Pick(const DynamicBvh& tree, const glm::vec2& cursor, const glm::vec2& windowSize, const glm::mat4& view, const glm::mat4& projection, BvhCull cull, PickHit& hit) const
+{
+    // Through the cursor's pixel centre, from the near plane to the far one
+    auto ndc = glm::vec2((cursor.x + 0.5f) / windowSize.x * 2.0f - 1.0f, 1.0f - (cursor.y + 0.5f) / windowSize.y * 2.0f);
+    auto inverse = glm::inverse(projection * view);
+    auto nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    auto farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+    auto origin = glm::vec3(nearPoint) / nearPoint.w;
+    auto toFar = glm::vec3(farPoint) / farPoint.w - origin;
+    auto length = glm::length(toFar);
+    return Pick(tree, origin, toFar / length, length, cull, hit);
+}
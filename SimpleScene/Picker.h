@@ -0,0 +1,59 @@
+/*
+    Picker.h
+
+    Finds the object and triangle under the cursor on the CPU, with no GPU
+    readback. The scene's object tree finds the objects whose boxes the ray
+    crosses, nearest first, and each one is tested against a triangle Bvh of
+    its mesh built once in the mesh's own space, so instanced meshes share
+    one. The ray is taken into object space rather than the triangles into
+    world space, and keeps its parameter there, so hits compare directly.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_PICKER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_PICKER_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Bvh.h"
+#include "DynamicBvh.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+
+#define PICK_NO_HIT 0xFFFFFFFF
+
+// Meshes with at least this many triangles get the whole pool to build their Bvh
+#define PICK_PARALLEL_BUILD_TRIANGLES 65536
+
+struct PickHit
+{
+    GLuint object = PICK_NO_HIT; // Index into the scene's objects
+    GLuint triangle = PICK_NO_HIT; // Index into the object's mesh, its indices start at triangle * 3
+    GLfloat t = 0.0f; // Along the normalized world space direction
+    glm::vec3 position;
+};
+
+class Picker
+{
+public:
+    Picker() = default;
+    ~Picker() = default;
+
+    // Builds the meshes' Bvhs on the pool if one is given, the scene must outlive the picker
+    void Build(const Scene& scene, ThreadPool* pool = nullptr);
+
+    // Nearest hit before tMax, tree's items must be indices into the scene's objects
+    bool Pick(const DynamicBvh& tree, const glm::vec3& origin, const glm::vec3& direction, GLfloat tMax, BvhCull cull, PickHit& hit) const;
+
+    // Casts from a cursor in window pixels, top left origin as GLUT reports it, through view and projection up to the far plane
+    bool Pick(const DynamicBvh& tree, const glm::vec2& cursor, const glm::vec2& windowSize, const glm::mat4& view, const glm::mat4& projection, BvhCull cull, PickHit& hit) const;
+
+private:
+    const Scene* scene = nullptr;
+    std::vector<Bvh> meshBvhs; // Indexed like Scene::meshes, empty for meshes no object uses
+};
+
+#endif
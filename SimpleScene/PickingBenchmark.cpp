@@ -0,0 +1,148 @@
+#include "PickingBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace
+{
+    const size_t RAY_COUNT = 1000;
+
+    // Hits this close, relative to the distance, are the same one found another way
+    const GLfloat T_TOLERANCE = 1e-4f;
+
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    // Moller-Trumbore with no face culled, as the picker's mesh Bvhs test them
+    bool intersectTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& origin, const glm::vec3& direction, GLfloat& t)
+    {
+        auto e1 = v1 - v0;
+        auto e2 = v2 - v0;
+        if (glm::cross(e1, e2) == glm::vec3(0.0f))
+        {
+            return false;
+        }
+        auto p = glm::cross(direction, e2);
+        auto det = glm::dot(e1, p);
+        if (det == 0.0f)
+        {
+            return false;
+        }
+        auto invDet = 1.0f / det;
+        auto s = origin - v0;
+        auto u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+        auto q = glm::cross(s, e1);
+        auto v = glm::dot(direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+        t = glm::dot(e2, q) * invDet;
+        return t > 0.0f;
+    }
+
+    // Nearest hit before tMax over every triangle of every object, tMax if there is none
+    GLfloat pickEveryTriangle(const Scene& scene, const Ray& ray, GLfloat tMax)
+    {
+        auto nearest = tMax;
+        for (const auto& object : scene.objects)
+        {
+            const auto& mesh = scene.meshes[object.mesh];
+            auto inverse = glm::inverse(object.model);
+            auto localOrigin = glm::vec3(inverse * glm::vec4(ray.origin, 1.0f));
+            auto localDirection = glm::vec3(inverse * glm::vec4(ray.direction, 0.0f));
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+            {
+                GLfloat t;
+                if (intersectTriangle(mesh.vertices[mesh.indices[i]].position, mesh.vertices[mesh.indices[i + 1]].position,
+                                      mesh.vertices[mesh.indices[i + 2]].position, localOrigin, localDirection, t) && t < nearest)
+                {
+                    nearest = t;
+                }
+            }
+        }
+        return nearest;
+    }
+}
+
+bool RunPickingBenchmark(std::ostream& out, const Scene& scene, const DynamicBvh& tree, const Picker& picker)
+{
+    if (scene.objects.empty())
+    {
+        out << "Picking: the scene has no objects" << std::endl;
+        return true;
+    }
+
+    BoundingBox bounds = scene.Box(scene.objects[0]);
+    size_t triangles = 0;
+    for (const auto& object : scene.objects)
+    {
+        bounds = Union(bounds, scene.Box(object));
+        triangles += scene.meshes[object.mesh].indices.size() / 3;
+    }
+    auto tMax = 2.0f * glm::length(bounds.max - bounds.min);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<GLfloat> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<size_t> anyObject(0, scene.objects.size() - 1);
+    std::vector<Ray> rays(RAY_COUNT);
+    for (size_t i = 0; i < RAY_COUNT; ++i)
+    {
+        auto& ray = rays[i];
+        ray.origin = bounds.min + (bounds.max - bounds.min) * glm::vec3(unit(random), unit(random), unit(random));
+        glm::vec3 toward;
+        if (i % 2 == 0)
+        {
+            toward = glm::vec3(scene.Bounds(scene.objects[anyObject(random)])) - ray.origin;
+        }
+        else
+        {
+            toward = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - 1.0f;
+        }
+        ray.direction = glm::length(toward) > 0.0f ? glm::normalize(toward) : glm::vec3(0.0f, -1.0f, 0.0f);
+    }
+
+    out << "Picking, " << scene.objects.size() << " objects, " << triangles << " triangles, " << RAY_COUNT << " rays, one thread" << std::endl;
+    std::vector<double> times;
+    std::vector<GLfloat> picked(RAY_COUNT);
+    size_t hits = 0;
+    for (size_t i = 0; i < RAY_COUNT; ++i)
+    {
+        PickHit hit;
+        auto start = std::chrono::steady_clock::now();
+        auto found = picker.Pick(tree, rays[i].origin, rays[i].direction, tMax, BvhCull::None, hit);
+        times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        picked[i] = found ? hit.t : tMax;
+        hits += found ? 1 : 0;
+    }
+    std::sort(times.begin(), times.end());
+    out << "  " << times[times.size() / 2] << " us median, " << times[times.size() * 99 / 100] << " us p99, "
+        << hits << " hits" << std::endl;
+
+    // Every triangle for every ray is slow on big scenes, so the reference gets all the threads
+    ThreadPool pool;
+    std::vector<GLfloat> expected(RAY_COUNT);
+    auto start = std::chrono::steady_clock::now();
+    pool.ParallelFor(RAY_COUNT, [&](size_t i, unsigned) { expected[i] = pickEveryTriangle(scene, rays[i], tMax); });
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t matches = 0;
+    for (size_t i = 0; i < RAY_COUNT; ++i)
+    {
+        matches += std::abs(picked[i] - expected[i]) <= T_TOLERANCE * std::max(1.0f, expected[i]) ? 1 : 0;
+    }
+    out << "  every triangle on " << pool.Size() << " threads: " << seconds * 1e6 / RAY_COUNT << " us per ray, "
+        << matches << " of " << RAY_COUNT << " match" << std::endl;
+    return matches == RAY_COUNT;
+}
@@ -0,0 +1,23 @@
+/*
+    PickingBenchmark.h
+
+    Pick times over the loaded scene, each pick checked against testing
+    every triangle of every object. Rays start inside the scene's bounds,
+    half of them aimed at an object's centre so most of those hit. Run with
+    --benchmark-picking, which quits once the scene is loaded.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_PICKING_BENCHMARK_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_PICKING_BENCHMARK_H_INCLUDED
+
+#include <ostream>
+
+#include "DynamicBvh.h"
+#include "Picker.h"
+#include "Scene.h"
+
+// Returns false if any pick differed from testing every triangle. tree & picker must be built over scene
+bool RunPickingBenchmark(std::ostream& out, const Scene& scene, const DynamicBvh& tree, const Picker& picker);
+
+#endif
@@ -0,0 +1,138 @@
+/*
+    RangeAllocator.h
+
+    First-fit offset allocator over [0, capacity). Only hands out offsets, the
+    memory itself lives elsewhere (e.g. in a GPU buffer).
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_RANGE_ALLOCATOR_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_RANGE_ALLOCATOR_H_INCLUDED
+
+#include <iterator>
+#include <map>
+
+#include <GL/glew.h>
+
+class RangeAllocator
+{
+public:
+    static const GLuint INVALID_OFFSET = 0xFFFFFFFF;
+
+    explicit RangeAllocator(GLuint capacity = 0)
+    {
+        Reset(capacity);
+    }
+
+    // Forgets every allocation
+    void Reset(GLuint capacity)
+    {
+        this->capacity = capacity;
+        freeBlocks.clear();
+        if (capacity > 0)
+        {
+            freeBlocks[0] = capacity;
+        }
+        freeSize = capacity;
+    }
+
+    // Returns INVALID_OFFSET if no free block is big enough
+    GLuint Allocate(GLuint size)
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        for (auto block = freeBlocks.begin(); block != freeBlocks.end(); ++block)
+        {
+            if (block->second < size)
+            {
+                continue;
+            }
+
+            auto offset = block->first;
+            auto remaining = block->second - size;
+            freeBlocks.erase(block);
+            if (remaining > 0)
+            {
+                freeBlocks[offset + size] = remaining;
+            }
+            freeSize -= size;
+            return offset;
+        }
+        return INVALID_OFFSET;
+    }
+
+    // Returns a block, merging it with free neighbours
+    void Free(GLuint offset, GLuint size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        freeSize += size;
+        auto next = freeBlocks.lower_bound(offset);
+        if (next != freeBlocks.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                freeBlocks.erase(previous);
+            }
+        }
+        if (next != freeBlocks.end() && offset + size == next->first)
+        {
+            size += next->second;
+            freeBlocks.erase(next);
+        }
+        freeBlocks[offset] = size;
+    }
+
+    // Adds free space at the end
+    void Grow(GLuint newCapacity)
+    {
+        if (newCapacity <= capacity)
+        {
+            return;
+        }
+
+        auto oldCapacity = capacity;
+        capacity = newCapacity;
+        Free(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    GLuint Capacity() const
+    {
+        return capacity;
+    }
+
+    GLuint FreeSize() const
+    {
+        return freeSize;
+    }
+
+    // Size of the biggest single allocation that would currently succeed
+    GLuint LargestFreeBlock() const
+    {
+        GLuint largest = 0;
+        for (const auto& block : freeBlocks)
+        {
+            if (block.second > largest)
+            {
+                largest = block.second;
+            }
+        }
+        return largest;
+    }
+
+private:
+    GLuint capacity = 0;
+    GLuint freeSize = 0;
+    std::map<GLuint, GLuint> freeBlocks; // Offset -> size
+};
+
+#endif
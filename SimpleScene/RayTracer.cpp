@@ -0,0 +1,296 @@
+#include "RayTracer.h"
+
+#include <algorithm>
+
+#include "Lighting.h"
+
+namespace
+{
+    const glm::vec3 CLEAR_COLOR(0.2f, 0.3f, 0.3f);
+
+    // Shadow rays start this far off the surface and stop this much short of the light
+    const GLfloat SHADOW_OFFSET = 1e-3f;
+    const GLfloat SHADOW_END = 1.0f - 1e-3f;
+
+    const int SHADOW_LIGHTS = MAX_POINT_LIGHTS + 1 + MAX_DISCO_LIGHTS;
+
+    GLuint packColor(const glm::vec3& color)
+    {
+        auto c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return static_cast<GLuint>(c.r) | static_cast<GLuint>(c.g) << 8 | static_cast<GLuint>(c.b) << 16 | 0xFF000000u;
+    }
+
+    glm::vec3 unproject(const glm::mat4& inverseViewProjection, GLfloat x, GLfloat y, GLfloat z)
+    {
+        auto point = inverseViewProjection * glm::vec4(x, y, z, 1.0f);
+        return glm::vec3(point) / point.w;
+    }
+
+    template <typename Light>
+    bool castsLight(const Light& light)
+    {
+        return light.diffuse != glm::vec3(0.0f) || light.specular != glm::vec3(0.0f);
+    }
+
+    // Outside the outer cone a spot light adds nothing, shadowed or not
+    bool insideCone(const SpotLightBlock& light, const glm::vec3& position)
+    {
+        return glm::dot(glm::normalize(light.position - position), glm::normalize(-light.direction)) > light.outerCutOff;
+    }
+}
+
+void RayTracer::Setup(ThreadPool& pool)
+{
+    this->pool = &pool;
+}
+
+void RayTracer::Build(const Scene& scene)
+{
+    std::vector<BvhTriangle> triangles;
+    shading.clear();
+    objectCount = static_cast<GLuint>(scene.objects.size());
+
+    // Lamps are seen but cast no shadows, the point lights sit inside them
+    auto add = [&](const SceneObject& object, GLuint index, GLuint mask)
+    {
+        const auto& mesh = scene.meshes[object.mesh];
+        auto normalMatrix = glm::mat3(glm::transpose(glm::inverse(object.model)));
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            glm::vec3 position[3];
+            TriangleShading triangle;
+            for (auto k = 0; k < 3; ++k)
+            {
+                const auto& vertex = mesh.vertices[mesh.indices[i + k]];
+                position[k] = glm::vec3(object.model * glm::vec4(vertex.position, 1.0f));
+                triangle.normal[k] = normalMatrix * vertex.normal;
+            }
+            auto e1 = position[1] - position[0];
+            auto e2 = position[2] - position[0];
+            auto cross = glm::cross(e1, e2);
+            if (cross == glm::vec3(0.0f))
+            {
+                continue;
+            }
+            triangle.faceNormal = glm::normalize(cross);
+            triangle.object = index;
+            triangles.push_back({ position[0], e1, e2, mask, static_cast<GLuint>(shading.size()) });
+            shading.push_back(triangle);
+        }
+    };
+    for (GLuint i = 0; i < scene.objects.size(); ++i)
+    {
+        add(scene.objects[i], i, BVH_MASK_VISIBLE | BVH_MASK_SHADOW_CASTER);
+    }
+    for (GLuint i = 0; i < scene.lamps.size(); ++i)
+    {
+        add(scene.lamps[i], objectCount + i, BVH_MASK_VISIBLE);
+    }
+
+    bvh.Build(std::move(triangles), pool);
+}
+
+void RayTracer::Resize(int width, int height)
+{
+    if (width == this->width && height == this->height)
+    {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+    tilesX = (width + RAY_TILE_SIZE - 1) / RAY_TILE_SIZE;
+    tilesY = (height + RAY_TILE_SIZE - 1) / RAY_TILE_SIZE;
+    pixels.assign(static_cast<size_t>(width) * height, 0);
+}
+
+void RayTracer::Render(const Scene& scene, const CameraBlock& camera, const LightBlock& lights, const RasterSettings& settings)
+{
+    this->scene = &scene;
+    this->camera = &camera;
+    this->lights = &lights;
+    this->settings = settings;
+    inverseViewProjection = glm::inverse(camera.projection * camera.view);
+
+    pool->ParallelFor(static_cast<size_t>(tilesX) * tilesY, [this](size_t tile, unsigned) { traceTile(static_cast<int>(tile)); });
+}
+
+void RayTracer::traceTile(int tile)
+{
+    auto tileX = (tile % tilesX) * RAY_TILE_SIZE;
+    auto tileY = (tile / tilesX) * RAY_TILE_SIZE;
+    auto endX = std::min(tileX + RAY_TILE_SIZE, width);
+    auto endY = std::min(tileY + RAY_TILE_SIZE, height);
+
+    auto cull = BvhCull::None;
+    if (settings.useBackfaceCulling)
+    {
+        cull = settings.cullFrontFace ? BvhCull::FrontFaces : BvhCull::BackFaces;
+    }
+
+    glm::vec3 lightPositions[SHADOW_LIGHTS];
+    bool lightActive[SHADOW_LIGHTS];
+    for (auto i = 0; i < MAX_POINT_LIGHTS; ++i)
+    {
+        lightPositions[i] = lights->pointLights[i].position;
+        lightActive[i] = castsLight(lights->pointLights[i]);
+    }
+    for (auto i = 0; i <= MAX_DISCO_LIGHTS; ++i)
+    {
+        const auto& light = i == 0 ? lights->spotLight : lights->discoLights[i - 1];
+        lightPositions[MAX_POINT_LIGHTS + i] = light.position;
+        lightActive[MAX_POINT_LIGHTS + i] = castsLight(light);
+    }
+
+    // 2x2 packets, lanes outside the window are left inactive
+    for (auto y = tileY; y < endY; y += 2)
+    {
+        for (auto x = tileX; x < endX; x += 2)
+        {
+            int laneX[4] = { x, x + 1, x, x + 1 };
+            int laneY[4] = { y, y, y + 1, y + 1 };
+            glm::vec3 origins[4], directions[4];
+            int activeBits[4];
+            for (auto lane = 0; lane < 4; ++lane)
+            {
+                auto ndcX = (laneX[lane] + 0.5f) / width * 2.0f - 1.0f;
+                auto ndcY = (laneY[lane] + 0.5f) / height * 2.0f - 1.0f;
+
+                // Near to far plane is t from 0 to 1, for orthographic and perspective cameras alike
+                origins[lane] = unproject(inverseViewProjection, ndcX, ndcY, -1.0f);
+                directions[lane] = unproject(inverseViewProjection, ndcX, ndcY, 1.0f) - origins[lane];
+                activeBits[lane] = laneX[lane] < endX && laneY[lane] < endY ? -1 : 0;
+            }
+            auto active = _mm_castsi128_ps(_mm_setr_epi32(activeBits[0], activeBits[1], activeBits[2], activeBits[3]));
+            auto packet = MakeRayPacket(origins, directions);
+
+            PacketHit hit = { _mm_set1_ps(1.0f), _mm_setzero_ps(), _mm_setzero_ps(), _mm_set1_epi32(static_cast<int>(BVH_NO_HIT)) };
+            bvh.Intersect(packet, active, BVH_MASK_VISIBLE, cull, hit);
+
+            GLfloat t[4], u[4], v[4];
+            GLuint id[4];
+            _mm_storeu_ps(t, hit.t);
+            _mm_storeu_ps(u, hit.u);
+            _mm_storeu_ps(v, hit.v);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(id), hit.id);
+
+            // Hit points, and which lanes need lighting at all
+            glm::vec3 positions[4], normals[4], shadowOrigins[4];
+            int litBits[4];
+            for (auto lane = 0; lane < 4; ++lane)
+            {
+                litBits[lane] = 0;
+                if (!activeBits[lane] || id[lane] == BVH_NO_HIT)
+                {
+                    continue;
+                }
+                const auto& triangle = shading[id[lane]];
+                positions[lane] = origins[lane] + directions[lane] * t[lane];
+                if (settings.useSmoothShading)
+                {
+                    normals[lane] = triangle.normal[0] * (1.0f - u[lane] - v[lane]) + triangle.normal[1] * u[lane] + triangle.normal[2] * v[lane];
+                }
+                else
+                {
+                    normals[lane] = triangle.normal[2];
+                }
+
+                // Off the side the ray came from, so the surface doesn't shadow itself
+                auto side = glm::dot(triangle.faceNormal, directions[lane]) > 0.0f ? -1.0f : 1.0f;
+                shadowOrigins[lane] = positions[lane] + triangle.faceNormal * (side * SHADOW_OFFSET);
+                litBits[lane] = triangle.object < objectCount ? -1 : 0;
+            }
+
+            // One packet per light, bit i of occluded[lane] set where light i is blocked
+            int occluded[4] = { 0, 0, 0, 0 };
+            auto lit = _mm_castsi128_ps(_mm_setr_epi32(litBits[0], litBits[1], litBits[2], litBits[3]));
+            if (_mm_movemask_ps(lit) != 0)
+            {
+                for (auto light = 0; light < SHADOW_LIGHTS; ++light)
+                {
+                    if (!lightActive[light])
+                    {
+                        continue;
+                    }
+                    int testBits[4];
+                    glm::vec3 toLight[4];
+                    for (auto lane = 0; lane < 4; ++lane)
+                    {
+                        testBits[lane] = litBits[lane];
+                        toLight[lane] = glm::vec3(0.0f, 1.0f, 0.0f);
+                        if (!litBits[lane])
+                        {
+                            continue;
+                        }
+                        toLight[lane] = lightPositions[light] - shadowOrigins[lane];
+                        if (light >= MAX_POINT_LIGHTS)
+                        {
+                            auto index = light - MAX_POINT_LIGHTS;
+                            const auto& spot = index == 0 ? lights->spotLight : lights->discoLights[index - 1];
+                            testBits[lane] = insideCone(spot, positions[lane]) ? -1 : 0;
+                        }
+                    }
+                    auto test = _mm_castsi128_ps(_mm_setr_epi32(testBits[0], testBits[1], testBits[2], testBits[3]));
+                    if (_mm_movemask_ps(test) == 0)
+                    {
+                        continue;
+                    }
+                    auto shadowPacket = MakeRayPacket(shadowOrigins, toLight);
+                    auto blocked = _mm_movemask_ps(bvh.Occluded(shadowPacket, test, _mm_set1_ps(SHADOW_END), BVH_MASK_SHADOW_CASTER));
+                    for (auto lane = 0; lane < 4; ++lane)
+                    {
+                        if (blocked & (1 << lane))
+                        {
+                            occluded[lane] |= 1 << light;
+                        }
+                    }
+                }
+            }
+
+            for (auto lane = 0; lane < 4; ++lane)
+            {
+                if (!activeBits[lane])
+                {
+                    continue;
+                }
+                auto& pixel = pixels[static_cast<size_t>(laneY[lane]) * width + laneX[lane]];
+                if (id[lane] == BVH_NO_HIT)
+                {
+                    pixel = packColor(CLEAR_COLOR);
+                    continue;
+                }
+                if (!litBits[lane])
+                {
+                    pixel = packColor(glm::vec3(1.0f)); // As lamp.frag
+                    continue;
+                }
+
+                // CalcLighting, with blocked lights reduced to their ambient term
+                const auto& object = scene->objects[shading[id[lane]].object];
+                const auto& sceneMaterial = scene->materials[object.material];
+                const auto& material = settings.useColorTracking ? sceneMaterial.tracked : sceneMaterial.material;
+                auto norm = glm::normalize(normals[lane]);
+                auto viewDir = glm::normalize(camera->viewPos - positions[lane]);
+                glm::vec3 color(0.0f);
+                for (auto i = 0; i < MAX_POINT_LIGHTS; ++i)
+                {
+                    auto light = lights->pointLights[i];
+                    if (occluded[lane] & (1 << i))
+                    {
+                        light.diffuse = light.specular = glm::vec3(0.0f);
+                    }
+                    color += CalcPointLight(light, material, norm, positions[lane], viewDir);
+                }
+                for (auto i = 0; i <= MAX_DISCO_LIGHTS; ++i)
+                {
+                    auto light = i == 0 ? lights->spotLight : lights->discoLights[i - 1];
+                    if (occluded[lane] & (1 << (MAX_POINT_LIGHTS + i)))
+                    {
+                        light.diffuse = light.specular = glm::vec3(0.0f);
+                    }
+                    color += CalcSpotLight(light, material, norm, positions[lane], viewDir);
+                }
+                pixel = packColor(color);
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/*
+    RayTracer.h
+
+    Reference renderer for stills on machines without a GPU. Rays are cast
+    from the same camera matrices the shaders get, four at a time in SSE
+    lanes, against a Bvh of the whole scene at its finest level of detail.
+    Surfaces are lit as in smooth_shader.frag, except that every point and
+    spot light also sends a shadow ray and only adds its ambient term where
+    something is in the way. Flat shading takes the provoking vertex's normal
+    for the whole triangle but keeps the shadows per pixel.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_RAY_TRACER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_RAY_TRACER_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Bvh.h"
+#include "FrameData.h"
+#include "Scene.h"
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+// Square blocks of pixels handed to the pool, a multiple of the 2x2 packets
+#define RAY_TILE_SIZE 16
+
+class RayTracer
+{
+public:
+    RayTracer() = default;
+    ~RayTracer() = default;
+
+    void Setup(ThreadPool& pool);
+
+    // The scene is static, objects & lamps are only gathered again if this is called again
+    void Build(const Scene& scene);
+
+    void Resize(int width, int height);
+    void Render(const Scene& scene, const CameraBlock& camera, const LightBlock& lights, const RasterSettings& settings);
+
+    // Whole scene in world space, also usable for picking
+    const Bvh& Hierarchy() const
+    {
+        return bvh;
+    }
+
+    // RGBA8, bottom row first as glTexImage2D expects
+    const std::vector<GLuint>& Pixels() const
+    {
+        return pixels;
+    }
+
+    int Width() const
+    {
+        return width;
+    }
+
+    int Height() const
+    {
+        return height;
+    }
+
+private:
+    // What shading needs of a triangle the Bvh hands back by id
+    struct TriangleShading
+    {
+        glm::vec3 normal[3];
+        glm::vec3 faceNormal;
+        GLuint object; // Into objects, then lamps
+    };
+
+    void traceTile(int tile);
+
+    ThreadPool* pool = nullptr;
+    Bvh bvh;
+    std::vector<TriangleShading> shading;
+    GLuint objectCount = 0;
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<GLuint> pixels;
+
+    // Valid during Render
+    const Scene* scene = nullptr;
+    const CameraBlock* camera = nullptr;
+    const LightBlock* lights = nullptr;
+    glm::mat4 inverseViewProjection;
+    RasterSettings settings;
+};
+
+#endif
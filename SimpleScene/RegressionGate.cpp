@@ -0,0 +1,300 @@
+#include "RegressionGate.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "ImageFile.h"
+
+namespace
+{
+    // Measured frames the golden images are taken at
+    const int GOLDEN_FRAMES[] = { 0, GATE_FRAMES / 2, GATE_FRAMES - 1 };
+
+    double median(std::vector<double> values)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        return *middle;
+    }
+
+    bool timerQueries()
+    {
+        return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    }
+
+    bool readMetrics(const std::string& path, std::map<std::string, double>& metrics)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            return false;
+        }
+        std::string name;
+        double value;
+        while (file >> name >> value)
+        {
+            metrics[name] = value;
+        }
+        return true;
+    }
+}
+
+void RegressionGate::Setup(const std::string& directory, const std::string& build, const std::string& images,
+                           const std::vector<std::string>& viewNames, bool update)
+{
+    this->directory = directory;
+    this->build = build;
+    this->images = images;
+    this->update = update;
+    script = CameraScript::RoomTour((GATE_WARMUP_FRAMES + GATE_FRAMES) * GATE_TIME_STEP);
+    views.resize(viewNames.size());
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        views[i].name = viewNames[i];
+    }
+    loadThresholds();
+}
+
+GLfloat RegressionGate::BeginFrame(int view, Camera& camera)
+{
+    auto& state = views[view];
+    auto time = std::min(state.frame, GATE_WARMUP_FRAMES + GATE_FRAMES) * GATE_TIME_STEP;
+    script.Apply(time, camera);
+
+    state.measuring = state.frame >= GATE_WARMUP_FRAMES && state.frame < GATE_WARMUP_FRAMES + GATE_FRAMES;
+    if (state.measuring)
+    {
+        if (timerQueries())
+        {
+            if (state.queries[0] == 0)
+            {
+                glGenQueries(GATE_QUERIES, state.queries);
+            }
+            collectGpuTimes(state, false);
+            if (state.pending[state.nextQuery])
+            {
+                // The GPU is a whole ring behind, so this frame has to wait for it
+                collectGpuTimes(state, true);
+            }
+            glBeginQuery(GL_TIME_ELAPSED, state.queries[state.nextQuery]);
+        }
+        state.startCounters = ReadFrameCounters();
+        state.start = std::chrono::steady_clock::now();
+    }
+    return time;
+}
+
+bool RegressionGate::EndFrame(int view, int width, int height)
+{
+    auto& state = views[view];
+    if (state.measuring)
+    {
+        // Counters & CPU time before anything the gate itself does
+        auto end = std::chrono::steady_clock::now();
+        auto counters = ReadFrameCounters() - state.startCounters;
+        state.cpuMs.push_back(std::chrono::duration<double, std::milli>(end - state.start).count());
+        state.totals.drawCalls += counters.drawCalls;
+        state.totals.glCalls += counters.glCalls;
+        state.totals.uniformUploads += counters.uniformUploads;
+        state.totals.allocations += counters.allocations;
+
+        if (timerQueries())
+        {
+            // Read frames later in BeginFrame, so the CPU doesn't wait on the GPU here
+            glEndQuery(GL_TIME_ELAPSED);
+            state.pending[state.nextQuery] = true;
+            state.nextQuery = (state.nextQuery + 1) % GATE_QUERIES;
+        }
+
+        auto frame = state.frame - GATE_WARMUP_FRAMES;
+        if (std::find(std::begin(GOLDEN_FRAMES), std::end(GOLDEN_FRAMES), frame) != std::end(GOLDEN_FRAMES))
+        {
+            Image image = { frame, width, height, std::vector<GLuint>(static_cast<size_t>(width) * height) };
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadBuffer(GL_BACK);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+            state.images.push_back(std::move(image));
+        }
+        state.measuring = false;
+    }
+    ++state.frame;
+
+    if (finished)
+    {
+        return false;
+    }
+    for (const auto& other : views)
+    {
+        if (other.frame < GATE_WARMUP_FRAMES + GATE_FRAMES)
+        {
+            return false;
+        }
+    }
+    finished = true;
+    for (auto& other : views)
+    {
+        collectGpuTimes(other, true);
+    }
+    return true;
+}
+
+int RegressionGate::Finish(std::ostream& out)
+{
+    auto current = metrics();
+    auto baselinePath = directory + "/baseline_" + build + ".txt";
+
+    if (update)
+    {
+        std::ofstream file(baselinePath);
+        file << std::setprecision(6);
+        for (const auto& metric : current)
+        {
+            file << metric.first << " " << metric.second << "\n";
+        }
+        auto written = static_cast<bool>(file);
+        for (const auto& view : views)
+        {
+            for (const auto& image : view.images)
+            {
+                written = WritePpm(imagePath(view, image.frame), image.pixels, image.width, image.height) && written;
+            }
+        }
+        out << (written ? "Gate: Recorded baseline " : "Gate: Couldn't record baseline ") << baselinePath << std::endl;
+        return written ? 0 : 2;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!readMetrics(baselinePath, baseline))
+    {
+        out << "Gate: No baseline at " << baselinePath << ", record one with --gate-update" << std::endl;
+        return 2;
+    }
+
+    auto failed = false;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& metric : current)
+    {
+        auto found = baseline.find(metric.first);
+        if (found == baseline.end())
+        {
+            out << "Gate: " << metric.first << " " << metric.second << " (not in baseline)" << std::endl;
+            continue;
+        }
+
+        auto time = metric.first.find("_ms") != std::string::npos;
+        auto limit = found->second * (time ? thresholds.timeRatio : thresholds.countRatio) + (time ? thresholds.timeSlack : thresholds.countSlack);
+        auto regressed = metric.second > limit;
+        failed = failed || regressed;
+        out << "Gate: " << metric.first << " " << metric.second << " against " << found->second
+            << ", limit " << limit << (regressed ? "  REGRESSED" : "") << std::endl;
+    }
+
+    for (const auto& view : views)
+    {
+        for (const auto& image : view.images)
+        {
+            auto path = imagePath(view, image.frame);
+            std::vector<GLuint> golden;
+            int width, height;
+            if (!ReadPpm(path, golden, width, height))
+            {
+                out << "Gate: No golden image " << path << std::endl;
+                failed = true;
+                continue;
+            }
+
+            auto mismatch = width != image.width || height != image.height;
+            auto share = mismatch ? 1.0 : static_cast<double>(CountDifferingPixels(golden, image.pixels, thresholds.imageTolerance)) / golden.size();
+            if (mismatch || share > thresholds.imagePixels)
+            {
+                // Left next to the golden one to look at
+                auto currentPath = path.substr(0, path.size() - 4) + "_current.ppm";
+                WritePpm(currentPath, image.pixels, image.width, image.height);
+                out << "Gate: " << path << " differs in " << share * 100.0 << "% of pixels, see " << currentPath << "  REGRESSED" << std::endl;
+                failed = true;
+            }
+        }
+    }
+
+    out << (failed ? "Gate: FAILED" : "Gate: Passed") << " against " << baselinePath << std::endl;
+    return failed ? 1 : 0;
+}
+
+// Moves finished GPU times into the view, oldest first. Wait reads every pending one, however long it takes
+void RegressionGate::collectGpuTimes(View& view, bool wait)
+{
+    for (auto i = 0; i < GATE_QUERIES; ++i)
+    {
+        auto slot = (view.nextQuery + i) % GATE_QUERIES;
+        if (!view.pending[slot])
+        {
+            continue;
+        }
+        if (!wait)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(view.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                // Queries finish in order, so a later one can't be done either
+                break;
+            }
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(view.queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        view.gpuMs.push_back(nanoseconds / 1.0e6);
+        view.pending[slot] = false;
+    }
+}
+
+// Per frame over the measured frames: medians for times, means for counts
+std::map<std::string, double> RegressionGate::metrics() const
+{
+    std::map<std::string, double> result;
+    for (const auto& view : views)
+    {
+        auto frames = static_cast<double>(std::max<size_t>(view.cpuMs.size(), 1));
+        result[view.name + ".cpu_ms"] = median(view.cpuMs);
+        if (!view.gpuMs.empty())
+        {
+            result[view.name + ".gpu_ms"] = median(view.gpuMs);
+        }
+        result[view.name + ".draw_calls"] = view.totals.drawCalls / frames;
+        result[view.name + ".gl_calls"] = view.totals.glCalls / frames;
+        result[view.name + ".uniform_uploads"] = view.totals.uniformUploads / frames;
+        result[view.name + ".allocations"] = view.totals.allocations / frames;
+    }
+    return result;
+}
+
+void RegressionGate::loadThresholds()
+{
+    std::map<std::string, double> settings;
+    readMetrics(directory + "/thresholds.txt", settings);
+    auto set = [&settings](const char* name, double& value)
+    {
+        auto found = settings.find(name);
+        if (found != settings.end())
+        {
+            value = found->second;
+        }
+    };
+    auto imageTolerance = static_cast<double>(thresholds.imageTolerance);
+    set("time_ratio", thresholds.timeRatio);
+    set("time_slack", thresholds.timeSlack);
+    set("count_ratio", thresholds.countRatio);
+    set("count_slack", thresholds.countSlack);
+    set("image_tolerance", imageTolerance);
+    set("image_pixels", thresholds.imagePixels);
+    thresholds.imageTolerance = static_cast<int>(imageTolerance);
+}
+
+std::string RegressionGate::imagePath(const View& view, int frame) const
+{
+    return directory + "/" + images + "_" + view.name + "_" + std::to_string(frame) + ".ppm";
+}
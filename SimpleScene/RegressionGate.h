@@ -0,0 +1,113 @@
+/*
+    RegressionGate.h
+
+    Plays a fixed camera script through every view at a fixed time step and
+    measures each frame: CPU and GPU time, draw calls, GL calls, uniform
+    uploads and allocations. The results are compared against a baseline
+    stored per build, and a few frames of each view against golden images,
+    so a change that slows the scene down or alters what it draws fails
+    with a non-zero exit code. Run once with update set to record both.
+
+    Files in the gate directory:
+        baseline_<build>.txt     "<view>.<metric> <value>" per line
+        thresholds.txt           optional "<setting> <value>" per line, see GateThresholds
+        <images>_<view>_<frame>.ppm   golden images, per renderer rather than per build
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_REGRESSION_GATE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_REGRESSION_GATE_H_INCLUDED
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Camera.h"
+#include "CameraScript.h"
+#include "FrameStats.h"
+
+#define GATE_WARMUP_FRAMES 30
+#define GATE_FRAMES 120
+#define GATE_TIME_STEP (1.0f / 60.0f)
+#define GATE_QUERIES 4 // Frames a GPU time can lag behind before the gate waits on it
+
+// A metric regresses once it's above baseline * ratio + slack. Comments give the names in thresholds.txt
+struct GateThresholds
+{
+    double timeRatio = 1.15; // time_ratio, for cpu_ms & gpu_ms
+    double timeSlack = 0.05; // time_slack, milliseconds, so tiny timings don't fail on noise
+    double countRatio = 1.0; // count_ratio, for draw_calls, gl_calls, uniform_uploads & allocations
+    double countSlack = 0.5; // count_slack, per frame
+    int imageTolerance = 4; // image_tolerance, per channel out of 255
+    double imagePixels = 0.001; // image_pixels, share of pixels allowed past the tolerance
+};
+
+class RegressionGate
+{
+public:
+    RegressionGate() = default;
+    ~RegressionGate() = default;
+
+    // build names the baseline, images the golden image set. Update records instead of comparing
+    void Setup(const std::string& directory, const std::string& build, const std::string& images,
+               const std::vector<std::string>& viewNames, bool update);
+
+    bool Active() const
+    {
+        return !directory.empty();
+    }
+
+    // Places the camera along the script and gives the scripted time in seconds.
+    // Starts measuring, so it comes first in the view's frame
+    GLfloat BeginFrame(int view, Camera& camera);
+
+    // Before the swap with the view's context current. True once, when every view is done
+    bool EndFrame(int view, int width, int height);
+
+    // Prints the comparison and gives the exit code: 0 pass, 1 regression, 2 nothing to compare against
+    int Finish(std::ostream& out);
+
+private:
+    struct Image
+    {
+        int frame;
+        int width, height;
+        std::vector<GLuint> pixels;
+    };
+
+    struct View
+    {
+        std::string name;
+        int frame = 0;
+        GLuint queries[GATE_QUERIES] = {};
+        bool pending[GATE_QUERIES] = {};
+        int nextQuery = 0;
+        bool measuring = false;
+        std::chrono::steady_clock::time_point start;
+        FrameCounters startCounters;
+        std::vector<double> cpuMs;
+        std::vector<double> gpuMs;
+        FrameCounters totals;
+        std::vector<Image> images;
+    };
+
+    void collectGpuTimes(View& view, bool wait);
+    std::map<std::string, double> metrics() const;
+    void loadThresholds();
+    std::string imagePath(const View& view, int frame) const;
+
+    std::string directory;
+    std::string build;
+    std::string images;
+    bool update = false;
+    bool finished = false;
+    CameraScript script;
+    GateThresholds thresholds;
+    std::vector<View> views;
+};
+
+#endif
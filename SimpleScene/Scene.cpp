@@ -0,0 +1,186 @@
+#include "Scene.h"
+
+#include <cfloat>
+#include <functional>
+
+#include <GL/freeglut.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Chair.h"
+#include "LightProperties.h"
+#include "MeshCapture.h"
+#include "ObjectProperties.h"
+#include "OrnamentProperties.h"
+#include "Plane.h"
+#include "Table.h"
+
+GLuint Scene::AddMesh(MeshData mesh)
+{
+    meshes.push_back(std::move(mesh));
+    lods.push_back({ { static_cast<GLuint>(meshes.size() - 1), FLT_MAX } });
+    return static_cast<GLuint>(meshes.size() - 1);
+}
+
+GLuint Scene::AddLodChain(std::vector<MeshData> levels, const std::vector<GLfloat>& maxPixelRadii)
+{
+    std::vector<LodLevel> chain;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        chain.push_back({ AddMesh(std::move(levels[i])), i == 0 ? FLT_MAX : maxPixelRadii[i] });
+    }
+    lods[chain[0].mesh] = chain;
+    return chain[0].mesh;
+}
+
+GLuint Scene::AddMaterial(const Material& material)
+{
+    materials.push_back({ material, material });
+    return static_cast<GLuint>(materials.size() - 1);
+}
+
+GLuint Scene::AddMaterial(const Material& material, const glm::vec3& trackedColor)
+{
+    materials.push_back({ material, Material(trackedColor, trackedColor, trackedColor, material.shininess) });
+    return static_cast<GLuint>(materials.size() - 1);
+}
+
+void Scene::AddObject(GLuint mesh, GLuint material, const glm::mat4& model)
+{
+    objects.push_back({ mesh, material, model });
+}
+
+glm::vec4 Scene::Bounds(const SceneObject& object) const
+{
+    const auto& mesh = meshes[object.mesh];
+    auto scale = glm::max(glm::length(glm::vec3(object.model[0])),
+                 glm::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+    return glm::vec4(glm::vec3(object.model * glm::vec4(mesh.center, 1.0f)), mesh.radius * scale);
+}
+
+BoundingBox Scene::Box(const SceneObject& object) const
+{
+    auto bounds = Bounds(object);
+    return { glm::vec3(bounds) - bounds.w, glm::vec3(bounds) + bounds.w };
+}
+
+void BuildRoomScene(Scene& scene, RoomLayout* layout)
+{
+    static const int NUM_OF_ORNAMENTS = 8;
+    static const int NUM_OF_LOD_LEVELS = 4;
+    static const int lodSlices[NUM_OF_LOD_LEVELS] = { 100, 48, 24, 12 };
+
+    // Curved ornaments take the number of slices and stacks, the others ignore it
+    const std::function<void(int)> ornamentShapes[NUM_OF_ORNAMENTS] = {
+        [](int) { glutSolidTeapot(0.15f); },
+        [](int slices) { glutSolidSphere(0.15f, slices, slices); },
+        [](int slices) { glutSolidCone(0.15f, 0.5f, slices, slices); },
+        [](int slices) { glutSolidTorus(0.1f, 0.2f, slices, slices); },
+        [](int) { glutSolidDodecahedron(); },
+        [](int) { glutSolidOctahedron(); },
+        [](int) { glutSolidTetrahedron(); },
+        [](int) { glutSolidIcosahedron(); }
+    };
+    const bool ornamentIsCurved[NUM_OF_ORNAMENTS] = { false, true, true, true, false, false, false, false };
+
+    RoomLayout unused;
+    auto& placed = layout ? *layout : unused;
+
+    MeshCapture capture;
+    capture.Setup();
+
+    // Captures a tessellated GLUT shape at every level
+    auto addLodChain = [&](const std::function<void(int)>& shape)
+    {
+        std::vector<MeshData> levels;
+        std::vector<GLfloat> maxPixelRadii;
+        for (auto slices : lodSlices)
+        {
+            levels.push_back(capture.Capture([&] { shape(slices); }));
+            maxPixelRadii.push_back(LodMaxPixelRadius(slices));
+        }
+        return scene.AddLodChain(std::move(levels), maxPixelRadii);
+    };
+
+    for (auto i = 0; i < NUM_OF_ORNAMENTS; ++i)
+    {
+        auto mesh = ornamentIsCurved[i] ?
+            addLodChain(ornamentShapes[i]) :
+            scene.AddMesh(capture.Capture([&] { ornamentShapes[i](0); }));
+        auto material = scene.AddMaterial(ornamentMaterials[i], ornamentColors[i]);
+
+        glm::mat4 model;
+        model = glm::translate(model, ornamentPositions[i]);
+        model = glm::rotate(model, glm::radians(ornamentRotations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(ornamentRotations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(ornamentRotations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, ornamentScales[i]);
+        placed.ornaments.push_back(static_cast<GLuint>(scene.objects.size()));
+        scene.AddObject(mesh, material, model);
+    }
+
+    auto plane = scene.AddMesh(MeshData::FromArrays(planePositions, planeNormals, planeVertices));
+    auto planeMaterialId = scene.AddMaterial(planeMaterial);
+    const glm::vec3 wallScale(2.913f, 1.0f, 2.913f);
+    const glm::vec3 wallPositions[] = {
+        glm::vec3(0.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 2.28f, -2.28f),
+        glm::vec3(0.0f, 2.28f, 2.28f),
+        glm::vec3(0.0f, 4.56f, 0.0f),
+        glm::vec3(2.28f, 2.28f, 0.0f),
+        glm::vec3(-2.28f, 2.28f, 0.0f)
+    };
+    const glm::vec4 wallRotations[] = { // Angle, axis
+        glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+        glm::vec4(90.0f, 1.0f, 0.0f, 0.0f),
+        glm::vec4(270.0f, 1.0f, 0.0f, 0.0f),
+        glm::vec4(180.0f, 1.0f, 0.0f, 0.0f),
+        glm::vec4(90.0f, 0.0f, 0.0f, 1.0f),
+        glm::vec4(270.0f, 0.0f, 0.0f, 1.0f)
+    };
+    for (auto i = 0; i < 6; ++i)
+    {
+        glm::mat4 model;
+        model = glm::translate(model, wallPositions[i]);
+        model = glm::rotate(model, glm::radians(wallRotations[i].x), glm::vec3(wallRotations[i].y, wallRotations[i].z, wallRotations[i].w));
+        model = glm::scale(model, wallScale);
+        scene.AddObject(plane, planeMaterialId, model);
+    }
+
+    auto table = scene.AddMesh(MeshData::FromArrays(tablePositions, tableNormals, tableVertices));
+    scene.AddObject(table, scene.AddMaterial(tableMaterial), glm::mat4());
+
+    auto chair = scene.AddMesh(MeshData::FromArrays(chairPositions, chairNormals, chairVertices));
+    auto chairMaterialId = scene.AddMaterial(chairMaterial);
+    glm::mat4 model;
+    model = glm::translate(model, glm::vec3(1.2482f, -0.34394f, 0.0f));
+    model = glm::rotate(model, glm::radians(28.01f), glm::vec3(0.0f, 1.0f, 0.0f));
+    placed.chairs.push_back(static_cast<GLuint>(scene.objects.size()));
+    scene.AddObject(chair, chairMaterialId, model);
+    model = glm::mat4();
+    model = glm::translate(model, glm::vec3(-0.12125f, -0.34394f, -1.34712f));
+    model = glm::rotate(model, glm::radians(130.738f), glm::vec3(0.0f, 1.0f, 0.0f));
+    placed.chairs.push_back(static_cast<GLuint>(scene.objects.size()));
+    scene.AddObject(chair, chairMaterialId, model);
+
+    auto lamp = addLodChain([](int slices) { glutSolidSphere(1.0f, slices, slices); });
+    for (const auto& position : lightPositions)
+    {
+        model = glm::mat4();
+        model = glm::translate(model, position);
+        model = glm::scale(model, glm::vec3(0.05f));
+        scene.lamps.push_back({ lamp, 0, model });
+    }
+
+    for (size_t i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+    {
+        scene.pointLights.push_back({ lightPositions[i], glm::vec3(0.0f), lightMaterials[i],
+                                      lightConstant, lightAttenuation[i][0], lightAttenuation[i][1], 0.0f, 0.0f });
+    }
+    scene.spotLights.push_back({ spotLightPos, glm::normalize(spotLightDir), spotLightMaterial,
+                                 lightConstant, spotLightAttenuation[0], spotLightAttenuation[1], spotLightCutOff, spotLightOuterCutOff });
+    for (const auto& material : discoLightMaterials)
+    {
+        scene.spotLights.push_back({ discoLightsPos, discoLightsDir, material,
+                                     lightConstant, discoLightsAttenuation[0], discoLightsAttenuation[1], discoLightsCutOff, discoLightsOuterCutOff });
+    }
+}
@@ -0,0 +1,90 @@
+/*
+    Scene.h
+
+    Everything that gets drawn, described once on the CPU: meshes, materials,
+    the objects placing them and the lights. Each window builds its GPU
+    resources and its own lights from it.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_SCENE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_SCENE_H_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+#include "Lod.h"
+#include "Material.h"
+#include "Mesh.h"
+
+struct SceneMaterial
+{
+    Material material;
+    Material tracked; // Used while colour tracking is on
+};
+
+struct SceneObject
+{
+    GLuint mesh;
+    GLuint material;
+    glm::mat4 model;
+};
+
+// How a light starts out, the windows toggle and animate copies of it
+struct SceneLight
+{
+    glm::vec3 position;
+    glm::vec3 direction; // Spot lights only
+    Material material;
+    GLfloat constant;
+    GLfloat linear;
+    GLfloat quadratic;
+    GLfloat cutOff; // Degrees, spot lights only
+    GLfloat outerCutOff;
+};
+
+struct Scene
+{
+    std::vector<MeshData> meshes;
+    std::vector<std::vector<LodLevel>> lods; // Indexed like meshes, finest level (the mesh itself) first
+    std::vector<SceneMaterial> materials;
+    std::vector<SceneObject> objects;
+    std::vector<SceneObject> lamps; // Unlit markers at the point lights
+    std::vector<SceneLight> pointLights;
+    std::vector<SceneLight> spotLights; // The spot light, then the disco lights
+
+    GLuint AddMesh(MeshData mesh);
+
+    // Adds a mesh tessellated at several levels, finest first, and returns the finest.
+    // Each level is used up to the projected radius in maxPixelRadii.
+    GLuint AddLodChain(std::vector<MeshData> levels, const std::vector<GLfloat>& maxPixelRadii);
+
+    // A material which looks the same with colour tracking on
+    GLuint AddMaterial(const Material& material);
+
+    // A material which is drawn in a flat colour with colour tracking on
+    GLuint AddMaterial(const Material& material, const glm::vec3& trackedColor);
+
+    void AddObject(GLuint mesh, GLuint material, const glm::mat4& model);
+
+    // World space bounding sphere of an object's mesh, radius in w
+    glm::vec4 Bounds(const SceneObject& object) const;
+
+    // World space box around that sphere
+    BoundingBox Box(const SceneObject& object) const;
+};
+
+// Where BuildRoomScene put the things generators may move or recolour, as indices into Scene::objects
+struct RoomLayout
+{
+    std::vector<GLuint> ornaments;
+    std::vector<GLuint> chairs;
+};
+
+// Fills the scene with the room, its furniture, the ornaments on the table and the lamps.
+// Needs a current context, the GLUT ornaments are captured from the GPU.
+void BuildRoomScene(Scene& scene, RoomLayout* layout = nullptr);
+
+#endif
@@ -12,6 +12,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -35,14 +36,16 @@ public:
         Setup(vertexPath, fragmentPath);
     }
 
-    void Setup(const GLchar* path)
+    // Varyings, if given, are captured interleaved by transform feedback.
+    // Defines, if given, go in right after each stage's #version line
+    void Setup(const GLchar* path, const std::vector<const GLchar*>& feedbackVaryings = {}, const std::string& defines = "")
     {
         auto vertexPath = path + std::string(VERTEX_SHADER_EXT);
         auto fragmentPath = path + std::string(FRAGMENT_SHADER_EXT);
-        Setup(vertexPath.c_str(), fragmentPath.c_str());
+        Setup(vertexPath.c_str(), fragmentPath.c_str(), feedbackVaryings, defines);
     }
 
-    void Setup(const GLchar* vertexPath, const GLchar* fragmentPath)
+    void Setup(const GLchar* vertexPath, const GLchar* fragmentPath, const std::vector<const GLchar*>& feedbackVaryings = {}, const std::string& defines = "")
     {
         // 1. Retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -67,6 +70,11 @@ public:
             // Convert stream into string
             vertexCode = vShaderStream.str();
             fragmentCode = fShaderStream.str();
+            if (!defines.empty())
+            {
+                vertexCode.insert(vertexCode.find('\n') + 1, defines);
+                fragmentCode.insert(fragmentCode.find('\n') + 1, defines);
+            }
         }
         catch (std::ifstream::failure e)
         {
@@ -104,6 +112,10 @@ public:
         program = glCreateProgram();
         glAttachShader(program, vertex);
         glAttachShader(program, fragment);
+        if (!feedbackVaryings.empty())
+        {
+            glTransformFeedbackVaryings(program, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+        }
         glLinkProgram(program);
         // Print linking errors if any
         glGetProgramiv(program, GL_LINK_STATUS, &success);
@@ -123,6 +135,16 @@ public:
         glUseProgram(program);
     }
 
+    // Points a uniform block at a buffer binding, shaders without the block are left alone
+    void BindUniformBlock(const GLchar* name, GLuint binding) const
+    {
+        auto index = glGetUniformBlockIndex(program, name);
+        if (index != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(program, index, binding);
+        }
+    }
+
     const GLuint& operator()() const
     {
         return program;
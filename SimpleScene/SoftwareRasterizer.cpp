@@ -0,0 +1,425 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+
+#include <emmintrin.h>
+
+#include "Lighting.h"
+
+namespace
+{
+    const glm::vec3 CLEAR_COLOR(0.2f, 0.3f, 0.3f);
+    const GLuint NO_TRIANGLE = 0xFFFFFFFF;
+
+    GLuint packColor(const glm::vec3& color)
+    {
+        auto c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return static_cast<GLuint>(c.r) | static_cast<GLuint>(c.g) << 8 | static_cast<GLuint>(c.b) << 16 | 0xFF000000u;
+    }
+
+    const Material& materialOf(const Scene& scene, const SceneObject& object, bool useColorTracking)
+    {
+        const auto& material = scene.materials[object.material];
+        return useColorTracking ? material.tracked : material.material;
+    }
+}
+
+void SoftwareRasterizer::Setup(ThreadPool& pool)
+{
+    this->pool = &pool;
+    tileBuffers.resize(pool.Size());
+}
+
+void SoftwareRasterizer::Resize(int width, int height)
+{
+    if (width == this->width && height == this->height)
+    {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+    tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    pixels.assign(static_cast<size_t>(width) * height, 0);
+}
+
+void SoftwareRasterizer::Render(const Scene& scene, const CameraBlock& camera, const LightBlock& lights, const RasterSettings& settings)
+{
+    this->scene = &scene;
+    this->camera = &camera;
+    this->lights = &lights;
+    this->settings = settings;
+    lightSet = LightSet(lights);
+
+    auto batchCount = scene.objects.size() + scene.lamps.size();
+    batches.resize(batchCount);
+    for (size_t i = 0; i < batchCount; ++i)
+    {
+        auto lamp = i >= scene.objects.size();
+        batches[i].object = lamp ? &scene.lamps[i - scene.objects.size()] : &scene.objects[i];
+        batches[i].lamp = lamp;
+    }
+
+    pool->ParallelFor(batchCount, [this](size_t i, unsigned) { setupBatch(batches[i]); });
+    binTriangles();
+    pool->ParallelFor(static_cast<size_t>(tilesX) * tilesY, [this](size_t tile, unsigned thread)
+    {
+        rasterizeTile(static_cast<int>(tile), tileBuffers[thread]);
+        shadeTile(static_cast<int>(tile), tileBuffers[thread]);
+    });
+}
+
+void SoftwareRasterizer::setupBatch(Batch& batch)
+{
+    const auto& object = *batch.object;
+    batch.triangles.clear();
+    batch.binned.clear();
+
+    // Same level of detail the GL path would settle on
+    const auto& mesh0 = scene->meshes[object.mesh];
+    auto meshIndex = object.mesh;
+    const auto& lods = scene->lods[object.mesh];
+    if (lods.size() > 1)
+    {
+        auto scale = glm::max(glm::length(glm::vec3(object.model[0])),
+                     glm::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+        auto center = glm::vec3(object.model * glm::vec4(mesh0.center, 1.0f));
+        auto pixelRadius = ProjectedRadius(center, mesh0.radius * scale, camera->view, camera->projection, static_cast<GLfloat>(height));
+        meshIndex = lods[SelectLodLevel(lods, 0, pixelRadius)].mesh;
+    }
+    const auto& mesh = scene->meshes[meshIndex];
+
+    // Vertex stage, as in smooth_shader.vert
+    auto viewProjection = camera->projection * camera->view;
+    auto normalMatrix = glm::mat3(glm::transpose(glm::inverse(object.model)));
+    batch.vertices.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        auto world = object.model * glm::vec4(mesh.vertices[i].position, 1.0f);
+        batch.vertices[i] = { viewProjection * world, glm::vec3(world), normalMatrix * mesh.vertices[i].normal };
+    }
+
+    const auto& material = materialOf(*scene, object, settings.useColorTracking);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        ClipVertex in[3] = { batch.vertices[mesh.indices[i]], batch.vertices[mesh.indices[i + 1]], batch.vertices[mesh.indices[i + 2]] };
+
+        // flat_shader.vert lights the provoking (last) vertex for the whole triangle
+        glm::vec3 flatColor(1.0f);
+        if (!batch.lamp && !settings.useSmoothShading)
+        {
+            flatColor = CalcLighting(*lights, material, in[2].normal, in[2].position, camera->viewPos);
+        }
+
+        // Clip against the near plane, z >= -w, the only plane that needs real clipping
+        ClipVertex out[4];
+        auto count = 0;
+        for (auto j = 0; j < 3; ++j)
+        {
+            const auto& current = in[j];
+            const auto& next = in[(j + 1) % 3];
+            auto d0 = current.clip.z + current.clip.w;
+            auto d1 = next.clip.z + next.clip.w;
+            if (d0 >= 0.0f)
+            {
+                out[count++] = current;
+            }
+            if ((d0 >= 0.0f) != (d1 >= 0.0f))
+            {
+                auto t = d0 / (d0 - d1);
+                out[count++] = { glm::mix(current.clip, next.clip, t), glm::mix(current.position, next.position, t), glm::mix(current.normal, next.normal, t) };
+            }
+        }
+        for (auto j = 1; j + 1 < count; ++j)
+        {
+            ClipVertex triangle[3] = { out[0], out[j], out[j + 1] };
+            addTriangle(batch, triangle, flatColor);
+        }
+    }
+}
+
+void SoftwareRasterizer::addTriangle(Batch& batch, const ClipVertex* vertices, const glm::vec3& flatColor)
+{
+    RasterTriangle triangle;
+    GLfloat x[4], y[4];
+    for (auto i = 0; i < 3; ++i)
+    {
+        auto invW = 1.0f / vertices[i].clip.w;
+        x[i] = (vertices[i].clip.x * invW * 0.5f + 0.5f) * width;
+        y[i] = (vertices[i].clip.y * invW * 0.5f + 0.5f) * height;
+        triangle.z[i] = vertices[i].clip.z * invW;
+        triangle.invW[i] = invW;
+        triangle.position[i] = vertices[i].position;
+        triangle.normal[i] = vertices[i].normal;
+    }
+    x[3] = x[0];
+    y[3] = y[0];
+
+    // All three edges at once: lane i runs from vertex i + 1 to vertex i + 2
+    auto vx = _mm_loadu_ps(x);
+    auto vy = _mm_loadu_ps(y);
+    auto xj = _mm_shuffle_ps(vx, vx, _MM_SHUFFLE(3, 0, 2, 1));
+    auto yj = _mm_shuffle_ps(vy, vy, _MM_SHUFFLE(3, 0, 2, 1));
+    auto xk = _mm_shuffle_ps(vx, vx, _MM_SHUFFLE(3, 1, 0, 2));
+    auto yk = _mm_shuffle_ps(vy, vy, _MM_SHUFFLE(3, 1, 0, 2));
+    auto a = _mm_sub_ps(yj, yk);
+    auto b = _mm_sub_ps(xk, xj);
+    auto c = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_mul_ps(a, xj), _mm_mul_ps(b, yj)));
+
+    // The edge functions sum to twice the signed area everywhere, A and B cancel out
+    GLfloat cs[4];
+    _mm_storeu_ps(cs, c);
+    auto area = cs[0] + cs[1] + cs[2];
+    if (area == 0.0f)
+    {
+        return;
+    }
+
+    // Counter clockwise is front facing, as in GL
+    auto front = area > 0.0f;
+    if (settings.useBackfaceCulling && front == settings.cullFrontFace)
+    {
+        return;
+    }
+    if (!front)
+    {
+        auto negate = _mm_set1_ps(-0.0f);
+        a = _mm_xor_ps(a, negate);
+        b = _mm_xor_ps(b, negate);
+        c = _mm_xor_ps(c, negate);
+        area = -area;
+    }
+
+    // Left edges step inwards with x, top edges are horizontal and step inwards with -y
+    auto zero = _mm_setzero_ps();
+    auto topLeft = _mm_or_ps(_mm_cmpgt_ps(a, zero), _mm_and_ps(_mm_cmpeq_ps(a, zero), _mm_cmplt_ps(b, zero)));
+    _mm_storeu_ps(triangle.a, a);
+    _mm_storeu_ps(triangle.b, b);
+    _mm_storeu_ps(triangle.c, c);
+    _mm_storeu_ps(triangle.topLeft, topLeft);
+    triangle.invArea = 1.0f / area;
+    triangle.flatColor = flatColor;
+
+    auto minX = std::min({ x[0], x[1], x[2] });
+    auto maxX = std::max({ x[0], x[1], x[2] });
+    auto minY = std::min({ y[0], y[1], y[2] });
+    auto maxY = std::max({ y[0], y[1], y[2] });
+    triangle.minX = std::max(static_cast<int>(std::floor(minX)), 0);
+    triangle.minY = std::max(static_cast<int>(std::floor(minY)), 0);
+    triangle.maxX = std::min(static_cast<int>(std::ceil(maxX)), width - 1);
+    triangle.maxY = std::min(static_cast<int>(std::ceil(maxY)), height - 1);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+    {
+        return;
+    }
+
+    auto index = static_cast<GLuint>(batch.triangles.size());
+    batch.triangles.push_back(triangle);
+    for (auto ty = triangle.minY / RASTER_TILE_SIZE; ty <= triangle.maxY / RASTER_TILE_SIZE; ++ty)
+    {
+        for (auto tx = triangle.minX / RASTER_TILE_SIZE; tx <= triangle.maxX / RASTER_TILE_SIZE; ++tx)
+        {
+            batch.binned.push_back({ static_cast<GLuint>(ty * tilesX + tx), index });
+        }
+    }
+}
+
+void SoftwareRasterizer::binTriangles()
+{
+    // Counting sort by tile, batches in order so each tile draws in the same order as the GL path
+    auto tileCount = static_cast<size_t>(tilesX) * tilesY;
+    tileStarts.assign(tileCount + 1, 0);
+    for (const auto& batch : batches)
+    {
+        for (const auto& binned : batch.binned)
+        {
+            ++tileStarts[binned.tile + 1];
+        }
+    }
+    for (size_t tile = 1; tile <= tileCount; ++tile)
+    {
+        tileStarts[tile] += tileStarts[tile - 1];
+    }
+
+    tileEntries.resize(tileStarts.back());
+    tileFill.assign(tileStarts.begin(), tileStarts.end() - 1);
+    for (GLuint b = 0; b < batches.size(); ++b)
+    {
+        for (const auto& binned : batches[b].binned)
+        {
+            tileEntries[tileFill[binned.tile]++] = { b, binned.triangle };
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile, TileBuffer& buffer)
+{
+    std::fill(std::begin(buffer.depth), std::end(buffer.depth), 1.0f);
+    std::fill(std::begin(buffer.triangle), std::end(buffer.triangle), NO_TRIANGLE);
+
+    auto tileX = (tile % tilesX) * RASTER_TILE_SIZE;
+    auto tileY = (tile / tilesX) * RASTER_TILE_SIZE;
+    auto zero = _mm_setzero_ps();
+    auto steps = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+    for (auto i = tileStarts[tile]; i < tileStarts[tile + 1]; ++i)
+    {
+        const auto& entry = tileEntries[i];
+        const auto& triangle = batches[entry.batch].triangles[entry.triangle];
+        auto batchIndex = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(entry.batch)));
+        auto triangleIndex = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(entry.triangle)));
+
+        // Rows start on a multiple of four so every group of four lies inside the tile
+        auto x0 = std::max(triangle.minX, tileX) & ~3;
+        auto x1 = std::min(triangle.maxX, tileX + RASTER_TILE_SIZE - 1);
+        auto y0 = std::max(triangle.minY, tileY);
+        auto y1 = std::min(triangle.maxY, tileY + RASTER_TILE_SIZE - 1);
+
+        __m128 a[3], b4[3], topLeft[3];
+        for (auto e = 0; e < 3; ++e)
+        {
+            a[e] = _mm_set1_ps(triangle.a[e]);
+            b4[e] = _mm_set1_ps(triangle.b[e]);
+            topLeft[e] = _mm_set1_ps(triangle.topLeft[e]);
+        }
+        auto invArea = _mm_set1_ps(triangle.invArea);
+
+        for (auto y = y0; y <= y1; ++y)
+        {
+            auto py = _mm_set1_ps(y + 0.5f);
+            auto px = _mm_add_ps(_mm_set1_ps(static_cast<GLfloat>(x0)), steps);
+            __m128 edge[3];
+            for (auto e = 0; e < 3; ++e)
+            {
+                edge[e] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[e], px), _mm_mul_ps(b4[e], py)), _mm_set1_ps(triangle.c[e]));
+            }
+            auto row = (y - tileY) * RASTER_TILE_SIZE;
+
+            for (auto x = x0; x <= x1; x += 4)
+            {
+                auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (auto e = 0; e < 3; ++e)
+                {
+                    auto onEdge = _mm_and_ps(_mm_cmpeq_ps(edge[e], zero), topLeft[e]);
+                    inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edge[e], zero), onEdge));
+                }
+
+                if (_mm_movemask_ps(inside) != 0)
+                {
+                    // z / w is affine in screen space
+                    auto z = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(edge[0], _mm_set1_ps(triangle.z[0])),
+                        _mm_mul_ps(edge[1], _mm_set1_ps(triangle.z[1]))),
+                        _mm_mul_ps(edge[2], _mm_set1_ps(triangle.z[2]))), invArea);
+
+                    auto offset = row + x - tileX;
+                    auto depth = _mm_loadu_ps(buffer.depth + offset);
+                    auto pass = _mm_and_ps(inside, _mm_and_ps(_mm_cmplt_ps(z, depth), _mm_cmpge_ps(z, _mm_set1_ps(-1.0f))));
+                    if (_mm_movemask_ps(pass) != 0)
+                    {
+                        auto select = [pass](__m128 updated, __m128 old) { return _mm_or_ps(_mm_and_ps(pass, updated), _mm_andnot_ps(pass, old)); };
+                        _mm_storeu_ps(buffer.depth + offset, select(z, depth));
+                        auto batches4 = reinterpret_cast<GLfloat*>(buffer.batch + offset);
+                        auto triangles4 = reinterpret_cast<GLfloat*>(buffer.triangle + offset);
+                        _mm_storeu_ps(batches4, select(batchIndex, _mm_loadu_ps(batches4)));
+                        _mm_storeu_ps(triangles4, select(triangleIndex, _mm_loadu_ps(triangles4)));
+                    }
+                }
+
+                for (auto e = 0; e < 3; ++e)
+                {
+                    edge[e] = _mm_add_ps(edge[e], _mm_mul_ps(a[e], _mm_set1_ps(4.0f)));
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::shadeTile(int tile, TileBuffer& buffer)
+{
+    auto tileX = (tile % tilesX) * RASTER_TILE_SIZE;
+    auto tileY = (tile / tilesX) * RASTER_TILE_SIZE;
+    auto endX = std::min(tileX + RASTER_TILE_SIZE, width);
+    auto endY = std::min(tileY + RASTER_TILE_SIZE, height);
+
+    // Unlit pixels are final straight away, the rest are sorted by batch
+    auto clearColor = packColor(CLEAR_COLOR);
+    GLuint litCount = 0;
+    for (auto y = tileY; y < endY; ++y)
+    {
+        for (auto x = tileX; x < endX; ++x)
+        {
+            auto offset = (y - tileY) * RASTER_TILE_SIZE + x - tileX;
+            auto& pixel = pixels[static_cast<size_t>(y) * width + x];
+            if (buffer.triangle[offset] == NO_TRIANGLE)
+            {
+                pixel = clearColor;
+                continue;
+            }
+
+            const auto& batch = batches[buffer.batch[offset]];
+            if (batch.lamp || !settings.useSmoothShading)
+            {
+                pixel = packColor(batch.triangles[buffer.triangle[offset]].flatColor);
+                continue;
+            }
+            buffer.litPixels[litCount++] = static_cast<uint64_t>(buffer.batch[offset]) << 32 | static_cast<GLuint>(offset);
+        }
+    }
+    std::sort(buffer.litPixels, buffer.litPixels + litCount);
+
+    // Perspective correct position & normal of every lit pixel, in sorted order
+    for (GLuint slot = 0; slot < litCount; ++slot)
+    {
+        auto batchIndex = static_cast<GLuint>(buffer.litPixels[slot] >> 32);
+        auto offset = static_cast<GLuint>(buffer.litPixels[slot]);
+        auto x = tileX + static_cast<int>(offset % RASTER_TILE_SIZE);
+        auto y = tileY + static_cast<int>(offset / RASTER_TILE_SIZE);
+
+        const auto& triangle = batches[batchIndex].triangles[buffer.triangle[offset]];
+        auto px = x + 0.5f, py = y + 0.5f;
+        GLfloat weights[3], sum = 0.0f;
+        for (auto e = 0; e < 3; ++e)
+        {
+            weights[e] = (triangle.a[e] * px + triangle.b[e] * py + triangle.c[e]) * triangle.invW[e];
+            sum += weights[e];
+        }
+        glm::vec3 position(0.0f), normal(0.0f);
+        for (auto e = 0; e < 3; ++e)
+        {
+            position += triangle.position[e] * (weights[e] / sum);
+            normal += triangle.normal[e] * (weights[e] / sum);
+        }
+
+        buffer.pixel[slot] = static_cast<GLuint>(y) * width + x;
+        for (auto k = 0; k < 3; ++k)
+        {
+            buffer.shading[k][slot] = position[k];
+            buffer.shading[3 + k][slot] = normal[k];
+        }
+    }
+
+    // One kernel call per batch present in the tile
+    for (GLuint start = 0, end; start < litCount; start = end)
+    {
+        auto batchIndex = buffer.litPixels[start] >> 32;
+        end = start + 1;
+        while (end < litCount && buffer.litPixels[end] >> 32 == batchIndex)
+        {
+            ++end;
+        }
+        auto count = end - start;
+
+        ShadingBatch shading = {
+            { buffer.shading[0] + start, buffer.shading[1] + start, buffer.shading[2] + start },
+            { buffer.shading[3] + start, buffer.shading[4] + start, buffer.shading[5] + start },
+            { buffer.shading[6] + start, buffer.shading[7] + start, buffer.shading[8] + start },
+            count
+        };
+        ShadeBatch(lightSet, materialOf(*scene, *batches[batchIndex].object, settings.useColorTracking), camera->viewPos, shading);
+        for (auto i = start; i < end; ++i)
+        {
+            pixels[buffer.pixel[i]] = packColor(glm::vec3(buffer.shading[6][i], buffer.shading[7][i], buffer.shading[8][i]));
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/*
+    SoftwareRasterizer.h
+
+    Draws the scene on the CPU for machines without a GPU. Objects are set up
+    in parallel, with three edge equations per triangle computed at once in
+    SSE registers, and binned into screen tiles, one list per tile shared by
+    all objects, kept in draw order. Each tile is then resolved
+    by one thread against its own depth buffer, four pixels at a time, and
+    only the visible pixel of each position is shaded with the same lighting
+    as smooth_shader.frag, batched per object through LightingKernel.h.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_SOFTWARE_RASTERIZER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_SOFTWARE_RASTERIZER_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "FrameData.h"
+#include "LightingKernel.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+
+// Multiple of 4, rows of a tile are resolved four pixels at a time
+#define RASTER_TILE_SIZE 64
+
+// Window toggles the GL path applies through GL state
+struct RasterSettings
+{
+    bool useSmoothShading;
+    bool useColorTracking;
+    bool useBackfaceCulling;
+    bool cullFrontFace;
+};
+
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer() = default;
+    ~SoftwareRasterizer() = default;
+
+    void Setup(ThreadPool& pool);
+    void Resize(int width, int height);
+
+    // Objects are lit, lamps are drawn in plain white like lamp.frag
+    void Render(const Scene& scene, const CameraBlock& camera, const LightBlock& lights, const RasterSettings& settings);
+
+    // RGBA8, bottom row first as glTexImage2D expects
+    const std::vector<GLuint>& Pixels() const
+    {
+        return pixels;
+    }
+
+    int Width() const
+    {
+        return width;
+    }
+
+    int Height() const
+    {
+        return height;
+    }
+
+private:
+    struct ClipVertex
+    {
+        glm::vec4 clip;
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    struct RasterTriangle
+    {
+        // Edge equations, lane i is the edge opposite vertex i, lane 3 is unused
+        GLfloat a[4];
+        GLfloat b[4];
+        GLfloat c[4];
+        GLfloat topLeft[4]; // All bits set where the edge owns pixels exactly on it
+        GLfloat z[3];
+        GLfloat invW[3];
+        GLfloat invArea;
+        int minX, minY, maxX, maxY;
+        glm::vec3 position[3];
+        glm::vec3 normal[3];
+        glm::vec3 flatColor;
+    };
+
+    struct BinnedTriangle
+    {
+        GLuint tile;
+        GLuint triangle;
+    };
+
+    // One object's triangles and the tiles each one touches, gathered into the tiles' lists once all are set up
+    struct Batch
+    {
+        const SceneObject* object;
+        bool lamp;
+        std::vector<ClipVertex> vertices;
+        std::vector<RasterTriangle> triangles;
+        std::vector<BinnedTriangle> binned;
+    };
+
+    struct TileEntry
+    {
+        GLuint batch;
+        GLuint triangle;
+    };
+
+    struct TileBuffer
+    {
+        GLfloat depth[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        GLuint batch[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        GLuint triangle[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+
+        // Visible smooth shaded pixels as batch << 32 | offset, sorted so each batch present is one run.
+        // The shading arrays follow that order, as input for the lighting kernel
+        uint64_t litPixels[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        GLuint pixel[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        GLfloat shading[9][RASTER_TILE_SIZE * RASTER_TILE_SIZE]; // Position, normal & color
+    };
+
+    void setupBatch(Batch& batch);
+    void addTriangle(Batch& batch, const ClipVertex* vertices, const glm::vec3& flatColor);
+    void binTriangles();
+    void rasterizeTile(int tile, TileBuffer& buffer);
+    void shadeTile(int tile, TileBuffer& buffer);
+
+    ThreadPool* pool = nullptr;
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<GLuint> pixels;
+    std::vector<Batch> batches;
+    std::vector<GLuint> tileStarts; // Into tileEntries, one past the last tile too
+    std::vector<GLuint> tileFill; // Kept to avoid reallocating every frame
+    std::vector<TileEntry> tileEntries;
+    std::vector<TileBuffer> tileBuffers; // One per pool thread
+
+    // Valid during Render
+    const Scene* scene = nullptr;
+    const CameraBlock* camera = nullptr;
+    const LightBlock* lights = nullptr;
+    LightSet lightSet;
+    RasterSettings settings;
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "StaticBatch.h"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    bool hasMultiDrawIndirect()
+    {
+        return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+    }
+}
+
+StaticBatch::~StaticBatch()
+{
+    if (ownsDrawBuffer)
+    {
+        glDeleteBuffers(1, &drawBuffer);
+    }
+    glDeleteBuffers(1, &commandBuffer);
+}
+
+void StaticBatch::Build(const std::vector<SceneObject>& objects, const Scene& scene, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool)
+{
+    this->pool = &pool;
+    objectLods.clear();
+    objectLevels.clear();
+    objectBounds.clear();
+    objectVisible.clear();
+    draws.clear();
+    for (const auto& object : objects)
+    {
+        auto lods = scene.lods[object.mesh];
+        for (auto& level : lods)
+        {
+            level.mesh = meshHandles[level.mesh];
+        }
+        objectLods.push_back(lods);
+        objectLevels.push_back(0);
+
+        objectBounds.push_back(scene.Bounds(object));
+        objectVisible.push_back(1);
+
+        draws.push_back({ object.model, static_cast<GLint>(object.material), -1 });
+    }
+
+    if (!ownsDrawBuffer)
+    {
+        // Stop drawing from the shared buffer, this batch gets one of its own
+        drawBuffer = 0;
+        ownsDrawBuffer = true;
+    }
+    if (drawBuffer == 0)
+    {
+        glGenBuffers(1, &drawBuffer);
+    }
+    if (commandBuffer == 0)
+    {
+        glGenBuffers(1, &commandBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+    glBufferData(GL_ARRAY_BUFFER, draws.size() * sizeof(DrawData), draws.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    updateCommands(1);
+}
+
+void StaticBatch::Share(const StaticBatch& source)
+{
+    if (ownsDrawBuffer)
+    {
+        glDeleteBuffers(1, &drawBuffer);
+    }
+    if (commandBuffer == 0)
+    {
+        glGenBuffers(1, &commandBuffer);
+    }
+    drawBuffer = source.drawBuffer;
+    ownsDrawBuffer = false;
+
+    pool = source.pool;
+    objectLods = source.objectLods;
+    objectLevels.assign(objectLods.size(), 0);
+    objectBounds = source.objectBounds;
+    objectVisible.assign(objectLods.size(), 1);
+    draws = source.draws;
+
+    updateCommands(1);
+}
+
+void StaticBatch::Move(GLuint object, const glm::mat4& model, const glm::vec4& bounds)
+{
+    objectBounds[object] = bounds;
+    draws[object].model = model;
+    if (ownsDrawBuffer)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, object * sizeof(DrawData), sizeof(DrawData), &draws[object]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void StaticBatch::SetBakeBases(const std::vector<GLint>& bases)
+{
+    for (size_t i = 0; i < draws.size() && i < bases.size(); ++i)
+    {
+        draws[i].bakeBase = bases[i];
+    }
+    if (ownsDrawBuffer)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, drawBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, draws.size() * sizeof(DrawData), draws.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void StaticBatch::Cull(const DynamicBvh& tree, const Frustum& frustum, const OcclusionCuller* occlusion)
+{
+    visibleScratch.assign(objectVisible.size(), 0);
+    occludedCount = 0;
+    tree.QueryFrustum(frustum, [&](GLuint item)
+    {
+        visibleScratch[item] = !occlusion || occlusion->IsVisible(item);
+        occludedCount += !visibleScratch[item];
+    });
+    if (visibleScratch != objectVisible)
+    {
+        objectVisible.swap(visibleScratch);
+        commandsChanged = true;
+    }
+}
+
+void StaticBatch::Cull(const DynamicBvh& tree, const std::vector<Frustum>& frustums)
+{
+    visibleScratch.assign(objectVisible.size(), 0);
+    occludedCount = 0;
+    for (const auto& frustum : frustums)
+    {
+        tree.QueryFrustum(frustum, [&](GLuint item) { visibleScratch[item] = 1; });
+    }
+    if (visibleScratch != objectVisible)
+    {
+        objectVisible.swap(visibleScratch);
+        commandsChanged = true;
+    }
+}
+
+void StaticBatch::SetVisible(const std::vector<char>& visible)
+{
+    if (visible != objectVisible)
+    {
+        objectVisible = visible;
+        commandsChanged = true;
+    }
+}
+
+void StaticBatch::SelectLods(const glm::mat4& view, const glm::mat4& projection, GLfloat viewportHeight)
+{
+    SelectLods(&view, &projection, 1, viewportHeight);
+}
+
+void StaticBatch::SelectLods(const std::vector<glm::mat4>& views, const std::vector<glm::mat4>& projections, GLfloat viewportHeight)
+{
+    SelectLods(views.data(), projections.data(), std::min(views.size(), projections.size()), viewportHeight);
+}
+
+void StaticBatch::SelectLods(const glm::mat4* views, const glm::mat4* projections, size_t viewCount, GLfloat viewportHeight)
+{
+    for (size_t i = 0; i < objectLods.size(); ++i)
+    {
+        if (objectLods[i].size() < 2 || !objectVisible[i])
+        {
+            continue;
+        }
+
+        auto pixelRadius = 0.0f;
+        for (size_t view = 0; view < viewCount; ++view)
+        {
+            pixelRadius = glm::max(pixelRadius, ProjectedRadius(glm::vec3(objectBounds[i]), objectBounds[i].w, views[view], projections[view], viewportHeight));
+        }
+        auto level = SelectLodLevel(objectLods[i], objectLevels[i], pixelRadius);
+        if (level != objectLevels[i])
+        {
+            objectLevels[i] = level;
+            commandsChanged = true;
+        }
+    }
+}
+
+void StaticBatch::Draw(GLuint views)
+{
+    if (commandsChanged || poolGeneration != pool->Generation() || views != commandViews)
+    {
+        updateCommands(views);
+    }
+
+    pool->Bind(drawBuffer, views);
+    if (hasMultiDrawIndirect())
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, Size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else if (GLEW_VERSION_4_2 || GLEW_ARB_base_instance)
+    {
+        for (const auto& command : commands)
+        {
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                reinterpret_cast<void*>(command.firstIndex * sizeof(GLuint)), views, command.baseVertex, command.baseInstance);
+        }
+    }
+    else
+    {
+        // No base instance, so feed the per-draw data as constant attributes instead
+        for (auto i = 0; i < 6; ++i)
+        {
+            glDisableVertexAttribArray(DRAW_MODEL_ATTRIBUTE + i);
+        }
+        for (const auto& command : commands)
+        {
+            const auto& draw = draws[command.baseInstance];
+            for (auto column = 0; column < 4; ++column)
+            {
+                glVertexAttrib4fv(DRAW_MODEL_ATTRIBUTE + column, glm::value_ptr(draw.model[column]));
+            }
+            glVertexAttribI1i(DRAW_MATERIAL_ATTRIBUTE, draw.material);
+            glVertexAttribI1i(DRAW_BAKE_ATTRIBUTE, draw.bakeBase);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                reinterpret_cast<void*>(command.firstIndex * sizeof(GLuint)), views, command.baseVertex);
+        }
+        for (auto i = 0; i < 6; ++i)
+        {
+            glEnableVertexAttribArray(DRAW_MODEL_ATTRIBUTE + i);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+// Rebuilds the indirect commands from the selected levels and their current place in the pool
+void StaticBatch::updateCommands(GLuint views)
+{
+    commands.clear();
+    for (size_t i = 0; i < objectLods.size(); ++i)
+    {
+        if (!objectVisible[i])
+        {
+            continue;
+        }
+        const auto& range = pool->Range(objectLods[i][objectLevels[i]].mesh);
+        commands.push_back({ range.indexCount, views, range.firstIndex, range.baseVertex, static_cast<GLuint>(i) });
+    }
+    poolGeneration = pool->Generation();
+    commandViews = views;
+    commandsChanged = false;
+
+    if (hasMultiDrawIndirect())
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
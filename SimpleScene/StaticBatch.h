@@ -0,0 +1,119 @@
+/*
+    StaticBatch.h
+
+    Submits a list of static objects with one glMultiDrawElementsIndirect.
+    The meshes come from a GeometryPool, and each indirect command's base
+    instance selects its object's transform and material from a per-draw
+    buffer read through the pool's instanced attributes. Objects with a level
+    of detail chain switch meshes by rewriting their command, and objects
+    culled against the view, or hidden behind occluders, are left out of the commands altogether.
+    Batches for other views can share one batch's per-draw buffer.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_STATIC_BATCH_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_STATIC_BATCH_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "DynamicBvh.h"
+#include "Frustum.h"
+#include "GeometryPool.h"
+#include "Lod.h"
+#include "OcclusionCuller.h"
+#include "Scene.h"
+
+// Layout defined by GL_ARB_draw_indirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+class StaticBatch
+{
+public:
+    StaticBatch() = default;
+    ~StaticBatch();
+
+    // objects refer to the scene's meshes, meshHandles maps those to meshes registered in pool
+    void Build(const std::vector<SceneObject>& objects, const Scene& scene, const std::vector<MeshHandle>& meshHandles, const GeometryPool& pool);
+
+    // The objects of a built batch, drawn from its per-draw buffer, with culling & levels of detail of its own.
+    // For another view of the same objects, source must outlive it
+    void Share(const StaticBatch& source);
+
+    // Keeps only the objects the tree finds in the frustum and, given a culler, that aren't occluded
+    // The tree's items, and the culler's objects, must be indices into the objects Build was given
+    void Cull(const DynamicBvh& tree, const Frustum& frustum, const OcclusionCuller* occlusion = nullptr);
+
+    // Keeps the objects the tree finds in any of the frustums, for drawing several views at once
+    void Cull(const DynamicBvh& tree, const std::vector<Frustum>& frustums);
+
+    // Gives an object a new transform and world space bounding sphere. A batch sharing another's
+    // per-draw buffer only takes the bounds, the batch it shares from must be moved as well
+    void Move(GLuint object, const glm::mat4& model, const glm::vec4& bounds);
+
+    // Where each object's baked lighting starts, indexed like the objects Build was given.
+    // Like Move, a batch sharing another's per-draw buffer needs the one it shares from set as well
+    void SetBakeBases(const std::vector<GLint>& bases);
+
+    // Keeps only the objects set in visible, indexed like the objects Build was given
+    void SetVisible(const std::vector<char>& visible);
+
+    // Picks every visible object's level of detail for this view from its projected size
+    void SelectLods(const glm::mat4& view, const glm::mat4& projection, GLfloat viewportHeight);
+
+    // Picks levels for the largest an object appears in any of the views
+    void SelectLods(const std::vector<glm::mat4>& views, const std::vector<glm::mat4>& projections, GLfloat viewportHeight);
+
+    // Same over viewCount views and projections, so a single view needs no vectors
+    void SelectLods(const glm::mat4* views, const glm::mat4* projections, size_t viewCount, GLfloat viewportHeight);
+
+    // Draws every object once per view, instance i going to view i
+    void Draw(GLuint views = 1);
+
+    // Draws left after culling
+    GLsizei Size() const
+    {
+        return static_cast<GLsizei>(commands.size());
+    }
+
+    GLsizei ObjectCount() const
+    {
+        return static_cast<GLsizei>(objectLods.size());
+    }
+
+    // Objects in the frustum the last Cull rejected as occluded
+    GLsizei OccludedCount() const
+    {
+        return occludedCount;
+    }
+
+private:
+    void updateCommands(GLuint views);
+
+    const GeometryPool* pool = nullptr;
+    GLuint poolGeneration = 0;
+    bool commandsChanged = false;
+    std::vector<std::vector<LodLevel>> objectLods; // Levels refer to pool handles
+    std::vector<GLuint> objectLevels;
+    std::vector<glm::vec4> objectBounds; // World space sphere, radius in w
+    std::vector<char> objectVisible;
+    std::vector<char> visibleScratch; // Kept to avoid reallocating every frame
+    GLsizei occludedCount = 0;
+    GLuint commandViews = 1; // Instances per command
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawData> draws;
+    GLuint drawBuffer = 0;
+    GLuint commandBuffer = 0;
+    bool ownsDrawBuffer = true;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "StreamBuffer.h"
+
+#include <iostream>
+
+StreamBuffer::~StreamBuffer()
+{
+    for (auto fence : fences)
+    {
+        glDeleteSync(fence);
+    }
+    if (mapped != nullptr)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void StreamBuffer::Setup(GLsizeiptr regionSize, GLuint regionCount)
+{
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    this->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+    this->regionCount = regionCount;
+    region = regionCount - 1;
+    fences.assign(regionCount, nullptr);
+
+    auto size = this->regionSize * regionCount;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (persistent)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+        mapped = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+        if (mapped == nullptr)
+        {
+            std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << std::endl;
+            persistent = false;
+        }
+    }
+    if (!persistent)
+    {
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        staging.resize(size);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void StreamBuffer::Begin()
+{
+    region = (region + 1) % regionCount;
+    used = 0;
+
+    auto& fence = fences[region];
+    if (fence != nullptr)
+    {
+        // Normally signalled long ago, the regions keep the CPU a few frames ahead
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+StreamAllocation StreamBuffer::Allocate(GLsizeiptr size)
+{
+    auto aligned = (size + alignment - 1) / alignment * alignment;
+    if (used + aligned > regionSize)
+    {
+        std::cout << "ERROR::STREAM_BUFFER::REGION_FULL" << std::endl;
+        return { nullptr, 0, 0 };
+    }
+
+    auto offset = region * regionSize + used;
+    used += aligned;
+    auto base = persistent ? mapped : staging.data();
+    return { base + offset, offset, size };
+}
+
+void StreamBuffer::BindRange(GLuint binding, const StreamAllocation& allocation) const
+{
+    if (allocation.data == nullptr)
+    {
+        return;
+    }
+
+    if (!persistent)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, allocation.offset, allocation.size, allocation.data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, allocation.offset, allocation.size);
+}
+
+void StreamBuffer::End()
+{
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
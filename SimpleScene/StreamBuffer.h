@@ -0,0 +1,71 @@
+/*
+    StreamBuffer.h
+
+    Ring buffer for data written by the CPU every frame. The buffer is split
+    into regions, one per frame in flight, each protected by a fence. With
+    GL_ARB_buffer_storage it stays persistently mapped and the CPU writes
+    straight into it, otherwise writes go through a staging copy.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_STREAM_BUFFER_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_STREAM_BUFFER_H_INCLUDED
+
+#include <vector>
+
+#include <GL/glew.h>
+
+struct StreamAllocation
+{
+    void* data;
+    GLintptr offset;
+    GLsizeiptr size;
+};
+
+class StreamBuffer
+{
+public:
+    StreamBuffer() = default;
+    ~StreamBuffer();
+
+    // Uniform buffer with regionCount regions of at least regionSize bytes each
+    void Setup(GLsizeiptr regionSize, GLuint regionCount = 3);
+
+    // Moves to the next region, waiting for the GPU if it still reads from it
+    void Begin();
+
+    // Space in the current region, aligned for glBindBufferRange
+    StreamAllocation Allocate(GLsizeiptr size);
+
+    template <typename T>
+    T* Allocate(StreamAllocation& allocation)
+    {
+        allocation = Allocate(sizeof(T));
+        return static_cast<T*>(allocation.data);
+    }
+
+    // Binds an allocation to a uniform block binding, write its data first
+    void BindRange(GLuint binding, const StreamAllocation& allocation) const;
+
+    // Fences the current region, call after the last draw reading from it
+    void End();
+
+    bool IsPersistent() const
+    {
+        return persistent;
+    }
+
+private:
+    GLuint buffer = 0;
+    GLsizeiptr regionSize = 0;
+    GLuint regionCount = 0;
+    GLuint region = 0;
+    GLsizeiptr used = 0;
+    GLint alignment = 256;
+    bool persistent = false;
+    char* mapped = nullptr;
+    std::vector<char> staging;
+    std::vector<GLsync> fences;
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "StressScene.h"
+
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    const GLuint MATERIAL_VARIANTS = 32;
+
+    // Chairs stay clear of the table, ornaments stay on it
+    const GLfloat CHAIR_JITTER = 0.15f;
+    const GLfloat ORNAMENT_MIN_SCALE = 0.8f;
+    const GLfloat ORNAMENT_MAX_SCALE = 1.2f;
+
+    // Scattered lights hang between the table and the ceiling and fall off within a room or two
+    const GLfloat LIGHT_MIN_HEIGHT = 1.0f;
+    const GLfloat LIGHT_MAX_HEIGHT = 4.0f;
+    const GLfloat LIGHT_CONSTANT = 1.0f;
+    const GLfloat LIGHT_LINEAR = 0.22f;
+    const GLfloat LIGHT_QUADRATIC = 0.20f;
+
+    // The distributions in <random> differ between standard libraries, these don't
+    class StressRandom
+    {
+    public:
+        explicit StressRandom(GLuint seed)
+            : engine(seed)
+        {
+        }
+
+        GLfloat Uniform(GLfloat low, GLfloat high)
+        {
+            return low + (high - low) * static_cast<GLfloat>(engine() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        GLuint Below(GLuint count)
+        {
+            return static_cast<GLuint>(engine() % count);
+        }
+
+        glm::vec3 Color()
+        {
+            return glm::vec3(Uniform(0.1f, 1.0f), Uniform(0.1f, 1.0f), Uniform(0.1f, 1.0f));
+        }
+
+    private:
+        std::mt19937 engine;
+    };
+
+    enum class Variation
+    {
+        None,
+        Chair,
+        Ornament
+    };
+}
+
+void BuildStressScene(Scene& scene, const StressSettings& settings)
+{
+    RoomLayout layout;
+    BuildRoomScene(scene, &layout);
+    StressRandom random(settings.seed);
+
+    // Recoloured materials shared by every copy
+    std::vector<GLuint> variants;
+    for (GLuint i = 0; i < MATERIAL_VARIANTS; ++i)
+    {
+        auto color = random.Color();
+        variants.push_back(scene.AddMaterial(Material(color * 0.2f, color * 0.8f, glm::vec3(0.5f), random.Uniform(8.0f, 128.0f)), color));
+    }
+
+    const auto room = scene.objects;
+    std::vector<Variation> variations(room.size(), Variation::None);
+    for (auto i : layout.chairs)
+    {
+        variations[i] = Variation::Chair;
+    }
+    for (auto i : layout.ornaments)
+    {
+        variations[i] = Variation::Ornament;
+    }
+
+    scene.objects.reserve(room.size() * settings.roomsX * settings.roomsZ);
+    for (GLuint z = 0; z < settings.roomsZ; ++z)
+    {
+        for (GLuint x = 0; x < settings.roomsX; ++x)
+        {
+            if (x == 0 && z == 0)
+            {
+                continue; // The original room
+            }
+
+            auto offset = glm::translate(glm::mat4(), glm::vec3(x * STRESS_ROOM_SPACING, 0.0f, z * STRESS_ROOM_SPACING));
+            for (size_t i = 0; i < room.size(); ++i)
+            {
+                auto object = room[i];
+                switch (variations[i])
+                {
+                case Variation::Chair:
+                {
+                    glm::vec3 jitter(random.Uniform(-CHAIR_JITTER, CHAIR_JITTER), 0.0f, random.Uniform(-CHAIR_JITTER, CHAIR_JITTER));
+                    object.model = glm::translate(glm::mat4(), jitter) * object.model;
+                    object.model = glm::rotate(object.model, random.Uniform(-0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+                    object.material = variants[random.Below(MATERIAL_VARIANTS)];
+                    break;
+                }
+                case Variation::Ornament:
+                {
+                    object.model = glm::rotate(object.model, random.Uniform(0.0f, glm::radians(360.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
+                    object.model = glm::scale(object.model, glm::vec3(random.Uniform(ORNAMENT_MIN_SCALE, ORNAMENT_MAX_SCALE)));
+                    object.material = variants[random.Below(MATERIAL_VARIANTS)];
+                    break;
+                }
+                case Variation::None:
+                    break;
+                }
+                scene.AddObject(object.mesh, object.material, offset * object.model);
+            }
+        }
+    }
+
+    // Half point lights with a lamp each, a quarter plain spots pointing down and a quarter coloured disco spots
+    auto lamp = scene.lamps.empty() ? 0 : scene.lamps[0].mesh;
+    auto halfRoom = STRESS_ROOM_SPACING * 0.5f;
+    for (GLuint i = 0; i < settings.lights; ++i)
+    {
+        glm::vec3 position(random.Uniform(-halfRoom, (settings.roomsX - 0.5f) * STRESS_ROOM_SPACING),
+                           random.Uniform(LIGHT_MIN_HEIGHT, LIGHT_MAX_HEIGHT),
+                           random.Uniform(-halfRoom, (settings.roomsZ - 0.5f) * STRESS_ROOM_SPACING));
+        auto kind = random.Below(4);
+        if (kind < 2)
+        {
+            auto color = random.Color();
+            scene.pointLights.push_back({ position, glm::vec3(0.0f), Material(glm::vec3(0.0f), color * 0.8f, color),
+                                          LIGHT_CONSTANT, LIGHT_LINEAR, LIGHT_QUADRATIC, 0.0f, 0.0f });
+            auto model = glm::translate(glm::mat4(), position);
+            scene.lamps.push_back({ lamp, 0, glm::scale(model, glm::vec3(0.05f)) });
+        }
+        else if (kind == 2)
+        {
+            glm::vec3 direction(random.Uniform(-0.2f, 0.2f), -1.0f, random.Uniform(-0.2f, 0.2f));
+            scene.spotLights.push_back({ position, glm::normalize(direction), Material(glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(1.0f)),
+                                         LIGHT_CONSTANT, LIGHT_LINEAR, LIGHT_QUADRATIC, 22.5f, 25.0f });
+        }
+        else
+        {
+            // Saturated: one channel full, one off
+            glm::vec3 color(0.0f);
+            auto full = random.Below(3);
+            color[full] = 1.0f;
+            color[(full + 1 + random.Below(2)) % 3] = random.Uniform(0.0f, 1.0f);
+            glm::vec3 direction(random.Uniform(-1.0f, 1.0f), -1.0f, random.Uniform(-1.0f, 1.0f));
+            scene.spotLights.push_back({ position, glm::normalize(direction), Material(color * 0.05f, color, glm::vec3(1.0f)),
+                                         LIGHT_CONSTANT, LIGHT_LINEAR, LIGHT_QUADRATIC, 20.5f, 23.0f });
+        }
+    }
+}
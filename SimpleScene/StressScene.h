@@ -0,0 +1,31 @@
+/*
+    StressScene.h
+
+    Tiles copies of the room into a grid for scaling tests. Chairs and
+    ornaments are moved and recoloured in every copy but the first, and
+    lights are scattered over the whole grid. Everything comes from the seed,
+    so a run can be repeated exactly on any platform.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_STRESS_SCENE_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_STRESS_SCENE_H_INCLUDED
+
+#include "Scene.h"
+
+// Distance between neighbouring rooms, the walls are 4.56 apart
+#define STRESS_ROOM_SPACING 4.6f
+
+struct StressSettings
+{
+    GLuint roomsX = 1;
+    GLuint roomsZ = 1;
+    GLuint lights = 0; // Scattered on top of the first room's own, a mix of point, spot and disco lights
+    GLuint seed = 1;
+};
+
+// The room at the origin, then roomsX by roomsZ copies of it along +x and +z.
+// Needs a current context, like BuildRoomScene.
+void BuildStressScene(Scene& scene, const StressSettings& settings);
+
+#endif
@@ -0,0 +1,103 @@
+#include "TextBlock.h"
+
+#include <cstddef>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FrameStats.h"
+
+TextBlock::~TextBlock()
+{
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void TextBlock::Setup(const GlyphAtlas& atlas)
+{
+    this->atlas = &atlas;
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), reinterpret_cast<GLvoid*>(offsetof(TextVertex, vertex)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), reinterpret_cast<GLvoid*>(offsetof(TextVertex, color)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool TextBlock::Set(const std::vector<TextLabel>& labels)
+{
+    if (labels == this->labels)
+    {
+        return false;
+    }
+    this->labels = labels;
+
+    vertices.clear();
+    for (const auto& label : labels)
+    {
+        auto x = label.position.x;
+        auto bottom = label.position.y - atlas->Descent();
+        auto top = bottom + atlas->Height();
+        for (auto c : label.text)
+        {
+            const auto& glyph = (*atlas)[c];
+            if (c != ' ')
+            {
+                TextVertex quad[4] = {
+                    { glm::vec4(x, bottom, glyph.uvMin.x, glyph.uvMin.y), label.color },
+                    { glm::vec4(x + glyph.width, bottom, glyph.uvMax.x, glyph.uvMin.y), label.color },
+                    { glm::vec4(x + glyph.width, top, glyph.uvMax.x, glyph.uvMax.y), label.color },
+                    { glm::vec4(x, top, glyph.uvMin.x, glyph.uvMax.y), label.color }
+                };
+                vertices.insert(vertices.end(), { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] });
+            }
+            x += glyph.width;
+        }
+    }
+    dirty = true;
+    return true;
+}
+
+void TextBlock::Draw(const Shader& shader, const glm::mat4& projection)
+{
+    if (dirty)
+    {
+        auto size = static_cast<GLsizeiptr>(vertices.size() * sizeof(TextVertex));
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (size > capacity)
+        {
+            glBufferData(GL_ARRAY_BUFFER, size, vertices.data(), GL_DYNAMIC_DRAW);
+            capacity = size;
+        }
+        else
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        dirty = false;
+    }
+
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    shader.Use();
+    glUniformMatrix4fv(glGetUniformLocation(shader(), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(shader(), "text"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas->Texture());
+
+    glEnable(GL_BLEND);
+    // Keeps alpha premultiplied when drawing into a Panel
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+    CountGlCall(GlCall::Draw);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+}
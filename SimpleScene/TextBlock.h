@@ -0,0 +1,66 @@
+/*
+    TextBlock.h
+
+    A set of labels built into one vertex buffer of glyph quads and drawn
+    with a single call through text.vert/text.frag. The buffer is only
+    rebuilt when the labels change.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_TEXT_BLOCK_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_TEXT_BLOCK_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GlyphAtlas.h"
+#include "Shader.h"
+
+// position is the start of the baseline in pixels
+struct TextLabel
+{
+    glm::vec2 position;
+    glm::vec3 color;
+    std::string text;
+
+    bool operator==(const TextLabel& other) const
+    {
+        return position == other.position && color == other.color && text == other.text;
+    }
+};
+
+class TextBlock
+{
+public:
+    TextBlock() = default;
+    ~TextBlock();
+
+    void Setup(const GlyphAtlas& atlas);
+
+    // Does nothing and returns false if labels are the ones already in the buffer
+    bool Set(const std::vector<TextLabel>& labels);
+
+    // shader is the text shader, projection maps pixels to clip space
+    void Draw(const Shader& shader, const glm::mat4& projection);
+
+private:
+    // Matches text.vert, vertex packs <vec2 pos, vec2 tex>
+    struct TextVertex
+    {
+        glm::vec4 vertex;
+        glm::vec3 color;
+    };
+
+    const GlyphAtlas* atlas = nullptr;
+    std::vector<TextLabel> labels;
+    std::vector<TextVertex> vertices;
+    bool dirty = false;
+    GLsizeiptr capacity = 0;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+};
+
+#endif
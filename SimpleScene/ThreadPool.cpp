@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : task(nullptr), remaining(0)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (unsigned i = 0; i + 1 < threadCount; ++i)
+    {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, unsigned)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> job(jobMutex);
+    this->task = &task;
+    remaining = count;
+
+    // Deal the items out in contiguous runs so neighbours stay on one thread until stolen
+    auto queueCount = queues.size();
+    for (size_t q = 0; q < queueCount; ++q)
+    {
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        for (auto i = count * q / queueCount; i < count * (q + 1) / queueCount; ++i)
+        {
+            queues[q]->items.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wake.notify_all();
+
+    run(static_cast<unsigned>(queueCount - 1));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining == 0; });
+}
+
+bool ThreadPool::next(unsigned thread, size_t& item)
+{
+    {
+        auto& own = *queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty())
+        {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the others, furthest from where their owners are working
+    auto queueCount = static_cast<unsigned>(queues.size());
+    for (unsigned offset = 1; offset < queueCount; ++offset)
+    {
+        auto& victim = *queues[(thread + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty())
+        {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned thread)
+{
+    size_t item;
+    while (next(thread, item))
+    {
+        (*task.load())(item, thread);
+        if (--remaining == 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work(unsigned thread)
+{
+    unsigned long long seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+        run(thread);
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    ThreadPool.h
+
+    Fixed set of worker threads for the CPU renderers. Work is handed out as
+    indices: each thread starts on its own queue and steals from the others
+    once it runs dry, so uneven items (a dense ornament next to a wall) still
+    keep every core busy.
+*/
+
+#pragma once
+#ifndef SIMPLE_SCENE_INCLUDE_THREAD_POOL_H_INCLUDED
+#define SIMPLE_SCENE_INCLUDE_THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread, the caller of ParallelFor counts as one
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs task(i) for every i in [0, count) and returns when all have finished.
+    // task gets the index of the thread running it, below Size(), as its second argument
+    void ParallelFor(size_t count, const std::function<void(size_t, unsigned)>& task);
+
+    unsigned Size() const
+    {
+        return static_cast<unsigned>(queues.size());
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    bool next(unsigned thread, size_t& item);
+    void run(unsigned thread);
+    void work(unsigned thread);
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<Queue>> queues; // Last one belongs to the caller
+    std::mutex jobMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::atomic<const std::function<void(size_t, unsigned)>*> task;
+    std::atomic<size_t> remaining;
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
+
+#endif
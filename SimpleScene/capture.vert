@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+
+out vec3 capturedPosition;
+out vec3 capturedNormal;
+
+void main()
+{
+    capturedPosition = position;
+    capturedNormal = normal;
+    gl_Position = vec4(position, 1.0f);
+}
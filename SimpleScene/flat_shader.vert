@@ -1,4 +1,8 @@
 #version 330 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_viewport_index : enable
+#endif
 struct Material {
     vec3 ambient;
     vec3 diffuse;
@@ -14,60 +18,129 @@ struct DirLight {
     vec3 specular;
 };
 
+// Members are ordered so each vec3 shares a std140 slot with a float
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-    
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
-  
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
-    vec3 specular;       
+    float cutOff;
+    vec3 specular;
+    float outerCutOff;
+};
+
+struct MaterialData {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular; // w holds the shininess
 };
 
 #define NR_POINT_LIGHTS 2
 #define NR_DISCO_LIGHTS 4
+#define NR_MATERIALS 256
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
+layout (location = 2) in mat4 model; // Per draw
+layout (location = 6) in int materialIndex; // Per draw
+#ifndef MULTI_VIEW
+layout (location = 7) in int bakeBase; // Per draw
+#endif
 
 flat out vec3 ourColor;
 
-uniform vec3 viewPos;
+// Same depth as the occluder prepass
+invariant gl_Position;
+
+#ifdef MULTI_VIEW
+// One entry per view, main copies its view's into globals named like the single view blocks' members
+struct CameraData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+struct LightData {
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+    SpotLight discoLights[NR_DISCO_LIGHTS];
+};
+layout (std140) uniform Camera {
+    CameraData cameras[MAX_VIEWS];
+};
+layout (std140) uniform Lights {
+    LightData lights[MAX_VIEWS];
+};
+mat4 view;
+mat4 projection;
+vec3 viewPos;
+PointLight pointLights[NR_POINT_LIGHTS];
+SpotLight spotLight;
+SpotLight discoLights[NR_DISCO_LIGHTS];
+#else
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+layout (std140) uniform Lights {
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+    SpotLight discoLights[NR_DISCO_LIGHTS];
+};
+#endif
+#ifndef MULTI_VIEW
+// Lights past the Lights block's, read from LightPool's planes of lightStride texels each
+uniform samplerBuffer lightPlanes;
+uniform isamplerBuffer visibleLights;
+uniform int lightStride;
+uniform int visibleLightCount;
+// The static point lights' ambient & diffuse, one texel per vertex from bakeBase on
+uniform samplerBuffer bakedLighting;
+uniform bool useBakedLighting;
+#endif
 uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform SpotLight discoLights[NR_DISCO_LIGHTS];
-uniform Material material;
+layout (std140) uniform Materials {
+    MaterialData materials[NR_MATERIALS];
+};
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+Material material;
 
 // Function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+#ifndef MULTI_VIEW
+SpotLight PoolLight(int index);
+#endif
 
 void main()
 {
+#ifdef MULTI_VIEW
+    // One instance per view, the per-draw attributes only step once per draw
+    view = cameras[gl_InstanceID].view;
+    projection = cameras[gl_InstanceID].projection;
+    viewPos = cameras[gl_InstanceID].viewPos;
+    pointLights = lights[gl_InstanceID].pointLights;
+    spotLight = lights[gl_InstanceID].spotLight;
+    discoLights = lights[gl_InstanceID].discoLights;
+    gl_ViewportIndex = gl_InstanceID;
+#endif
     // Properties
+    MaterialData data = materials[materialIndex];
+    material = Material(data.ambient.xyz, data.diffuse.xyz, data.specular.xyz, data.specular.w);
     vec3 FragPos = vec3(model * vec4(position, 1.0f));
     vec3 Normal = mat3(transpose(inverse(model))) * normal;
     vec3 norm = normalize(Normal);
@@ -91,6 +164,15 @@ void main()
     for (int i = 0; i < NR_DISCO_LIGHTS; ++i) {
         result += CalcSpotLight(discoLights[i], norm, FragPos, viewDir);
     }
+#ifndef MULTI_VIEW
+    for (int i = 0; i < visibleLightCount; ++i) {
+        result += CalcSpotLight(PoolLight(texelFetch(visibleLights, i).r), norm, FragPos, viewDir);
+    }
+    // Baked point lights are written black into the Lights block and left out of the visible ones
+    if (useBakedLighting && bakeBase >= 0) {
+        result += texelFetch(bakedLighting, bakeBase + gl_VertexID).rgb;
+    }
+#endif
 
     ourColor = result;
 
@@ -160,3 +242,17 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
 }
+
+#ifndef MULTI_VIEW
+// A pool light, point lights have a cone wide enough to let everything through
+SpotLight PoolLight(int index)
+{
+    vec4 position = texelFetch(lightPlanes, index);
+    vec4 direction = texelFetch(lightPlanes, lightStride + index);
+    vec4 ambient = texelFetch(lightPlanes, 2 * lightStride + index);
+    vec4 diffuse = texelFetch(lightPlanes, 3 * lightStride + index);
+    vec4 specular = texelFetch(lightPlanes, 4 * lightStride + index);
+    return SpotLight(position.xyz, position.w, direction.xyz, direction.w, ambient.xyz, ambient.w,
+                     diffuse.xyz, diffuse.w, specular.xyz, specular.w);
+}
+#endif
@@ -0,0 +1,41 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D colorTexture; // Linearly filtered
+
+// FXAA as in Lottes' console version: blur along the local edge direction,
+// falling back to a narrower blur when the wide one overshoots the neighbourhood
+#define FXAA_REDUCE_MIN (1.0f / 128.0f)
+#define FXAA_REDUCE_MUL (1.0f / 8.0f)
+#define FXAA_SPAN_MAX 8.0f
+
+float luma(vec3 rgb)
+{
+    return dot(rgb, vec3(0.299f, 0.587f, 0.114f));
+}
+
+void main()
+{
+    vec2 texel = 1.0f / vec2(textureSize(colorTexture, 0));
+    float lumaNW = luma(textureOffset(colorTexture, TexCoords, ivec2(-1, -1)).rgb);
+    float lumaNE = luma(textureOffset(colorTexture, TexCoords, ivec2(1, -1)).rgb);
+    float lumaSW = luma(textureOffset(colorTexture, TexCoords, ivec2(-1, 1)).rgb);
+    float lumaSE = luma(textureOffset(colorTexture, TexCoords, ivec2(1, 1)).rgb);
+    vec3 rgbM = texture(colorTexture, TexCoords).rgb;
+    float lumaM = luma(rgbM);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25f * FXAA_REDUCE_MUL, FXAA_REDUCE_MIN);
+    float scale = 1.0f / (min(abs(direction.x), abs(direction.y)) + reduce);
+    direction = clamp(direction * scale, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel;
+
+    vec3 rgbA = 0.5f * (texture(colorTexture, TexCoords + direction * (1.0f / 3.0f - 0.5f)).rgb +
+                        texture(colorTexture, TexCoords + direction * (2.0f / 3.0f - 0.5f)).rgb);
+    vec3 rgbB = rgbA * 0.5f + 0.25f * (texture(colorTexture, TexCoords - direction * 0.5f).rgb +
+                                       texture(colorTexture, TexCoords + direction * 0.5f).rgb);
+    float lumaB = luma(rgbB);
+    color = vec4(lumaB < lumaMin || lumaB > lumaMax ? rgbA : rgbB, 1.0f);
+}
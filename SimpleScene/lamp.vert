@@ -1,11 +1,42 @@
 #version 330 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_viewport_index : enable
+#endif
 layout (location = 0) in vec3 position;
+layout (location = 2) in mat4 model; // Per draw
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Same depth as the occluder prepass
+invariant gl_Position;
+
+#ifdef MULTI_VIEW
+// One entry per view, main copies its view's into globals named like the single view block's members
+struct CameraData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+layout (std140) uniform Camera {
+    CameraData cameras[MAX_VIEWS];
+};
+mat4 view;
+mat4 projection;
+vec3 viewPos;
+#else
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+#endif
 
 void main()
 {
+#ifdef MULTI_VIEW
+    // One instance per view, the per-draw attributes only step once per draw
+    view = cameras[gl_InstanceID].view;
+    projection = cameras[gl_InstanceID].projection;
+    gl_ViewportIndex = gl_InstanceID;
+#endif
     gl_Position = projection * view * model * vec4(position, 1.0f);
 }
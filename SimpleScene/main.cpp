@@ -1,7 +1,14 @@
 // Standard headers
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
 
 // Third party headers
 #include <GL/glew.h>
@@ -12,14 +19,39 @@
 // Self defined headers
 #include "Shader.h"
 #include "Camera.h"
-#include "PointLight.h"
-#include "LightProperties.h"
-#include "OrnamentProperties.h"
-#include "SpotLight.h"
-#include "Table.h"
-#include "Chair.h"
-#include "Plane.h"
-#include "ObjectProperties.h"
+#include "LightPool.h"
+#include "Animation.h"
+#include "LightBaker.h"
+#include "MaterialTable.h"
+#include "GeometryPool.h"
+#include "Scene.h"
+#include "StaticBatch.h"
+#include "StreamBuffer.h"
+#include "FrameData.h"
+#include "GlyphAtlas.h"
+#include "Panel.h"
+#include "ThreadPool.h"
+#include "SoftwareRasterizer.h"
+#include "RayTracer.h"
+#include "ImagePresenter.h"
+#include "FrameTimer.h"
+#include "LightingBenchmark.h"
+#include "BvhBenchmark.h"
+#include "PickingBenchmark.h"
+#include "ImageFile.h"
+#include "FrameStats.h"
+#include "RegressionGate.h"
+#include "AssetPack.h"
+#include "ModelImporter.h"
+#include "StressScene.h"
+#include "DynamicBvh.h"
+#include "OcclusionCuller.h"
+#include "Picker.h"
+#include "InputLog.h"
+#include "MultiView.h"
+#include "AntiAliasing.h"
+#include "GpuTimer.h"
+#include "DynamicResolution.h"
 
 // Constants
 #define GLUT_KEY_ESCAPE 27
@@ -34,35 +66,79 @@
 
 //const GLuint WIDTH = 800, HEIGHT = 600;
 const GLchar* TITLE = "SimpleScene";
-const int NUM_OF_POINT_LIGHTS = 2;
-const int NUM_OF_DISCO_LIGHTS = 4;
-const int NUM_OF_ORNAMENTS = 8;
+const int NUM_OF_POINT_LIGHTS = MAX_POINT_LIGHTS;
+const int NUM_OF_DISCO_LIGHTS = MAX_DISCO_LIGHTS;
+const GLsizei STATUS_PANEL_WIDTH = 240;
+const GLsizei STATUS_PANEL_HEIGHT = 150;
+const GLsizei READOUT_PANEL_HEIGHT = 90;
+const double READOUT_INTERVAL = 0.25; // Seconds between re-renders of the live readout
+const GLchar* DEFAULT_ASSET_PACK = "scene.pack";
+const GLchar* DEFAULT_BAKE_CACHE = "scene.bake";
+
+// Picked on the command line with --renderer=gl|software|raytrace
+enum class RendererBackend
+{
+    OpenGL,
+    Software,
+    RayTrace
+};
+
+// Toggled per view with p
+enum class ProjectionMode
+{
+    Orthographic,
+    Perspective
+};
 
 // Stores the state of a window
 struct WindowInfo
 {
-    // Shaders
-    Shader smoothShader;
-    Shader flatShader;
-    Shader lampShader;
     //std::function<void()> useCurrentShader;
 
     // Camera
     glm::vec3 cameraStartPosition;
     Camera camera;
 
-    // Lights
-    PointLight pointLights[NUM_OF_POINT_LIGHTS];
-    SpotLight spotLight;
-    SpotLight discoLights[NUM_OF_DISCO_LIGHTS];
-    GLfloat spotLightSwingSpeed = 1.0f;
-    GLfloat discoLightSwingSpeed = 2.0f;
-
-    // Objects, VBOs & VAOs
-    std::vector<std::function<void()>> ornaments;
-    GLuint chairVBOPos, chairVBONormals, chairVAO;
-    GLuint tableVBOPos, tableVBONormals, tableVAO;
-    GLuint planeVBOPos, planeVBONormals, planeVAO;
+    // Which of SharedResources' lights this view has on, and those past the Lights block's it can see
+    LightSwitches lightSwitches;
+    std::vector<GLint> visibleLights;
+    VisibleLightBuffer visibleLightBuffer;
+    BakedLightBuffer bakedLights; // Sum of the baked lights this view has on
+    std::vector<char> bakedOn; // Per layer of lightBaker
+
+    // Objects, shared with SharedResources' batches but culled for this view
+    StaticBatch staticBatch;
+    StaticBatch lampBatch;
+    StaticBatch occluderBatch; // Depth prepass
+    OcclusionCuller occlusionCuller;
+
+    // Camera & lights, rewritten every frame
+    StreamBuffer frameStream;
+
+    // Overlays, the status only changes with a toggle, the readout's timings are sampled every READOUT_INTERVAL
+    Panel statusPanel;
+    Panel readoutPanel;
+    std::chrono::steady_clock::time_point readoutTime;
+
+    // CPU rendering & benchmarking
+    SoftwareRasterizer rasterizer;
+    RayTracer rayTracer;
+    ImagePresenter presenter;
+    FrameTimer frameTimer;
+    bool stillSaved = false;
+
+    // Anti-aliasing, cycled with g, and its cost on the GPU
+    AntiAliasingMode antiAliasingMode = AntiAliasingMode::Msaa4;
+    AntiAliasTarget antiAliasTarget;
+    GpuTimer frameGpuTimer; // Scene & anti-aliasing
+    GpuTimer antiAliasingGpuTimer; // Resolve or post passes only
+    double frameGpuMilliseconds = 0.0;
+    double antiAliasingGpuMilliseconds = 0.0;
+
+    // Dynamic resolution, the scale comes from every frame's GPU time
+    ResolutionController resolution;
+    UpscaleTarget upscaleTarget;
+    GpuTimer resolutionGpuTimer{ 1 };
 
     // OpenGL variables
     bool useSmoothShading = true;
@@ -71,79 +147,308 @@ struct WindowInfo
     bool useBackfaceCulling = true;
     bool cullFrontFace = false;
     bool useDepthTesting = true;
+    bool useOcclusionCulling = true;
+    GLenum polygonMode = GL_FILL;
+    ProjectionMode projectionMode = ProjectionMode::Perspective;
 
     // User input
     bool keys[1024];
+    PickHit picked; // Under the cursor
+    double pickMicroseconds = 0.0;
 
-    // MVP matrices
-    glm::mat4 model;
+    // View & projection matrices
     glm::mat4 view;
     glm::mat4 projection;
+};
 
-    ~WindowInfo()
-    {
-        glDeleteBuffers(1, &chairVBOPos);
-        glDeleteBuffers(1, &chairVBONormals);
-        glDeleteBuffers(1, &tableVBOPos);
-        glDeleteBuffers(1, &tableVBONormals);
-        glDeleteBuffers(1, &planeVBOPos);
-        glDeleteBuffers(1, &planeVBONormals);
-
-        glDeleteVertexArrays(1, &chairVAO);
-        glDeleteVertexArrays(1, &tableVAO);
-        glDeleteVertexArrays(1, &planeVAO);
-    }
+// What every view draws with, the views share one context
+struct SharedResources
+{
+    // Shaders
+    Shader smoothShader;
+    Shader flatShader;
+    Shader lampShader;
+    Shader textShader;
+    Shader panelShader;
+    GlyphAtlas font;
+    AntiAliasingShaders antiAliasingShaders;
+    Shader upscaleShader;
+
+    // Materials, meshes & the per-draw data of the objects
+    MaterialTable materialTable;
+    GeometryPool geometryPool;
+    std::vector<MeshHandle> meshHandles; // Indexed like Scene::meshes
+    StaticBatch staticBatch;
+    StaticBatch lampBatch;
+    StaticBatch occluderBatch;
+
+    // Lights, the Lights block's first and then the rest of the scene's
+    LightPool lights;
+    std::vector<LightHandle> pointLights; // Indexed like the scene's, at least NUM_OF_POINT_LIGHTS
+    std::vector<LightHandle> spotLights; // The spot light, the disco lights, then the scene's others
+    LightBuffer lightBuffer;
 };
 
+void initializeShared();
 void initialize(int windowId);
+void initializeInstructions();
+void loadScene();
+void bakeStaticLights();
+std::vector<TextLabel> statusLabels(int windowId);
+std::vector<TextLabel> readoutLabels(int windowId);
 void display(int windowId);
+const std::vector<GLuint>* renderView(int windowId, int width, int height, GLfloat time);
+void applyRenderState(int windowId);
+void animate(GLfloat time);
+void updateView(int windowId, int width, int height, GLfloat time);
+void writeFrameData(int windowId, CameraBlock& camera, LightBlock& lights);
+void saveStill(int windowId, const std::vector<GLuint>* pixels, int width, int height);
+const char* rendererName();
+std::string viewName(int windowId);
+int currentView();
 void handleKeyPress(int windowId, unsigned char key, int x, int y);
 void handleKeyUp(int windowId, unsigned char key, int x, int y);
 void handleSpecialPress(int windowId, int key, int x, int y);
 void handleSpecialUp(int windowid, int key, int x, int y);
 void handleSmoothInput(int windowId);
+void handleMouseMove(int windowId, int x, int y);
+bool acceptInput(int windowId, InputEventType type, int key, int x, int y);
+void dispatchInput(const InputEvent& event);
+void renderMultiView();
 
 void mainWindowDisplayCallback();
-void leftWindowDisplayCallback();
-void rightWindowDisplayCallback();
+void viewDisplayCallback();
 void instructionDisplayCallback();
 void idleCallback();
-void leftWindowKeyPressCallback(unsigned char key, int x, int y);
-void leftWindowKeyUpCallback(unsigned char key, int x, int y);
-void leftWindowSpecialPressCallback(int key, int x, int y);
-void leftWindowSpecialUpCallback(int key, int x, int y);
-void rightWindowKeyPressCallback(unsigned char key, int x, int y);
-void rightWindowKeyUpCallback(unsigned char key, int x, int y);
-void rightWindowSpecialPressCallback(int key, int x, int y);
-void rightWindowSpecialUpCallback(int key, int x, int y);
-
-void renderText(const float &x, const float &y, void *font, const char *const str);
+void viewKeyPressCallback(unsigned char key, int x, int y);
+void viewKeyUpCallback(unsigned char key, int x, int y);
+void viewSpecialPressCallback(int key, int x, int y);
+void viewSpecialUpCallback(int key, int x, int y);
+void viewMouseMoveCallback(int x, int y);
 
 // Window ids
 int mainWindow;
-int leftWindow;
-int rightWindow;
+std::vector<int> viewWindows; // One per view
 int instructionWindow;
 
-// Two subwindow states
-WindowInfo window[2];
+// Subwindow states, one per view in a grid of --views=<columns>x<rows>
+std::vector<WindowInfo> window;
+int viewColumns = 2;
+int viewRows = 1;
+SharedResources shared;
+
+// Shared by every view
+Scene scene;
+AssetPack assetPack; // Stays mapped, the shared geometry pool uploads its meshes from it
+std::string packPath; // --pack=<file>, DEFAULT_ASSET_PACK is tried without it
+std::string writePackPath; // --write-pack=<file> saves the scene, imports included
+std::vector<std::string> importPaths; // Each --import=<file> adds an OBJ or glTF model to the scene
+StressSettings stress; // --stress=<x>x<z>, --stress-lights=<count> and --seed=<seed>
+bool buildStress = false; // Replaces the pack and the built-in room
+DynamicBvh objectTree; // Over scene.objects, items are object indices. They don't move, so the leaves are never updated
+Picker picker; // Finds the object under the cursor in any view
+RendererBackend renderer = RendererBackend::OpenGL;
+std::unique_ptr<ThreadPool> threadPool; // Only with the CPU renderers
+bool benchmark = false;
+bool benchmarkPicking = false; // Times picks against testing every triangle, then quits
+std::string stillPrefix; // With --still=<prefix>, each view is saved once and the program quits
+RegressionGate gate; // With --gate=<directory>, the program quits with the gate's exit code
+int exitCode = 0;
+InputLog inputLog; // --record=<file> or --replay=<file>
+GLfloat inputLag = 0.0f; // Wall clock time a recording hasn't stepped through yet
+bool multiView = false; // --multiview draws every view in one pass
+AntiAliasingMode antiAliasing = AntiAliasingMode::Msaa4; // --aa=off|msaa2|msaa4|msaa8|fxaa|smaa, every view starts with it
+double targetFrameMilliseconds = 0.0; // --target-frame-ms=<ms> scales the views' resolution to hold it, shared out evenly between them
+UpscaleFilter upscaleFilter = UpscaleFilter::Sharpen; // --upscale=bilinear|sharpen
+std::string animationPath; // --animation=<file> replaces the room's light swings
+Animator animator; // Shared by every view, evaluated once for each frame's time
+GLfloat spotLightSwingSpeed = 1.0f; // [ and ], in every view
+bool bakeLighting = false; // --bake, or --bake=<file> for a cache other than DEFAULT_BAKE_CACHE
+std::string bakeCachePath = DEFAULT_BAKE_CACHE;
+LightBaker lightBaker; // The point lights nothing animates, shared by every view
+MultiViewTarget multiViewTarget;
+Shader multiViewSmoothShader;
+Shader multiViewFlatShader;
+Shader multiViewLampShader;
+StreamBuffer multiViewStream; // Camera & lights of every view
+std::vector<glm::ivec2> multiViewSizes; // Per view, cleared and refilled every frame so they keep their storage
+std::vector<glm::mat4> multiViewViews;
+std::vector<glm::mat4> multiViewProjections;
+std::vector<Frustum> multiViewFrustums;
+
+// Instruction window state, drawn with SharedResources' font & shaders
+Panel instructionPanel;
 
 // Deltatime
 GLfloat deltaTime = 0.00f; // Time between current frame and last frame
 GLfloat lastFrame = 0.00f; // Time of last frame
+GLfloat frameTime = 0.0f; // What every view animates to this frame, the input clock while input is logged
 
 int main(int argc, char* argv[])
 {
+    // Needs no window, so it runs before GLUT is touched
+    for (auto i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--benchmark-lighting")
+        {
+            RunLightingBenchmark(std::cout);
+            return 0;
+        }
+        if (std::string(argv[i]) == "--benchmark-bvh")
+        {
+            return RunBvhBenchmark(std::cout) ? 0 : 1;
+        }
+    }
+
     glutInit(&argc, argv);
     if (glutGet(GLUT_VERSION) == 30000)
     {
         std::cout << "Status: Using FreeGLUT 3.0.0" << std::endl;
     }
 
-    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_ALPHA | GLUT_MULTISAMPLE);
-    glutInitWindowSize(1200, 650);
+    // glutInit has taken its own arguments out already
+    std::string gateDirectory;
+    auto gateUpdate = false;
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto argument = std::string(argv[i]);
+        if (argument == "--renderer=software")
+        {
+            renderer = RendererBackend::Software;
+        }
+        else if (argument == "--renderer=raytrace")
+        {
+            renderer = RendererBackend::RayTrace;
+        }
+        else if (argument == "--renderer=gl")
+        {
+            renderer = RendererBackend::OpenGL;
+        }
+        else if (argument == "--benchmark")
+        {
+            benchmark = true;
+        }
+        else if (argument == "--benchmark-picking")
+        {
+            benchmarkPicking = true;
+        }
+        else if (argument.compare(0, 8, "--still=") == 0)
+        {
+            stillPrefix = argument.substr(8);
+        }
+        else if (argument.compare(0, 7, "--pack=") == 0)
+        {
+            packPath = argument.substr(7);
+        }
+        else if (argument.compare(0, 13, "--write-pack=") == 0)
+        {
+            writePackPath = argument.substr(13);
+        }
+        else if (argument.compare(0, 9, "--stress=") == 0)
+        {
+            buildStress = std::sscanf(argument.c_str() + 9, "%ux%u", &stress.roomsX, &stress.roomsZ) == 2 &&
+                          stress.roomsX > 0 && stress.roomsZ > 0;
+            if (!buildStress)
+            {
+                std::cerr << "Error: --stress takes rooms as <x>x<z>, like --stress=10x10" << std::endl;
+            }
+        }
+        else if (argument.compare(0, 16, "--stress-lights=") == 0)
+        {
+            stress.lights = static_cast<GLuint>(std::strtoul(argument.c_str() + 16, nullptr, 10));
+            buildStress = true;
+        }
+        else if (argument.compare(0, 7, "--seed=") == 0)
+        {
+            stress.seed = static_cast<GLuint>(std::strtoul(argument.c_str() + 7, nullptr, 10));
+        }
+        else if (argument.compare(0, 9, "--import=") == 0)
+        {
+            importPaths.push_back(argument.substr(9));
+        }
+        else if (argument.compare(0, 7, "--gate=") == 0)
+        {
+            gateDirectory = argument.substr(7);
+        }
+        else if (argument == "--gate-update")
+        {
+            gateUpdate = true;
+        }
+        else if (argument.compare(0, 9, "--record=") == 0)
+        {
+            inputLog.Record(argument.substr(9));
+        }
+        else if (argument.compare(0, 9, "--replay=") == 0)
+        {
+            inputLog.Replay(argument.substr(9));
+        }
+        else if (argument == "--multiview")
+        {
+            multiView = true;
+        }
+        else if (argument.compare(0, 5, "--aa=") == 0)
+        {
+            if (!ParseAntiAliasingMode(argument.substr(5), antiAliasing))
+            {
+                std::cerr << "Error: Unknown anti-aliasing " << argument.substr(5) << ", --aa takes off, msaa2, msaa4, msaa8, fxaa or smaa" << std::endl;
+            }
+        }
+        else if (argument.compare(0, 18, "--target-frame-ms=") == 0)
+        {
+            targetFrameMilliseconds = std::atof(argument.c_str() + 18);
+        }
+        else if (argument.compare(0, 12, "--animation=") == 0)
+        {
+            animationPath = argument.substr(12);
+        }
+        else if (argument == "--bake")
+        {
+            bakeLighting = true;
+        }
+        else if (argument.compare(0, 7, "--bake=") == 0)
+        {
+            bakeLighting = true;
+            bakeCachePath = argument.substr(7);
+        }
+        else if (argument.compare(0, 10, "--upscale=") == 0)
+        {
+            if (!ParseUpscaleFilter(argument.substr(10), upscaleFilter))
+            {
+                std::cerr << "Error: Unknown upscale filter " << argument.substr(10) << ", --upscale takes bilinear or sharpen" << std::endl;
+            }
+        }
+        else if (argument.compare(0, 8, "--views=") == 0)
+        {
+            auto separator = argument.find('x', 8);
+            if (separator != std::string::npos)
+            {
+                viewColumns = std::atoi(argument.c_str() + 8);
+                viewRows = std::atoi(argument.c_str() + separator + 1);
+            }
+        }
+    }
+    if (viewColumns < 1 || viewRows < 1 || viewColumns * viewRows > MAX_VIEWS)
+    {
+        std::cerr << "Error: --views takes <columns>x<rows> of at most " << MAX_VIEWS << " views, using 2x1" << std::endl;
+        viewColumns = 2;
+        viewRows = 1;
+    }
+    window = std::vector<WindowInfo>(viewColumns * viewRows);
+    if (renderer != RendererBackend::OpenGL)
+    {
+        threadPool.reset(new ThreadPool());
+        std::cout << "Status: Using the " << rendererName() << " renderer on " << threadPool->Size() << " threads" << std::endl;
+    }
+
+    // Multisampling is left to the views' anti-aliasing targets, so modes without it don't pay for it
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH | GLUT_ALPHA);
+    // The views fill the top in 4:3 cells, 600 by 450 for the two side by side, the instructions go underneath
+    auto viewWidth = 1200 / viewColumns;
+    auto viewHeight = viewWidth * 3 / 4;
+    auto instructionTop = viewHeight * viewRows;
+    glutInitWindowSize(1200, instructionTop + 200);
     glutInitWindowPosition((glutGet(GLUT_SCREEN_WIDTH) - 1200) / 2,
-                           (glutGet(GLUT_SCREEN_HEIGHT) - 650) / 2);
+                           (glutGet(GLUT_SCREEN_HEIGHT) - instructionTop - 200) / 2);
     mainWindow = glutCreateWindow(TITLE);
 
     glewExperimental = GL_TRUE;
@@ -156,138 +461,449 @@ int main(int argc, char* argv[])
     }
     std::cout << "Status: Using GLEW " << glewGetString(GLEW_VERSION) << std::endl;
 
+    // Every subwindow draws with this context, so the views share one set of shaders, meshes & buffers
+    glutSetOption(GLUT_RENDERING_CONTEXT, GLUT_USE_CURRENT_CONTEXT);
+
+    if (!gateDirectory.empty())
+    {
+        // Golden images are kept per renderer, timings per renderer & configuration
+        std::string images = renderer == RendererBackend::Software ? "software" : renderer == RendererBackend::RayTrace ? "raytrace" : "gl";
+#ifdef _DEBUG
+        auto build = images + "_debug";
+#else
+        auto build = images + "_release";
+#endif
+        std::vector<std::string> viewNames;
+        for (size_t i = 0; i < window.size(); ++i)
+        {
+            viewNames.push_back(viewName(static_cast<int>(i)));
+        }
+        gate.Setup(gateDirectory, build, images, viewNames, gateUpdate);
+        EnableFrameStats();
+
+        // So main can hand back the gate's verdict
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+    }
+
+    if (multiView && (renderer != RendererBackend::OpenGL || gate.Active() || !MultiViewSupported()))
+    {
+        std::cerr << "Error: Multi-view needs the OpenGL renderer, viewport arrays and gl_ViewportIndex in the vertex shader, and can't run with the gate" << std::endl;
+        multiView = false;
+    }
+    if (multiView)
+    {
+        std::cout << "Status: Drawing all " << window.size() << " views in one pass" << std::endl;
+    }
+
+    if (inputLog.Recording() || inputLog.Replaying())
+    {
+        // So the log can be finished off after the main loop
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+    }
+
     glutDisplayFunc(mainWindowDisplayCallback);
     glutIdleFunc(idleCallback);
 
-    leftWindow = glutCreateSubWindow(mainWindow, 0, 0, 600, 450);
-    initialize(0);
-    glutDisplayFunc(leftWindowDisplayCallback);
-    glutKeyboardFunc(leftWindowKeyPressCallback);
-    glutKeyboardUpFunc(leftWindowKeyUpCallback);
-    glutSpecialFunc(leftWindowSpecialPressCallback);
-    glutSpecialUpFunc(leftWindowSpecialUpCallback);
-
-    rightWindow = glutCreateSubWindow(mainWindow, 600, 0, 600, 450);
-    initialize(1);
-    glutDisplayFunc(rightWindowDisplayCallback);
-    glutKeyboardFunc(rightWindowKeyPressCallback);
-    glutKeyboardUpFunc(rightWindowKeyUpCallback);
-    glutSpecialFunc(rightWindowSpecialPressCallback);
-    glutSpecialUpFunc(rightWindowSpecialUpCallback);
-
-    instructionWindow = glutCreateSubWindow(mainWindow, 0, 450, 1200, 200);
+    initializeShared();
+    if (benchmarkPicking)
+    {
+        return RunPickingBenchmark(std::cout, scene, objectTree, picker) ? 0 : 1;
+    }
+    for (auto i = 0; i < static_cast<int>(window.size()); ++i)
+    {
+        viewWindows.push_back(glutCreateSubWindow(mainWindow, (i % viewColumns) * viewWidth, (i / viewColumns) * viewHeight, viewWidth, viewHeight));
+        initialize(i);
+        glutDisplayFunc(viewDisplayCallback);
+        glutKeyboardFunc(viewKeyPressCallback);
+        glutKeyboardUpFunc(viewKeyUpCallback);
+        glutSpecialFunc(viewSpecialPressCallback);
+        glutSpecialUpFunc(viewSpecialUpCallback);
+        glutMotionFunc(viewMouseMoveCallback);
+        glutPassiveMotionFunc(viewMouseMoveCallback);
+    }
+
+    instructionWindow = glutCreateSubWindow(mainWindow, 0, instructionTop, 1200, 200);
+    initializeInstructions();
     glutDisplayFunc(instructionDisplayCallback);
 
+    auto start = std::chrono::steady_clock::now();
     glutMainLoop();
 
-    return 0;
+    if (inputLog.Replaying())
+    {
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Status: Replayed " << inputLog.Steps() << " steps in " << seconds << " s, "
+                  << seconds * 1000.0 / std::max(inputLog.Steps(), 1u) << " ms per frame" << std::endl;
+    }
+    inputLog.Close();
+
+    return exitCode;
 }
 
-void initialize(int windowId)
+// Loads the scene and sets up what every view draws with, before any view's window exists
+void initializeShared()
 {
-    auto width = glutGet(GLUT_WINDOW_WIDTH);
-    auto height = glutGet(GLUT_WINDOW_HEIGHT);
-
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glViewport(0, 0, width, height);
-    glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
-    glEnable(GL_CULL_FACE);
 
-    window[windowId].smoothShader.Setup("smooth_shader");
-    window[windowId].flatShader.Setup("flat_shader");
-    window[windowId].lampShader.Setup("lamp");
+    loadScene();
+
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(scene.objects.size());
+    for (const auto& object : scene.objects)
+    {
+        boxes.push_back(scene.Box(object));
+    }
+    objectTree.Build(boxes);
+    picker.Build(scene, threadPool.get());
+
+    animator = Animator::RoomSwings();
+    if (!animationPath.empty())
+    {
+        Animator loaded;
+        std::string error;
+        if (loaded.Load(animationPath, error))
+        {
+            animator = std::move(loaded);
+            std::cout << "Status: Loaded " << animator.Size() << " animation channels from " << animationPath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Error: Couldn't load " << animationPath << ": " << error << std::endl;
+        }
+    }
+
+    shared.smoothShader.Setup("smooth_shader");
+    shared.flatShader.Setup("flat_shader");
+    shared.lampShader.Setup("lamp");
+
+    for (const auto& material : scene.materials)
+    {
+        shared.materialTable.Add(material.material, material.tracked);
+    }
+    shared.materialTable.Upload();
+    shared.smoothShader.BindUniformBlock(MATERIAL_BLOCK_NAME, MATERIAL_BLOCK_BINDING);
+    shared.flatShader.BindUniformBlock(MATERIAL_BLOCK_NAME, MATERIAL_BLOCK_BINDING);
+    for (auto shader : { &shared.smoothShader, &shared.flatShader, &shared.lampShader })
+    {
+        shader->BindUniformBlock(CAMERA_BLOCK_NAME, CAMERA_BLOCK_BINDING);
+        shader->BindUniformBlock(LIGHT_BLOCK_NAME, LIGHT_BLOCK_BINDING);
+    }
+    LightBuffer::SetupShader(shared.smoothShader);
+    LightBuffer::SetupShader(shared.flatShader);
+
+    if (multiView)
+    {
+        auto defines = MultiViewDefines();
+        multiViewSmoothShader.Setup("smooth_shader", {}, defines);
+        multiViewFlatShader.Setup("flat_shader", {}, defines);
+        multiViewLampShader.Setup("lamp", {}, defines);
+        multiViewSmoothShader.BindUniformBlock(MATERIAL_BLOCK_NAME, MATERIAL_BLOCK_BINDING);
+        multiViewFlatShader.BindUniformBlock(MATERIAL_BLOCK_NAME, MATERIAL_BLOCK_BINDING);
+        for (auto shader : { &multiViewSmoothShader, &multiViewFlatShader, &multiViewLampShader })
+        {
+            shader->BindUniformBlock(CAMERA_BLOCK_NAME, CAMERA_BLOCK_BINDING);
+            shader->BindUniformBlock(LIGHT_BLOCK_NAME, LIGHT_BLOCK_BINDING);
+        }
+        // The shaders' blocks are sized for MAX_VIEWS whatever the number of views
+        multiViewStream.Setup(MAX_VIEWS * (sizeof(CameraBlock) + sizeof(LightBlock)) + 1024);
+    }
+
+    // Straight from the mapped pack when the scene came from one
+    shared.geometryPool.Setup(1 << 16, 1 << 18);
+    size_t packMeshCount = 0;
+    auto packMeshes = assetPack.IsOpen() ? assetPack.Records<PackMesh>(PackSection::Meshes, packMeshCount) : nullptr;
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        shared.meshHandles.push_back(i < packMeshCount ?
+            shared.geometryPool.Add(assetPack.Vertices(packMeshes[i]), packMeshes[i].vertexCount, assetPack.Indices(packMeshes[i]), packMeshes[i].indexCount) :
+            shared.geometryPool.Add(scene.meshes[i]));
+    }
+    shared.staticBatch.Build(scene.objects, scene, shared.meshHandles, shared.geometryPool);
+    shared.lampBatch.Build(scene.lamps, scene, shared.meshHandles, shared.geometryPool);
+    // Every view's culler picks the same occluders from the scene
+    OcclusionCuller occluders;
+    occluders.Setup(scene);
+    shared.occluderBatch.Build(occluders.Occluders(), scene, shared.meshHandles, shared.geometryPool);
+    if (bakeLighting && renderer == RendererBackend::OpenGL && !multiView)
+    {
+        bakeStaticLights();
+    }
+    else if (bakeLighting)
+    {
+        std::cerr << "Error: Baked lighting needs the OpenGL renderer drawing each view on its own, the lights stay dynamic" << std::endl;
+    }
+    BakedLightBuffer::SetupShader(shared.smoothShader);
+    BakedLightBuffer::SetupShader(shared.flatShader);
+
+    // Lights the scene doesn't have stay dark
+    const SceneLight dark = { glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), Material(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)),
+                              1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
+    {
+        const auto& source = i < static_cast<int>(scene.pointLights.size()) ? scene.pointLights[i] : dark;
+        shared.pointLights.push_back(shared.lights.Add(source, false));
+    }
+
+    for (auto i = 0; i <= NUM_OF_DISCO_LIGHTS; ++i)
+    {
+        const auto& source = i < static_cast<int>(scene.spotLights.size()) ? scene.spotLights[i] : dark;
+        shared.spotLights.push_back(shared.lights.Add(source, true));
+    }
+
+    // Any more the scene has only reach the shaders through the light buffer
+    for (size_t i = NUM_OF_POINT_LIGHTS; i < scene.pointLights.size(); ++i)
+    {
+        shared.pointLights.push_back(shared.lights.Add(scene.pointLights[i], false));
+    }
+    for (size_t i = NUM_OF_DISCO_LIGHTS + 1; i < scene.spotLights.size(); ++i)
+    {
+        shared.spotLights.push_back(shared.lights.Add(scene.spotLights[i], true));
+    }
+    if (scene.pointLights.size() + scene.spotLights.size() > MAX_POOL_LIGHTS)
+    {
+        std::cerr << "Error: Only the first " << MAX_POOL_LIGHTS << " of the scene's lights fit in the light pool" << std::endl;
+    }
+
+    // Baked lights reach the shaders through the baked colours instead
+    for (GLuint layer = 0; layer < lightBaker.LayerCount(); ++layer)
+    {
+        shared.lights.SetBaked(shared.pointLights[lightBaker.Light(layer)], true);
+    }
+
+    shared.textShader.Setup("text");
+    shared.panelShader.Setup("panel");
+    shared.font.Setup(GLUT_BITMAP_HELVETICA_12);
+    shared.antiAliasingShaders.Setup();
+    shared.upscaleShader.Setup("panel.vert", "upscale.frag");
+}
+
+// Per view state, with the view's window current
+void initialize(int windowId)
+{
     //window[windowId].useCurrentShader = std::bind(&Shader::Use, window[windowId].smoothShader);
 
     window[windowId].cameraStartPosition = glm::vec3(0.0f, 0.0f, 3.0f);
     window[windowId].camera.SetupCamera(window[windowId].cameraStartPosition);
+    // The first view starts out orthographic, as the left one always was
+    window[windowId].projectionMode = windowId == 0 ? ProjectionMode::Orthographic : ProjectionMode::Perspective;
+    window[windowId].antiAliasingMode = antiAliasing;
+    window[windowId].resolution.Setup(targetFrameMilliseconds / window.size());
 
-    for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
+    window[windowId].bakedOn.assign(lightBaker.LayerCount(), 1);
+
+    // Room for both blocks at the largest offset alignment in use
+    window[windowId].frameStream.Setup(4096);
+
+    window[windowId].staticBatch.Share(shared.staticBatch);
+    window[windowId].lampBatch.Share(shared.lampBatch);
+    window[windowId].occlusionCuller.Setup(scene);
+    window[windowId].occluderBatch.Share(shared.occluderBatch);
+
+    window[windowId].statusPanel.Setup(shared.font, shared.textShader, glm::vec4(0.0f, 0.0f, 0.0f, 0.5f));
+    window[windowId].statusPanel.SetSize(STATUS_PANEL_WIDTH, STATUS_PANEL_HEIGHT);
+    window[windowId].readoutPanel.Setup(shared.font, shared.textShader, glm::vec4(0.0f, 0.0f, 0.0f, 0.5f));
+    window[windowId].readoutPanel.SetSize(STATUS_PANEL_WIDTH, READOUT_PANEL_HEIGHT);
+
+    if (renderer == RendererBackend::Software)
+    {
+        window[windowId].rasterizer.Setup(*threadPool);
+    }
+    else if (renderer == RendererBackend::RayTrace)
     {
-        window[windowId].pointLights[i].id = i;
-        window[windowId].pointLights[i].position = glm::vec3(lightPositions[i].x, lightPositions[i].y, lightPositions[i].z);
-        window[windowId].pointLights[i].material = lightMaterials[i];
-        window[windowId].pointLights[i].active = lightMaterials[i];
-        window[windowId].pointLights[i].constant = lightConstant;
-        window[windowId].pointLights[i].linear = lightAttenuation[1][0];
-        window[windowId].pointLights[i].quadratic = lightAttenuation[1][1];
-    }
-
-    window[windowId].spotLight.id = 0;
-    window[windowId].spotLight.position = spotLightPos;
-    window[windowId].spotLight.direction = glm::normalize(spotLightDir);
-    window[windowId].spotLight.material = spotLightMaterial;
-    window[windowId].spotLight.active = spotLightMaterial;
-    window[windowId].spotLight.constant = lightConstant;
-    window[windowId].spotLight.linear = spotLightAttenuation[0];
-    window[windowId].spotLight.quadratic = spotLightAttenuation[1];
-    window[windowId].spotLight.cutOff = spotLightCutOff;
-    window[windowId].spotLight.outerCutOff = spotLightOuterCutOff;
+        window[windowId].rayTracer.Setup(*threadPool);
+        window[windowId].rayTracer.Build(scene);
+    }
+}
 
-    for (auto i = 0; i < NUM_OF_DISCO_LIGHTS; ++i)
+// A stress grid if asked for, else the asset pack if there is one, else the scene built into the program, then the imported models
+void loadScene()
+{
+    auto path = packPath.empty() ? std::string(DEFAULT_ASSET_PACK) : packPath;
+    auto start = glutGet(GLUT_ELAPSED_TIME);
+    if (buildStress)
+    {
+        BuildStressScene(scene, stress);
+        std::cout << "Status: Built " << stress.roomsX << "x" << stress.roomsZ << " rooms with seed " << stress.seed << ", "
+                  << scene.objects.size() << " objects and " << scene.pointLights.size() + scene.spotLights.size() << " lights in "
+                  << glutGet(GLUT_ELAPSED_TIME) - start << " ms" << std::endl;
+    }
+    else if (assetPack.Open(path) && LoadScene(assetPack, scene))
+    {
+        std::cout << "Status: Loaded " << path << " in " << glutGet(GLUT_ELAPSED_TIME) - start << " ms" << std::endl;
+    }
+    else
+    {
+        if (!packPath.empty())
+        {
+            std::cerr << "Error: Couldn't load " << path << " as a version " << ASSET_PACK_VERSION << " asset pack, using the built-in scene" << std::endl;
+        }
+        assetPack.Close();
+        BuildRoomScene(scene);
+    }
+
+    if (!importPaths.empty())
+    {
+        // The GL renderer has no pool of its own, importing borrows one
+        std::unique_ptr<ThreadPool> importPool;
+        if (!threadPool)
+        {
+            importPool.reset(new ThreadPool());
+        }
+        auto& pool = threadPool ? *threadPool : *importPool;
+        for (const auto& importPath : importPaths)
+        {
+            start = glutGet(GLUT_ELAPSED_TIME);
+            ImportedModel model;
+            std::string error;
+            if (!ImportModel(importPath, pool, model, error))
+            {
+                std::cerr << "Error: Couldn't import " << importPath << ": " << error << std::endl;
+                continue;
+            }
+            if (!AddModelToScene(model, glm::mat4(), scene, error))
+            {
+                std::cerr << "Error: Couldn't import " << importPath << ": " << error << std::endl;
+                continue;
+            }
+            std::cout << "Status: Imported " << importPath << " (" << model.meshes.size() << " meshes, "
+                      << model.instances.size() << " objects) in " << glutGet(GLUT_ELAPSED_TIME) - start << " ms" << std::endl;
+        }
+    }
+
+    if (!writePackPath.empty())
+    {
+        if (WriteAssetPack(writePackPath, scene))
+        {
+            std::cout << "Status: Wrote the scene to " << writePackPath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Error: Couldn't write " << writePackPath << std::endl;
+        }
+    }
+}
+
+// Bakes the point lights no animation moves into the static objects' vertices, reusing what the cache still holds
+void bakeStaticLights()
+{
+    std::vector<char> baked(scene.pointLights.size());
+    for (size_t i = 0; i < baked.size(); ++i)
+    {
+        baked[i] = !animator.Animates(AnimationTarget::PointLight, static_cast<GLuint>(i));
+    }
+
+    // The GL renderer has no pool of its own, baking borrows one
+    ThreadPool pool;
+    auto start = glutGet(GLUT_ELAPSED_TIME);
+    std::string error;
+    if (!lightBaker.Bake(scene, objectTree, baked, shared.meshHandles, shared.geometryPool, pool, bakeCachePath, error))
+    {
+        std::cerr << "Error: Couldn't bake the lighting: " << error << std::endl;
+        return;
+    }
+    if (!error.empty())
+    {
+        std::cerr << "Error: Baked the lighting but " << error << std::endl;
+    }
+    shared.staticBatch.SetBakeBases(lightBaker.Bases());
+    std::cout << "Status: Baked " << lightBaker.LayerCount() << " of " << scene.pointLights.size() << " point lights over "
+              << lightBaker.VertexCount() << " vertices, " << lightBaker.CachedLayers() << " of them from " << bakeCachePath << ", in "
+              << glutGet(GLUT_ELAPSED_TIME) - start << " ms" << std::endl;
+}
+
+void initializeInstructions()
+{
+    instructionPanel.Setup(shared.font, shared.textShader, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    const glm::vec3 black(0.0f, 0.0f, 0.0f);
+    const glm::vec3 red(1.0f, 0.0f, 0.0f);
+    instructionPanel.SetLabels({
+        { glm::vec2(20, 180), black, "z - Points mode" },
+        { glm::vec2(20, 160), black, "x - Wireframe mode" },
+        { glm::vec2(20, 140), black, "c - Solid mode" },
+        { glm::vec2(20, 120), black, "v - Toggle shading" },
+        { glm::vec2(20, 100), red, "b - Toggle color tracking" },
+        { glm::vec2(20, 80), red, "n - Toggle ambient lighting" },
+        { glm::vec2(20, 60), black, "m - Toggle backface culling" },
+        { glm::vec2(20, 40), black, ", - Toggle culling face" },
+        { glm::vec2(20, 20), black, ". - Toggle depth testing" },
+
+        { glm::vec2(220, 180), black, "1 - Toggle point light 1" },
+        { glm::vec2(220, 160), black, "2 - Toggle point light 2" },
+        { glm::vec2(220, 140), black, "3 - Toggle spot light" },
+        { glm::vec2(220, 120), black, "4 - Toggle disco mode" },
+        { glm::vec2(220, 100), black, "[ - Speedup spotlight swing" },
+        { glm::vec2(220, 80), black, "] - Slowdown spotlight swing" },
+        { glm::vec2(220, 60), black, "ESC - Quit" },
+        { glm::vec2(220, 40), black, "o - Toggle occlusion culling" },
+        { glm::vec2(220, 20), black, "p - Toggle projection" },
+
+        { glm::vec2(420, 180), black, "w - Move forward" },
+        { glm::vec2(420, 160), black, "a - Move backward" },
+        { glm::vec2(420, 140), black, "s - Strafe left" },
+        { glm::vec2(420, 120), black, "d - Strafe right" },
+        { glm::vec2(420, 100), black, "q - Roll left" },
+        { glm::vec2(420, 80), black, "e - Roll right" },
+        { glm::vec2(420, 60), black, "UP - Look up" },
+        { glm::vec2(420, 40), black, "DOWN - Look down" },
+        { glm::vec2(420, 20), black, "LEFT - Look left" },
+
+        { glm::vec2(620, 180), black, "RIGHT - Look right" },
+        { glm::vec2(620, 160), black, "PAGE UP - Move up" },
+        { glm::vec2(620, 140), black, "PAGE DOWN - Move down" },
+        { glm::vec2(620, 120), black, "HOME - Zoom in" },
+        { glm::vec2(620, 100), black, "END - Zoom out" },
+        { glm::vec2(620, 80), black, "0 - Reset camera" },
+        { glm::vec2(620, 60), black, "g - Cycle anti-aliasing" }
+    });
+}
+
+// Only changes when a toggle does or the resolution steps, the panel is re-rendered then
+std::vector<TextLabel> statusLabels(int windowId)
+{
+    const glm::vec3 white(1.0f, 1.0f, 1.0f);
+    auto onOff = [](bool on) { return on ? std::string("on") : std::string("off"); };
+    return {
+        { glm::vec2(10, 130), white, "Resolution: " + std::to_string(static_cast<int>(window[windowId].resolution.Scale() * 100.0f + 0.5f)) + "%" },
+        { glm::vec2(10, 110), white, std::string("Anti-aliasing: ") + AntiAliasingModeName(window[windowId].antiAliasingMode) },
+        { glm::vec2(10, 90), white, "Point light 1: " + onOff(window[windowId].lightSwitches.IsOn(shared.pointLights[0])) },
+        { glm::vec2(10, 70), white, "Point light 2: " + onOff(window[windowId].lightSwitches.IsOn(shared.pointLights[1])) },
+        { glm::vec2(10, 50), white, "Spot light: " + onOff(window[windowId].lightSwitches.IsOn(shared.spotLights[0])) },
+        { glm::vec2(10, 30), white, std::string("Shading: ") + (window[windowId].useSmoothShading ? "smooth" : "flat") },
+        { glm::vec2(10, 10), white, "Color tracking: " + onOff(window[windowId].useColorTracking) }
+    };
+}
+
+// Changes nearly every frame, so it is only sampled every READOUT_INTERVAL
+std::vector<TextLabel> readoutLabels(int windowId)
+{
+    const glm::vec3 white(1.0f, 1.0f, 1.0f);
+    auto& batch = window[windowId].staticBatch;
+    const auto& picked = window[windowId].picked;
+    std::ostringstream resolution;
+    resolution.precision(1);
+    if (window[windowId].resolution.Enabled())
+    {
+        resolution << std::fixed << "GPU frame: " << window[windowId].resolution.AverageMilliseconds() << " of "
+                   << window[windowId].resolution.TargetMilliseconds() << " ms";
+    }
+    else
     {
-        window[windowId].discoLights[i].id = i;
-        window[windowId].discoLights[i].position = discoLightsPos;
-        window[windowId].discoLights[i].direction = discoLightsDir;
-        window[windowId].discoLights[i].material = discoLightMaterials[i];
-        window[windowId].discoLights[i].active = discoLightMaterials[i];
-        window[windowId].discoLights[i].constant = lightConstant;
-        window[windowId].discoLights[i].linear = discoLightsAttenuation[0];
-        window[windowId].discoLights[i].quadratic = discoLightsAttenuation[1];
-        window[windowId].discoLights[i].cutOff = discoLightsCutOff;
-        window[windowId].discoLights[i].outerCutOff = discoLightsOuterCutOff;
-    }
-
-    window[windowId].ornaments.push_back([] { glutSolidTeapot(0.15f); });
-    window[windowId].ornaments.push_back([] { glutSolidSphere(0.15f, 100, 100); });
-    window[windowId].ornaments.push_back([] { glutSolidCone(0.15f, 0.5f, 100, 100); });
-    window[windowId].ornaments.push_back([] { glutSolidTorus(0.1f, 0.2f, 100, 100); });
-    window[windowId].ornaments.push_back([] { glutSolidDodecahedron(); });
-    window[windowId].ornaments.push_back([] { glutSolidOctahedron(); });
-    window[windowId].ornaments.push_back([] { glutSolidTetrahedron(); });
-    window[windowId].ornaments.push_back([] { glutSolidIcosahedron(); });
-
-    glGenVertexArrays(1, &window[windowId].chairVAO);
-    glGenBuffers(1, &window[windowId].chairVBOPos);
-    glGenBuffers(1, &window[windowId].chairVBONormals);
-    glBindVertexArray(window[windowId].chairVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].chairVBOPos);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(chairPositions), chairPositions, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].chairVBONormals);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(chairNormals), chairNormals, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindVertexArray(0);
-
-    glGenVertexArrays(1, &window[windowId].tableVAO);
-    glGenBuffers(1, &window[windowId].tableVBOPos);
-    glGenBuffers(1, &window[windowId].tableVBONormals);
-    glBindVertexArray(window[windowId].tableVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].tableVBOPos);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(tablePositions), tablePositions, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].tableVBONormals);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(tableNormals), tableNormals, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindVertexArray(0);
-
-    glGenVertexArrays(1, &window[windowId].planeVAO);
-    glGenBuffers(1, &window[windowId].planeVBOPos);
-    glGenBuffers(1, &window[windowId].planeVBONormals);
-    glBindVertexArray(window[windowId].planeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].planeVBOPos);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planePositions), planePositions, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindBuffer(GL_ARRAY_BUFFER, window[windowId].planeVBONormals);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeNormals), planeNormals, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glBindVertexArray(0);
+        resolution << "GPU frame: no target";
+    }
+    std::ostringstream antiAliasing;
+    antiAliasing.precision(2);
+    antiAliasing << std::fixed << "Anti-aliasing: " << window[windowId].antiAliasingGpuMilliseconds << " of "
+                 << window[windowId].frameGpuMilliseconds << " ms";
+    return {
+        { glm::vec2(10, 70), white, resolution.str() },
+        { glm::vec2(10, 50), white, antiAliasing.str() },
+        { glm::vec2(10, 30), white, "Objects drawn: " + std::to_string(batch.Size()) + " / " + std::to_string(batch.ObjectCount()) +
+                                    ", " + std::to_string(batch.OccludedCount()) + " occluded" },
+        { glm::vec2(10, 10), white, picked.object == PICK_NO_HIT ? std::string("Picked: nothing") :
+                                    "Picked: object " + std::to_string(picked.object) + ", tri " + std::to_string(picked.triangle) }
+    };
 }
 
 void display(int windowId)
@@ -295,20 +911,329 @@ void display(int windowId)
     auto width = glutGet(GLUT_WINDOW_WIDTH);
     auto height = glutGet(GLUT_WINDOW_HEIGHT);
 
+    if (benchmark)
+    {
+        window[windowId].frameTimer.Begin();
+    }
+
+    // Scripted camera & clock while the gate runs
+    auto time = frameTime;
+    if (gate.Active())
+    {
+        time = gate.BeginFrame(windowId, window[windowId].camera);
+    }
+
+    // The views share one context, so nothing about its state carries over from the last view drawn
+    glViewport(0, 0, width, height);
+
+    // Pixels of this frame when a CPU renderer drew it
+    const std::vector<GLuint>* cpuPixels = nullptr;
+    if (multiView)
+    {
+        // Drawn along with the other views in renderMultiView, just this view's part is left to show
+        multiViewTarget.Present(windowId, shared.panelShader);
+    }
+    else if (renderer == RendererBackend::OpenGL)
+    {
+        // Drawn at the view's resolution scale into the anti-aliasing target, then resolved or filtered
+        // into the window, or into the upscale target and from there stretched over the window
+        auto scale = window[windowId].resolution.Scale();
+        auto renderWidth = std::max(1, static_cast<int>(width * scale + 0.5f));
+        auto renderHeight = std::max(1, static_cast<int>(height * scale + 0.5f));
+        auto scaled = renderWidth != width || renderHeight != height;
+        GLuint output = 0;
+        if (scaled)
+        {
+            window[windowId].upscaleTarget.Resize(renderWidth, renderHeight);
+            output = window[windowId].upscaleTarget.Framebuffer();
+            glViewport(0, 0, renderWidth, renderHeight);
+        }
+        window[windowId].antiAliasTarget.Resize(window[windowId].antiAliasingMode, renderWidth, renderHeight);
+
+        window[windowId].frameGpuTimer.Begin();
+        window[windowId].resolutionGpuTimer.Begin();
+        window[windowId].antiAliasTarget.Begin(output);
+        renderView(windowId, renderWidth, renderHeight, time);
+        window[windowId].antiAliasingGpuTimer.Begin();
+        window[windowId].antiAliasTarget.End(shared.antiAliasingShaders, output);
+        window[windowId].antiAliasingGpuTimer.End();
+        if (scaled)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, width, height);
+            window[windowId].upscaleTarget.Present(shared.upscaleShader, upscaleFilter);
+        }
+        window[windowId].resolutionGpuTimer.End();
+        window[windowId].frameGpuTimer.End();
+        window[windowId].frameGpuTimer.Result(window[windowId].frameGpuMilliseconds);
+        window[windowId].antiAliasingGpuTimer.Result(window[windowId].antiAliasingGpuMilliseconds);
+
+        double gpuMilliseconds;
+        if (window[windowId].resolutionGpuTimer.Result(gpuMilliseconds) && window[windowId].resolution.Update(gpuMilliseconds) && benchmark)
+        {
+            std::cout << "Benchmark: " << viewName(windowId) << " view now at " << window[windowId].resolution.Scale() * 100.0f
+                      << "% resolution, " << gpuMilliseconds << " ms on the GPU against " << window[windowId].resolution.TargetMilliseconds()
+                      << " ms, " << window[windowId].resolution.Decreases() << " decreases & "
+                      << window[windowId].resolution.Increases() << " increases so far" << std::endl;
+        }
+    }
+    else
+    {
+        cpuPixels = renderView(windowId, width, height, time);
+    }
+    // Overlays are drawn solid whatever the view's polygon mode
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    if (!stillPrefix.empty())
+    {
+        saveStill(windowId, cpuPixels, width, height);
+        return;
+    }
+
+    window[windowId].statusPanel.SetLabels(statusLabels(windowId));
+    window[windowId].statusPanel.Draw(shared.panelShader, 10, height - 10 - STATUS_PANEL_HEIGHT);
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - window[windowId].readoutTime).count() >= READOUT_INTERVAL)
+    {
+        window[windowId].readoutPanel.SetLabels(readoutLabels(windowId));
+        window[windowId].readoutTime = now;
+    }
+    window[windowId].readoutPanel.Draw(shared.panelShader, 10, height - 20 - STATUS_PANEL_HEIGHT - READOUT_PANEL_HEIGHT);
+
+    double milliseconds;
+    if (benchmark)
+    {
+        // Count the GPU's share too, not just the time to queue the commands
+        glFinish();
+        if (window[windowId].frameTimer.End(milliseconds))
+        {
+            std::cout << "Benchmark: " << viewName(windowId) << " view, "
+                      << rendererName() << " renderer, "
+                      << milliseconds << " ms per frame";
+            if (renderer == RendererBackend::OpenGL && !multiView)
+            {
+                std::cout << ", " << AntiAliasingModeName(window[windowId].antiAliasingMode) << " anti-aliasing, "
+                          << window[windowId].frameGpuMilliseconds << " ms on the GPU of which "
+                          << window[windowId].antiAliasingGpuMilliseconds << " ms resolving or filtering, at "
+                          << window[windowId].resolution.Scale() * 100.0f << "% resolution";
+            }
+            std::cout << ", last pick " << window[windowId].pickMicroseconds << " us" << std::endl;
+        }
+    }
+
+    if (gate.Active() && gate.EndFrame(windowId, width, height))
+    {
+        exitCode = gate.Finish(std::cout);
+        glutLeaveMainLoop();
+    }
+
+    glutSwapBuffers();
+}
+
+// Draws one view on its own, gives the pixels when a CPU renderer drew them
+const std::vector<GLuint>* renderView(int windowId, int width, int height, GLfloat time)
+{
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (window[windowId].useSmoothShading)
     {
-        window[windowId].smoothShader.Use();
+        shared.smoothShader.Use();
+    } else
+    {
+        shared.flatShader.Use();
+    }
+
+    applyRenderState(windowId);
+    updateView(windowId, width, height, time);
+
+    // Pixels of this frame when a CPU renderer drew it
+    const std::vector<GLuint>* cpuPixels = nullptr;
+    if (renderer != RendererBackend::OpenGL)
+    {
+        CameraBlock camera;
+        LightBlock lights;
+        writeFrameData(windowId, camera, lights);
+
+        RasterSettings settings = { window[windowId].useSmoothShading, window[windowId].useColorTracking,
+                                    window[windowId].useBackfaceCulling, window[windowId].cullFrontFace };
+        if (renderer == RendererBackend::Software)
+        {
+            auto& rasterizer = window[windowId].rasterizer;
+            rasterizer.Resize(width, height);
+            rasterizer.Render(scene, camera, lights, settings);
+            cpuPixels = &rasterizer.Pixels();
+        }
+        else
+        {
+            auto& rayTracer = window[windowId].rayTracer;
+            rayTracer.Resize(width, height);
+            rayTracer.Render(scene, camera, lights, settings);
+            cpuPixels = &rayTracer.Pixels();
+        }
+        window[windowId].presenter.Present(*cpuPixels, width, height, shared.panelShader);
+    }
+    else
+    {
+        // Write this frame's camera & lights straight into the stream buffer
+        auto& frameStream = window[windowId].frameStream;
+        frameStream.Begin();
+
+        StreamAllocation cameraAllocation, lightAllocation;
+        auto camera = frameStream.Allocate<CameraBlock>(cameraAllocation);
+        auto lights = frameStream.Allocate<LightBlock>(lightAllocation);
+        writeFrameData(windowId, *camera, *lights);
+
+        // Baked lights come with the vertices, ambient & diffuse only, unless colour tracking swapped the materials they were baked with
+        auto useBakedLighting = lightBaker.Baked() && !window[windowId].useColorTracking &&
+                                lightBaker.PoolGeneration() == shared.geometryPool.Generation();
+        if (useBakedLighting)
+        {
+            for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
+            {
+                if (shared.lights.IsBaked(shared.pointLights[i]))
+                {
+                    auto& light = lights->pointLights[i];
+                    light.ambient = light.diffuse = light.specular = glm::vec3(0.0f);
+                }
+            }
+        }
+
+        frameStream.BindRange(CAMERA_BLOCK_BINDING, cameraAllocation);
+        frameStream.BindRange(LIGHT_BLOCK_BINDING, lightAllocation);
+        shared.materialTable.Bind(window[windowId].useColorTracking);
+
+        // The lights past the Lights block's which reach into the view
+        Frustum frustum(window[windowId].projection * window[windowId].view);
+        shared.lights.Cull(frustum, NUM_OF_POINT_LIGHTS + 1 + NUM_OF_DISCO_LIGHTS, window[windowId].lightSwitches,
+                           window[windowId].visibleLights, useBakedLighting);
+        shared.lightBuffer.Upload(shared.lights);
+        window[windowId].visibleLightBuffer.Upload(window[windowId].visibleLights);
+        const auto& litShader = window[windowId].useSmoothShading ? shared.smoothShader : shared.flatShader;
+        shared.lightBuffer.Bind(litShader);
+        window[windowId].visibleLightBuffer.Bind(litShader);
+        if (useBakedLighting)
+        {
+            // Toggling a light only sums again the objects it reaches
+            for (GLuint layer = 0; layer < lightBaker.LayerCount(); ++layer)
+            {
+                window[windowId].bakedOn[layer] = window[windowId].lightSwitches.IsOn(shared.pointLights[lightBaker.Light(layer)]);
+            }
+            window[windowId].bakedLights.Update(lightBaker, window[windowId].bakedOn);
+        }
+        window[windowId].bakedLights.Bind(litShader, useBakedLighting);
+
+        // Occluders only hide what's behind them when drawn solid and depth tested
+        auto useOcclusion = window[windowId].useOcclusionCulling && window[windowId].useDepthTesting && window[windowId].polygonMode == GL_FILL;
+        OcclusionCuller* occlusion = nullptr;
+        if (useOcclusion)
+        {
+            RasterSettings settings = { window[windowId].useSmoothShading, window[windowId].useColorTracking,
+                                        window[windowId].useBackfaceCulling, window[windowId].cullFrontFace };
+            occlusion = &window[windowId].occlusionCuller;
+            occlusion->Render(objectTree, window[windowId].view, window[windowId].projection, settings);
+
+            // Lay down the occluders' depth first, so the lit pass only shades what's in front of them
+            window[windowId].occluderBatch.SetVisible(occlusion->Rendered());
+            shared.lampShader.Use();
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            window[windowId].occluderBatch.Draw();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthFunc(GL_LEQUAL);
+            if (window[windowId].useSmoothShading)
+            {
+                shared.smoothShader.Use();
+            } else
+            {
+                shared.flatShader.Use();
+            }
+        }
+        window[windowId].staticBatch.Cull(objectTree, frustum, occlusion);
+        window[windowId].staticBatch.SelectLods(window[windowId].view, window[windowId].projection, static_cast<GLfloat>(height));
+        window[windowId].staticBatch.Draw();
+
+        shared.lampShader.Use();
+        window[windowId].lampBatch.SelectLods(window[windowId].view, window[windowId].projection, static_cast<GLfloat>(height));
+        window[windowId].lampBatch.Draw();
+        glDepthFunc(GL_LESS);
+
+        frameStream.End();
+    }
+
+    return cpuPixels;
+}
+
+// Draws every view in one pass into the multi-view target, display then shows each window its part.
+// Culling, depth testing & shading follow the first view, occlusion culling is left out
+void renderMultiView()
+{
+    auto time = frameTime;
+
+    auto& sizes = multiViewSizes;
+    sizes.clear();
+    for (auto view : viewWindows)
+    {
+        glutSetWindow(view);
+        sizes.emplace_back(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+    }
+
+    auto& views = multiViewViews;
+    auto& projections = multiViewProjections;
+    auto& frustums = multiViewFrustums;
+    views.clear();
+    projections.clear();
+    frustums.clear();
+    auto height = 0;
+    for (size_t windowId = 0; windowId < window.size(); ++windowId)
+    {
+        updateView(windowId, sizes[windowId].x, sizes[windowId].y, time);
+        views.push_back(window[windowId].view);
+        projections.push_back(window[windowId].projection);
+        frustums.emplace_back(window[windowId].projection * window[windowId].view);
+        height = std::max(height, sizes[windowId].y);
+    }
+    auto viewCount = static_cast<GLuint>(sizes.size());
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    multiViewTarget.Resize(sizes);
+    multiViewTarget.Begin();
+    applyRenderState(0);
+    if (window[0].useSmoothShading)
+    {
+        multiViewSmoothShader.Use();
     } else
     {
-        window[windowId].flatShader.Use();
+        multiViewFlatShader.Use();
+    }
+
+    multiViewStream.Begin();
+    StreamAllocation cameraAllocation = multiViewStream.Allocate(MAX_VIEWS * sizeof(CameraBlock));
+    StreamAllocation lightAllocation = multiViewStream.Allocate(MAX_VIEWS * sizeof(LightBlock));
+    auto cameras = static_cast<CameraBlock*>(cameraAllocation.data);
+    auto lights = static_cast<LightBlock*>(lightAllocation.data);
+    for (GLuint i = 0; i < viewCount; ++i)
+    {
+        writeFrameData(i, cameras[i], lights[i]);
     }
+    multiViewStream.BindRange(CAMERA_BLOCK_BINDING, cameraAllocation);
+    multiViewStream.BindRange(LIGHT_BLOCK_BINDING, lightAllocation);
+    shared.materialTable.Bind(window[0].useColorTracking);
 
-    //window[windowId].useCurrentShader();
-    GLuint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>(&program));
+    window[0].staticBatch.Cull(objectTree, frustums);
+    window[0].staticBatch.SelectLods(views, projections, static_cast<GLfloat>(height));
+    window[0].staticBatch.Draw(viewCount);
+
+    multiViewLampShader.Use();
+    window[0].lampBatch.SelectLods(views, projections, static_cast<GLfloat>(height));
+    window[0].lampBatch.Draw(viewCount);
+
+    multiViewStream.End();
+    multiViewTarget.End();
+}
 
+// Culling, depth testing & polygon mode as the view's toggles have them
+void applyRenderState(int windowId)
+{
     if (window[windowId].useBackfaceCulling)
     {
         glEnable(GL_CULL_FACE);
@@ -333,50 +1258,31 @@ void display(int windowId)
         glDisable(GL_DEPTH_TEST);
     }
 
-    glUniform3f(glGetUniformLocation(program, "viewPos"), window[windowId].camera.Position.x, window[windowId].camera.Position.y, window[windowId].camera.Position.z);
-    for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
+    glPolygonMode(GL_FRONT_AND_BACK, window[windowId].polygonMode);
+}
+
+// Evaluates the animation at time and moves the shared lights and every view's lamps, once for each new time
+void animate(GLfloat time)
+{
+    if (!animator.Evaluate(time))
     {
-        window[windowId].pointLights[i].Render();
+        return;
     }
-
-    //TODO Refactor this
-    window[windowId].spotLight.direction.x = sin((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].spotLightSwingSpeed);
-    window[windowId].spotLight.direction = glm::normalize(window[windowId].spotLight.direction);
-    window[windowId].spotLight.Render();
-
-    window[windowId].discoLights[0].direction.x = sin((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[0].direction = glm::normalize(window[windowId].discoLights[0].direction);
-
-    window[windowId].discoLights[1].direction.z = cos((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[1].direction = glm::normalize(window[windowId].discoLights[1].direction);
-
-    //discoLights[2].direction.x = sin((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * discoLightSwingSpeed);
-    window[windowId].discoLights[2].direction.x = sin((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[2].direction.z = cos((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[2].direction = glm::normalize(window[windowId].discoLights[2].direction);
-
-    window[windowId].discoLights[3].direction.x = sin((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[3].direction.z = cos((glutGet(GLUT_ELAPSED_TIME) / 1000.0f) * window[windowId].discoLightSwingSpeed);
-    window[windowId].discoLights[3].direction = glm::normalize(window[windowId].discoLights[3].direction);
-
-    for (auto i = 0; i < NUM_OF_DISCO_LIGHTS; ++i)
+    animator.Apply(shared.lights, shared.pointLights, shared.spotLights);
+    animator.Apply(scene, shared.lampBatch);
+    for (auto& view : window)
     {
-        auto uniformVariable = "discoLights[" + std::to_string(i) + "].";
-        glUniform3f(glGetUniformLocation(program, (uniformVariable + "position").c_str()), window[windowId].discoLights[i].position.x, window[windowId].discoLights[i].position.y, window[windowId].discoLights[i].position.z);
-        glUniform3f(glGetUniformLocation(program, (uniformVariable + "direction").c_str()), window[windowId].discoLights[i].direction.x, window[windowId].discoLights[i].direction.y, window[windowId].discoLights[i].direction.z);
-        glUniform3f(glGetUniformLocation(program, (uniformVariable + "ambient").c_str()), window[windowId].discoLights[i].active.ambient.x, window[windowId].discoLights[i].active.ambient.y, window[windowId].discoLights[i].active.ambient.z);
-        glUniform3f(glGetUniformLocation(program, (uniformVariable + "diffuse").c_str()), window[windowId].discoLights[i].active.diffuse.x, window[windowId].discoLights[i].active.diffuse.y, window[windowId].discoLights[i].active.diffuse.z);
-        glUniform3f(glGetUniformLocation(program, (uniformVariable + "specular").c_str()), window[windowId].discoLights[i].active.specular.x, window[windowId].discoLights[i].active.specular.y, window[windowId].discoLights[i].active.specular.z);
-        glUniform1f(glGetUniformLocation(program, (uniformVariable + "constant").c_str()), window[windowId].discoLights[i].constant);
-        glUniform1f(glGetUniformLocation(program, (uniformVariable + "linear").c_str()), window[windowId].discoLights[i].linear);
-        glUniform1f(glGetUniformLocation(program, (uniformVariable + "quadratic").c_str()), window[windowId].discoLights[i].quadratic);
-        glUniform1f(glGetUniformLocation(program, (uniformVariable + "cutOff").c_str()), glm::cos(glm::radians(window[windowId].discoLights[i].cutOff)));
-        glUniform1f(glGetUniformLocation(program, (uniformVariable + "outerCutOff").c_str()), glm::cos(glm::radians(window[windowId].discoLights[i].outerCutOff)));
+        animator.Apply(scene, view.lampBatch);
     }
+}
 
+// Animates the scene to time and sets the view's view & projection for a window of width by height
+void updateView(int windowId, int width, int height, GLfloat time)
+{
+    // The animation is shared, only the first view to get to a new time evaluates it
+    animate(time);
 
-    if (windowId == 1)
-    //if (window[windowId].projectionMode == ProjectionMode::PERSPECTIVE)
+    if (window[windowId].projectionMode == ProjectionMode::Perspective)
         window[windowId].projection = glm::perspective(glm::radians(window[windowId].camera.Zoom),
             static_cast<GLfloat>(width) / static_cast<GLfloat>(height), 0.1f, 100.0f);
     else
@@ -384,203 +1290,90 @@ void display(int windowId)
     
     // Create camera transformations
     window[windowId].view = window[windowId].camera.GetViewMatrix();
+}
 
-    GLint modelLoc = glGetUniformLocation(program, "model");
-    GLint viewLoc = glGetUniformLocation(program, "view");
-    GLint projLoc = glGetUniformLocation(program, "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].projection));
+// Camera & lights as the uniform blocks lay them out, also what the CPU renderers take
+void writeFrameData(int windowId, CameraBlock& camera, LightBlock& lights)
+{
+    camera.view = window[windowId].view;
+    camera.projection = window[windowId].projection;
+    camera.viewPos = window[windowId].camera.Position;
 
-    glutSetVertexAttribCoord3(0);
-    glutSetVertexAttribNormal(1);
-    for (auto i = 0; i < NUM_OF_ORNAMENTS; ++i)
+    const auto& switches = window[windowId].lightSwitches;
+    for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
     {
-        if (window[windowId].useColorTracking)
-        {
-            glUniform3f(glGetUniformLocation(program, "material.ambient"),
-                ornamentColors[i].x,
-                ornamentColors[i].y,
-                ornamentColors[i].z);
-            glUniform3f(glGetUniformLocation(program, "material.diffuse"),
-                ornamentColors[i].x,
-                ornamentColors[i].y,
-                ornamentColors[i].z);
-            glUniform3f(glGetUniformLocation(program, "material.specular"),
-                ornamentColors[i].x,
-                ornamentColors[i].y,
-                ornamentColors[i].z);
-            glUniform1f(glGetUniformLocation(program, "material.shininess"),
-                ornamentMaterials[i].shininess);
-        }
-        else
-        {
-            glUniform3f(glGetUniformLocation(program, "material.ambient"),
-                ornamentMaterials[i].ambient.x,
-                ornamentMaterials[i].ambient.y,
-                ornamentMaterials[i].ambient.z);
-            glUniform3f(glGetUniformLocation(program, "material.diffuse"),
-                ornamentMaterials[i].diffuse.x,
-                ornamentMaterials[i].diffuse.y,
-                ornamentMaterials[i].diffuse.z);
-            glUniform3f(glGetUniformLocation(program, "material.specular"),
-                ornamentMaterials[i].specular.x,
-                ornamentMaterials[i].specular.y,
-                ornamentMaterials[i].specular.z);
-            glUniform1f(glGetUniformLocation(program, "material.shininess"),
-                ornamentMaterials[i].shininess);
-        }
+        shared.lights.Write(shared.pointLights[i], switches.IsOn(shared.pointLights[i]), lights.pointLights[i]);
+    }
+    shared.lights.Write(shared.spotLights[0], switches.IsOn(shared.spotLights[0]), lights.spotLight);
+    for (auto i = 0; i < NUM_OF_DISCO_LIGHTS; ++i)
+    {
+        shared.lights.Write(shared.spotLights[i + 1], switches.IsOn(shared.spotLights[i + 1]), lights.discoLights[i]);
+    }
+}
 
-        window[windowId].model = glm::mat4();
-        window[windowId].model = glm::translate(window[windowId].model, ornamentPositions[i]);
-        window[windowId].model = glm::rotate(window[windowId].model, glm::radians(ornamentRotations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
-        window[windowId].model = glm::rotate(window[windowId].model, glm::radians(ornamentRotations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
-        window[windowId].model = glm::rotate(window[windowId].model, glm::radians(ornamentRotations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
-        window[windowId].model = glm::scale(window[windowId].model, ornamentScales[i]);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-        window[windowId].ornaments[i]();
-    }
-    glutSetVertexAttribCoord3(-1);
-    glutSetVertexAttribNormal(-1);
-
-
-    glUniform3f(glGetUniformLocation(program, "material.ambient"),
-        planeMaterial.ambient.x,
-        planeMaterial.ambient.y,
-        planeMaterial.ambient.z);
-    glUniform3f(glGetUniformLocation(program, "material.diffuse"),
-        planeMaterial.diffuse.x,
-        planeMaterial.diffuse.y,
-        planeMaterial.diffuse.z);
-    glUniform3f(glGetUniformLocation(program, "material.specular"),
-        planeMaterial.specular.x,
-        planeMaterial.specular.y,
-        planeMaterial.specular.z);
-    glUniform1f(glGetUniformLocation(program, "material.shininess"),
-        planeMaterial.shininess);
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(0.0f, 2.28f, -2.28f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(0.0f, 2.28f, 2.28f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(270.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(0.0f, 4.56f, 0.0f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(2.28f, 2.28f, 0.0f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].planeVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(-2.28f, 2.28f, 0.0f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(270.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    window[windowId].model = glm::scale(window[windowId].model, glm::vec3(2.913f, 1.0f, 2.913f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, planeVertices);
-    glBindVertexArray(0);
-
-
-    glUniform3f(glGetUniformLocation(program, "material.ambient"),
-        tableMaterial.ambient.x,
-        tableMaterial.ambient.y,
-        tableMaterial.ambient.z);
-    glUniform3f(glGetUniformLocation(program, "material.diffuse"),
-        tableMaterial.diffuse.x,
-        tableMaterial.diffuse.y,
-        tableMaterial.diffuse.z);
-    glUniform3f(glGetUniformLocation(program, "material.specular"),
-        tableMaterial.specular.x,
-        tableMaterial.specular.y,
-        tableMaterial.specular.z);
-    glUniform1f(glGetUniformLocation(program, "material.shininess"),
-        tableMaterial.shininess);
-    glBindVertexArray(window[windowId].tableVAO);
-    window[windowId].model = glm::mat4();
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, tableVertices);
-    glBindVertexArray(0);
-
-
-    glUniform3f(glGetUniformLocation(program, "material.ambient"),
-        chairMaterial.ambient.x,
-        chairMaterial.ambient.y,
-        chairMaterial.ambient.z);
-    glUniform3f(glGetUniformLocation(program, "material.diffuse"),
-        chairMaterial.diffuse.x,
-        chairMaterial.diffuse.y,
-        chairMaterial.diffuse.z);
-    glUniform3f(glGetUniformLocation(program, "material.specular"),
-        chairMaterial.specular.x,
-        chairMaterial.specular.y,
-        chairMaterial.specular.z);
-    glUniform1f(glGetUniformLocation(program, "material.shininess"),
-        chairMaterial.shininess);
-    glBindVertexArray(window[windowId].chairVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(1.2482f, -0.34394f, 0.0f));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(28.01f), glm::vec3(0.0f, 1.0f, 0.0f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, chairVertices);
-    glBindVertexArray(0);
-
-    glBindVertexArray(window[windowId].chairVAO);
-    window[windowId].model = glm::mat4();
-    window[windowId].model = glm::translate(window[windowId].model, glm::vec3(-0.12125f, -0.34394, -1.34712));
-    window[windowId].model = glm::rotate(window[windowId].model, glm::radians(130.738f), glm::vec3(0.0f, 1.0f, 0.0f));
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-    glDrawArrays(GL_TRIANGLES, 0, chairVertices);
-    glBindVertexArray(0);
-
-    window[windowId].lampShader.Use();
-    modelLoc = glGetUniformLocation(window[windowId].lampShader(), "model");
-    viewLoc = glGetUniformLocation(window[windowId].lampShader(), "view");
-    projLoc = glGetUniformLocation(window[windowId].lampShader(), "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].projection));
-    glutSetVertexAttribCoord3(0);
-    glutSetVertexAttribNormal(1);
-    for (auto i = 0; i < NUM_OF_POINT_LIGHTS; ++i)
+// The first frame of each view without the overlay, quits once both are on disk
+void saveStill(int windowId, const std::vector<GLuint>* pixels, int width, int height)
+{
+    if (window[windowId].stillSaved)
     {
-        window[windowId].model = glm::mat4();
-        window[windowId].model = glm::translate(window[windowId].model, lightPositions[i]);
-        window[windowId].model = glm::scale(window[windowId].model, glm::vec3(0.05f));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(window[windowId].model));
-        glutSolidSphere(1.0f, 100, 100);
+        return;
     }
-    glutSetVertexAttribCoord3(-1);
-    glutSetVertexAttribNormal(-1);
 
-    glutSwapBuffers();
+    std::vector<GLuint> readBack;
+    if (!pixels)
+    {
+        readBack.resize(static_cast<size_t>(width) * height);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadBuffer(GL_BACK);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, readBack.data());
+        pixels = &readBack;
+    }
+
+    auto path = stillPrefix + "_" + viewName(windowId) + ".ppm";
+    if (WritePpm(path, *pixels, width, height))
+    {
+        std::cout << "Status: Saved the " << rendererName() << " still " << path << std::endl;
+    }
+    else
+    {
+        std::cerr << "Error: Couldn't write " << path << std::endl;
+    }
+    window[windowId].stillSaved = true;
+
+    if (std::all_of(window.begin(), window.end(), [](const WindowInfo& view) { return view.stillSaved; }))
+    {
+        glutLeaveMainLoop();
+    }
+}
+
+const char* rendererName()
+{
+    switch (renderer)
+    {
+    case RendererBackend::Software:
+        return "software";
+    case RendererBackend::RayTrace:
+        return "ray tracing";
+    default:
+        return "OpenGL";
+    }
+}
+
+// Left & right with the two views side by side, as stills and the gate's golden images are named, else view1, view2...
+std::string viewName(int windowId)
+{
+    if (window.size() == 2)
+    {
+        return windowId == 0 ? "left" : "right";
+    }
+    return "view" + std::to_string(windowId + 1);
+}
+
+// The view whose window GLUT made current for a callback
+int currentView()
+{
+    auto found = std::find(viewWindows.begin(), viewWindows.end(), glutGetWindow());
+    return static_cast<int>(found - viewWindows.begin());
 }
 
 void handleKeyPress(int windowId, unsigned char key, int x, int y)
@@ -591,18 +1384,21 @@ void handleKeyPress(int windowId, unsigned char key, int x, int y)
     if (key == 'z')
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+        window[windowId].polygonMode = GL_POINT;
         return;
     }
 
     if (key == 'x')
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        window[windowId].polygonMode = GL_LINE;
         return;
     }
 
     if (key == 'c')
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        window[windowId].polygonMode = GL_FILL;
         return;
     }
 
@@ -642,21 +1438,40 @@ void handleKeyPress(int windowId, unsigned char key, int x, int y)
         return;
     }
 
+    if (key == 'o')
+    {
+        window[windowId].useOcclusionCulling = !window[windowId].useOcclusionCulling;
+        return;
+    }
+
+    if (key == 'g')
+    {
+        window[windowId].antiAliasingMode = NextAntiAliasingMode(window[windowId].antiAliasingMode);
+        return;
+    }
+
+    if (key == 'p')
+    {
+        window[windowId].projectionMode = window[windowId].projectionMode == ProjectionMode::Perspective ?
+            ProjectionMode::Orthographic : ProjectionMode::Perspective;
+        return;
+    }
+
     if (key == '1')
     {
-        window[windowId].pointLights[0].Toggle();
+        window[windowId].lightSwitches.Toggle(shared.pointLights[0]);
         return;
     }
 
     if (key == '2')
     {
-        window[windowId].pointLights[1].Toggle();
+        window[windowId].lightSwitches.Toggle(shared.pointLights[1]);
         return;
     }
 
     if (key == '3')
     {
-        window[windowId].spotLight.Toggle();
+        window[windowId].lightSwitches.Toggle(shared.spotLights[0]);
         return;
     }
 
@@ -667,17 +1482,19 @@ void handleKeyPress(int windowId, unsigned char key, int x, int y)
 
     if (key == '[')
     {
-        window[windowId].spotLightSwingSpeed += 0.1f;
+        spotLightSwingSpeed += 0.1f;
+        animator.SetRate(AnimationTarget::SpotLight, 0, spotLightSwingSpeed);
         return;
     }
 
     if (key == ']')
     {
-        window[windowId].spotLightSwingSpeed -= 0.1f;
-        if (window[windowId].spotLightSwingSpeed < 1.0f)
+        spotLightSwingSpeed -= 0.1f;
+        if (spotLightSwingSpeed < 1.0f)
         {
-            window[windowId].spotLightSwingSpeed = 1.0f;
+            spotLightSwingSpeed = 1.0f;
         }
+        animator.SetRate(AnimationTarget::SpotLight, 0, spotLightSwingSpeed);
         return;
     }
 
@@ -741,6 +1558,62 @@ void handleSpecialUp(int windowId, int key, int x, int y)
         window[windowId].keys[GLUT_KEY_RIGHT_CUSTOM] = false;
 }
 
+// Picks on every move, what's under the cursor shows in the status panel
+void handleMouseMove(int windowId, int x, int y)
+{
+    auto cull = BvhCull::None;
+    if (window[windowId].useBackfaceCulling)
+    {
+        cull = window[windowId].cullFrontFace ? BvhCull::FrontFaces : BvhCull::BackFaces;
+    }
+    glm::vec2 size(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+
+    auto start = std::chrono::steady_clock::now();
+    picker.Pick(objectTree, glm::vec2(x, y), size, window[windowId].view, window[windowId].projection, cull, window[windowId].picked);
+    window[windowId].pickMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Live input is logged when recording and ignored while replaying, but for ESC to quit
+bool acceptInput(int windowId, InputEventType type, int key, int x, int y)
+{
+    if (inputLog.Replaying())
+    {
+        return type == InputEventType::KeyUp && key == GLUT_KEY_ESCAPE;
+    }
+    inputLog.Add(windowId, type, key, x, y);
+    return true;
+}
+
+// Replays an event with its view's window current, as GLUT has it for a live one
+void dispatchInput(const InputEvent& event)
+{
+    if (event.view >= viewWindows.size())
+    {
+        return;
+    }
+    glutSetWindow(viewWindows[event.view]);
+    switch (event.type)
+    {
+    case InputEventType::KeyPress:
+        handleKeyPress(event.view, static_cast<unsigned char>(event.key), event.x, event.y);
+        break;
+    case InputEventType::KeyUp:
+        handleKeyUp(event.view, static_cast<unsigned char>(event.key), event.x, event.y);
+        break;
+    case InputEventType::SpecialPress:
+        handleSpecialPress(event.view, event.key, event.x, event.y);
+        break;
+    case InputEventType::SpecialUp:
+        handleSpecialUp(event.view, event.key, event.x, event.y);
+        break;
+    case InputEventType::MouseMove:
+        handleMouseMove(event.view, event.x, event.y);
+        break;
+    default:
+        break;
+    }
+}
+
 void handleSmoothInput(int windowId)
 {
     // Camera controls
@@ -931,9 +1804,9 @@ void mainWindowDisplayCallback()
     glutSwapBuffers();
 }
 
-void leftWindowDisplayCallback()
+void viewDisplayCallback()
 {
-    display(0);
+    display(currentView());
 }
 
 //void leftWindowDisplayCallback()
@@ -1215,70 +2088,15 @@ void leftWindowDisplayCallback()
 //    glutSwapBuffers();
 //}
 
-void rightWindowDisplayCallback()
-{
-    /*glClearColor(1.0f, 0.0f, 0.0f, 0.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    shader.Use();
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    glutSwapBuffers();*/
-    display(1);
-}
-
 void instructionDisplayCallback()
 {
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glViewport(0, 0, 1200, 200);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(-1.0f, 1200, -1.0f, 200);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    glColor3ub(0, 0, 0);
-    renderText(20, 180, GLUT_BITMAP_HELVETICA_12, "z - Points mode");
-    renderText(20, 160, GLUT_BITMAP_HELVETICA_12, "x - Wireframe mode");
-    renderText(20, 140, GLUT_BITMAP_HELVETICA_12, "c - Solid mode");
-    renderText(20, 120, GLUT_BITMAP_HELVETICA_12, "v - Toggle shading");
-
-    glColor3ub(255, 0, 0);
-    renderText(20, 100, GLUT_BITMAP_HELVETICA_12, "b - Toggle color tracking");
-    renderText(20, 80, GLUT_BITMAP_HELVETICA_12, "n - Toggle ambient lighting");
-    glColor3ub(0, 0, 0);
-
-    renderText(20, 60, GLUT_BITMAP_HELVETICA_12, "m - Toggle backface culling");
-    renderText(20, 40, GLUT_BITMAP_HELVETICA_12, ", - Toggle culling face");
-    renderText(20, 20, GLUT_BITMAP_HELVETICA_12, ". - Toggle depth testing");
-
-    renderText(220, 180, GLUT_BITMAP_HELVETICA_12, "1 - Toggle point light 1");
-    renderText(220, 160, GLUT_BITMAP_HELVETICA_12, "2 - Toggle point light 2");
-    renderText(220, 140, GLUT_BITMAP_HELVETICA_12, "3 - Toggle spot light");
-    renderText(220, 120, GLUT_BITMAP_HELVETICA_12, "4 - Toggle disco mode");
-    renderText(220, 100, GLUT_BITMAP_HELVETICA_12, "[ - Speedup spotlight swing");
-    renderText(220, 80, GLUT_BITMAP_HELVETICA_12, "] - Slowdown spotlight swing");
-    renderText(220, 60, GLUT_BITMAP_HELVETICA_12, "ESC - Quit");
-
-    renderText(420, 180, GLUT_BITMAP_HELVETICA_12, "w - Move forward");
-    renderText(420, 160, GLUT_BITMAP_HELVETICA_12, "a - Move backward");
-    renderText(420, 140, GLUT_BITMAP_HELVETICA_12, "s - Strafe left");
-    renderText(420, 120, GLUT_BITMAP_HELVETICA_12, "d - Strafe right");
-    renderText(420, 100, GLUT_BITMAP_HELVETICA_12, "q - Roll left");
-    renderText(420, 80, GLUT_BITMAP_HELVETICA_12, "e - Roll right");
-    renderText(420, 60, GLUT_BITMAP_HELVETICA_12, "UP - Look up");
-    renderText(420, 40, GLUT_BITMAP_HELVETICA_12, "DOWN - Look down");
-    renderText(420, 20, GLUT_BITMAP_HELVETICA_12, "LEFT - Look left");
-
-    renderText(620, 180, GLUT_BITMAP_HELVETICA_12, "RIGHT - Look right");
-    renderText(620, 160, GLUT_BITMAP_HELVETICA_12, "PAGE UP - Move up");
-    renderText(620, 140, GLUT_BITMAP_HELVETICA_12, "PAGE DOWN - Move down");
-    renderText(620, 120, GLUT_BITMAP_HELVETICA_12, "HOME - Zoom in");
-    renderText(620, 100, GLUT_BITMAP_HELVETICA_12, "END - Zoom out");
-    renderText(620, 80, GLUT_BITMAP_HELVETICA_12, "0 - Reset camera");
+    auto width = glutGet(GLUT_WINDOW_WIDTH);
+    auto height = glutGet(GLUT_WINDOW_HEIGHT);
+
+    // The panel covers the whole window, so there is nothing to clear
+    glViewport(0, 0, width, height);
+    instructionPanel.SetSize(width, height);
+    instructionPanel.Draw(shared.panelShader, 0, 0);
 
     glutSwapBuffers();
 }
@@ -1287,48 +2105,87 @@ void idleCallback()
 {
     // Calculate deltatime of current frame
     GLfloat currentFrame = static_cast<GLfloat>(glutGet(GLUT_ELAPSED_TIME)) / 1000.0f;
-    deltaTime = currentFrame - lastFrame;
+    auto elapsed = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
-    handleSmoothInput(0);
-    handleSmoothInput(1);
-
-    glutSetWindow(leftWindow);
-    glutPostRedisplay();
-    glutSetWindow(rightWindow);
-    glutPostRedisplay();
-}
+    if (inputLog.Replaying())
+    {
+        // One fixed step per frame, so every run draws the same frames however long they take
+        deltaTime = INPUT_TIME_STEP;
+        if (!inputLog.Step(dispatchInput))
+        {
+            glutLeaveMainLoop();
+            return;
+        }
+        for (size_t i = 0; i < window.size(); ++i)
+        {
+            handleSmoothInput(static_cast<int>(i));
+        }
+    }
+    else if (inputLog.Recording())
+    {
+        // Fixed steps as the wall clock passes, the same steps the replay takes
+        deltaTime = INPUT_TIME_STEP;
+        for (inputLag += elapsed; inputLag >= INPUT_TIME_STEP; inputLag -= INPUT_TIME_STEP)
+        {
+            inputLog.Step(nullptr);
+            for (size_t i = 0; i < window.size(); ++i)
+            {
+                handleSmoothInput(static_cast<int>(i));
+            }
+        }
+    }
+    else
+    {
+        deltaTime = elapsed;
+        for (size_t i = 0; i < window.size(); ++i)
+        {
+            handleSmoothInput(static_cast<int>(i));
+        }
+    }
 
-void leftWindowKeyPressCallback(unsigned char key, int x, int y) {
-    handleKeyPress(0, key, x, y);
-}
+    frameTime = inputLog.Recording() || inputLog.Replaying() ? inputLog.Time() : currentFrame;
 
-void leftWindowKeyUpCallback(unsigned char key, int x, int y) {
-    handleKeyUp(0, key, x, y);
-}
+    if (multiView)
+    {
+        renderMultiView();
+    }
 
-void leftWindowSpecialPressCallback(int key, int x, int y) {
-    handleSpecialPress(0, key, x, y);
+    for (auto view : viewWindows)
+    {
+        glutSetWindow(view);
+        glutPostRedisplay();
+    }
 }
 
-void leftWindowSpecialUpCallback(int key, int x, int y) {
-    handleSpecialUp(0, key, x, y);
+void viewKeyPressCallback(unsigned char key, int x, int y) {
+    auto view = currentView();
+    if (acceptInput(view, InputEventType::KeyPress, key, x, y))
+        handleKeyPress(view, key, x, y);
 }
 
-void rightWindowKeyPressCallback(unsigned char key, int x, int y) {
-    handleKeyPress(1, key, x, y);
+void viewKeyUpCallback(unsigned char key, int x, int y) {
+    auto view = currentView();
+    if (acceptInput(view, InputEventType::KeyUp, key, x, y))
+        handleKeyUp(view, key, x, y);
 }
 
-void rightWindowKeyUpCallback(unsigned char key, int x, int y) {
-    handleKeyUp(1, key, x, y);
+void viewSpecialPressCallback(int key, int x, int y) {
+    auto view = currentView();
+    if (acceptInput(view, InputEventType::SpecialPress, key, x, y))
+        handleSpecialPress(view, key, x, y);
 }
 
-void rightWindowSpecialPressCallback(int key, int x, int y) {
-    handleSpecialPress(1, key, x, y);
+void viewSpecialUpCallback(int key, int x, int y) {
+    auto view = currentView();
+    if (acceptInput(view, InputEventType::SpecialUp, key, x, y))
+        handleSpecialUp(view, key, x, y);
 }
 
-void rightWindowSpecialUpCallback(int key, int x, int y) {
-    handleSpecialUp(1, key, x, y);
+void viewMouseMoveCallback(int x, int y) {
+    auto view = currentView();
+    if (acceptInput(view, InputEventType::MouseMove, 0, x, y))
+        handleMouseMove(view, x, y);
 }
 
 //void key_press_callback(unsigned char key, int x, int y)
@@ -1486,14 +2343,4 @@ void rightWindowSpecialUpCallback(int key, int x, int y) {
 //        }
 //    }
 //    
-//}
-
-void renderText(const float &x, const float &y, void *font, const char *const str) {
-    const char *ptr; // Temp pointer to position in string
-
-    glRasterPos2f(x, y); // Place raster position
-
-    for (ptr = str; *ptr != '\0'; ++ptr) {
-        glutBitmapCharacter(font, *ptr); // Draw bitmap character
-    }
-}
\ No newline at end of file
+//}
\ No newline at end of file
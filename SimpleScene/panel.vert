@@ -0,0 +1,11 @@
+#version 330 core
+out vec2 TexCoords;
+
+uniform vec4 rect; // <vec2 bottom left, vec2 size> in clip space
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+    TexCoords = corner;
+}
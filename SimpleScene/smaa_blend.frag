@@ -0,0 +1,40 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D colorTexture;
+uniform sampler2D passTexture; // Blend weights
+
+vec3 colorAt(ivec2 pixel)
+{
+    return texelFetch(colorTexture, clamp(pixel, ivec2(0), textureSize(colorTexture, 0) - 1), 0).rgb;
+}
+
+// Each pixel takes from its neighbours what the weights pass gave it across each edge
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(passTexture, 0);
+    vec4 weights = texelFetch(passTexture, pixel, 0);
+    float below = weights.r;
+    float left = weights.b;
+    float above = pixel.y + 1 < size.y ? texelFetch(passTexture, pixel + ivec2(0, 1), 0).g : 0.0f;
+    float right = pixel.x + 1 < size.x ? texelFetch(passTexture, pixel + ivec2(1, 0), 0).a : 0.0f;
+
+    vec3 center = colorAt(pixel);
+    float total = below + left + above + right;
+    if (total <= 0.0f)
+    {
+        color = vec4(center, 1.0f);
+        return;
+    }
+
+    vec3 blended = below * colorAt(pixel - ivec2(0, 1)) + above * colorAt(pixel + ivec2(0, 1)) +
+                   left * colorAt(pixel - ivec2(1, 0)) + right * colorAt(pixel + ivec2(1, 0));
+    if (total > 1.0f)
+    {
+        blended /= total;
+        total = 1.0f;
+    }
+    color = vec4(center * (1.0f - total) + blended, 1.0f);
+}
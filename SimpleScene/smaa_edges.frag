@@ -0,0 +1,22 @@
+#version 330 core
+in vec2 TexCoords;
+out vec2 edges;
+
+uniform sampler2D colorTexture;
+
+// Luma difference that counts as an edge
+#define EDGE_THRESHOLD 0.1f
+
+float luma(ivec2 pixel)
+{
+    return dot(texelFetch(colorTexture, pixel, 0).rgb, vec3(0.299f, 0.587f, 0.114f));
+}
+
+// r: edge with the pixel to the left, g: edge with the pixel below
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float center = luma(pixel);
+    edges = vec2(pixel.x > 0 && abs(center - luma(pixel - ivec2(1, 0))) > EDGE_THRESHOLD ? 1.0f : 0.0f,
+                 pixel.y > 0 && abs(center - luma(pixel - ivec2(0, 1))) > EDGE_THRESHOLD ? 1.0f : 0.0f);
+}
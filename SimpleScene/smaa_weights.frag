@@ -0,0 +1,83 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 weights;
+
+uniform sampler2D passTexture; // Edges
+
+// Pixels searched each way along an edge line, longer lines are treated as open ended
+#define MAX_SEARCH 16
+
+vec2 edgesAt(ivec2 pixel)
+{
+    ivec2 size = textureSize(passTexture, 0);
+    if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, size)))
+    {
+        return vec2(0.0f);
+    }
+    return texelFetch(passTexture, pixel, 0).rg;
+}
+
+// Height of the revectorised line t pixels along an edge line, from the heights at its ends.
+// Ends on opposite sides make a Z, a straight line across; otherwise each end's half slopes to the middle
+float lineHeight(float t, float length, float start, float end)
+{
+    if (start * end < 0.0f)
+    {
+        return mix(start, end, t / length);
+    }
+    float middle = 0.5f * length;
+    return t < middle ? start * (1.0f - t / middle) : end * (t - middle) / middle;
+}
+
+// r: how much this pixel takes from the one below, g: how much the one below takes from it,
+// b: how much this pixel takes from the one to the left, a: how much the one to the left takes from it
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 edges = edgesAt(pixel);
+    weights = vec4(0.0f);
+
+    if (edges.g > 0.0f)
+    {
+        int left = 0;
+        while (left < MAX_SEARCH && edgesAt(pixel - ivec2(left + 1, 0)).g > 0.0f)
+        {
+            ++left;
+        }
+        int right = 0;
+        while (right < MAX_SEARCH && edgesAt(pixel + ivec2(right + 1, 0)).g > 0.0f)
+        {
+            ++right;
+        }
+
+        // A crossing edge at an end in this row takes the line up into it, one in the row below takes it down
+        ivec2 first = pixel - ivec2(left, 0);
+        ivec2 past = pixel + ivec2(right + 1, 0);
+        float start = left < MAX_SEARCH ? 0.5f * (edgesAt(first).r - edgesAt(first - ivec2(0, 1)).r) : 0.0f;
+        float end = right < MAX_SEARCH ? 0.5f * (edgesAt(past).r - edgesAt(past - ivec2(0, 1)).r) : 0.0f;
+        float height = lineHeight(float(left) + 0.5f, float(left + right + 1), start, end);
+        weights.rg = vec2(max(height, 0.0f), max(-height, 0.0f));
+    }
+
+    if (edges.r > 0.0f)
+    {
+        int down = 0;
+        while (down < MAX_SEARCH && edgesAt(pixel - ivec2(0, down + 1)).r > 0.0f)
+        {
+            ++down;
+        }
+        int up = 0;
+        while (up < MAX_SEARCH && edgesAt(pixel + ivec2(0, up + 1)).r > 0.0f)
+        {
+            ++up;
+        }
+
+        // Likewise a crossing edge in this column takes the line into it, one in the column to the left takes it there
+        ivec2 first = pixel - ivec2(0, down);
+        ivec2 past = pixel + ivec2(0, up + 1);
+        float start = down < MAX_SEARCH ? 0.5f * (edgesAt(first).g - edgesAt(first - ivec2(1, 0)).g) : 0.0f;
+        float end = up < MAX_SEARCH ? 0.5f * (edgesAt(past).g - edgesAt(past - ivec2(1, 0)).g) : 0.0f;
+        float height = lineHeight(float(down) + 0.5f, float(down + up + 1), start, end);
+        weights.ba = vec2(max(height, 0.0f), max(-height, 0.0f));
+    }
+}
@@ -14,56 +14,122 @@ struct DirLight {
     vec3 specular;
 };
 
+// Members are ordered so each vec3 shares a std140 slot with a float
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-    
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
     float constant;
+    vec3 direction;
     float linear;
-    float quadratic;
-  
     vec3 ambient;
+    float quadratic;
     vec3 diffuse;
-    vec3 specular;       
+    float cutOff;
+    vec3 specular;
+    float outerCutOff;
+};
+
+struct MaterialData {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular; // w holds the shininess
 };
 
 #define NR_POINT_LIGHTS 2
 #define NR_DISCO_LIGHTS 4
+#define NR_MATERIALS 256
 
 in vec3 FragPos;
 in vec3 Normal;
+flat in int MaterialIndex;
+#ifdef MULTI_VIEW
+flat in int ViewIndex;
+#else
+in vec3 Baked;
+#endif
 
 out vec4 color;
 
-uniform vec3 viewPos;
+#ifdef MULTI_VIEW
+// One entry per view, main copies its view's into globals named like the single view blocks' members
+struct CameraData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+struct LightData {
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+    SpotLight discoLights[NR_DISCO_LIGHTS];
+};
+layout (std140) uniform Camera {
+    CameraData cameras[MAX_VIEWS];
+};
+layout (std140) uniform Lights {
+    LightData lights[MAX_VIEWS];
+};
+mat4 view;
+mat4 projection;
+vec3 viewPos;
+PointLight pointLights[NR_POINT_LIGHTS];
+SpotLight spotLight;
+SpotLight discoLights[NR_DISCO_LIGHTS];
+#else
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+layout (std140) uniform Lights {
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+    SpotLight discoLights[NR_DISCO_LIGHTS];
+};
+#endif
+#ifndef MULTI_VIEW
+// Lights past the Lights block's, read from LightPool's planes of lightStride texels each
+uniform samplerBuffer lightPlanes;
+uniform isamplerBuffer visibleLights;
+uniform int lightStride;
+uniform int visibleLightCount;
+#endif
 uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform SpotLight discoLights[NR_DISCO_LIGHTS];
-uniform Material material;
+layout (std140) uniform Materials {
+    MaterialData materials[NR_MATERIALS];
+};
+
+Material material;
 
 // Function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+#ifndef MULTI_VIEW
+SpotLight PoolLight(int index);
+#endif
 
 void main()
 {    
+#ifdef MULTI_VIEW
+    view = cameras[ViewIndex].view;
+    projection = cameras[ViewIndex].projection;
+    viewPos = cameras[ViewIndex].viewPos;
+    pointLights = lights[ViewIndex].pointLights;
+    spotLight = lights[ViewIndex].spotLight;
+    discoLights = lights[ViewIndex].discoLights;
+#endif
     // Properties
+    MaterialData data = materials[MaterialIndex];
+    material = Material(data.ambient.xyz, data.diffuse.xyz, data.specular.xyz, data.specular.w);
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 result;
@@ -85,6 +151,13 @@ void main()
     for (int i = 0; i < NR_DISCO_LIGHTS; ++i) {
         result += CalcSpotLight(discoLights[i], norm, FragPos, viewDir);
     }
+#ifndef MULTI_VIEW
+    for (int i = 0; i < visibleLightCount; ++i) {
+        result += CalcSpotLight(PoolLight(texelFetch(visibleLights, i).r), norm, FragPos, viewDir);
+    }
+    // Baked point lights are written black into the Lights block and left out of the visible ones
+    result += Baked;
+#endif
     
     color = vec4(result, 1.0);
 }
@@ -152,3 +225,17 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
 }
+
+#ifndef MULTI_VIEW
+// A pool light, point lights have a cone wide enough to let everything through
+SpotLight PoolLight(int index)
+{
+    vec4 position = texelFetch(lightPlanes, index);
+    vec4 direction = texelFetch(lightPlanes, lightStride + index);
+    vec4 ambient = texelFetch(lightPlanes, 2 * lightStride + index);
+    vec4 diffuse = texelFetch(lightPlanes, 3 * lightStride + index);
+    vec4 specular = texelFetch(lightPlanes, 4 * lightStride + index);
+    return SpotLight(position.xyz, position.w, direction.xyz, direction.w, ambient.xyz, ambient.w,
+                     diffuse.xyz, diffuse.w, specular.xyz, specular.w);
+}
+#endif
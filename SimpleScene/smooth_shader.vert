@@ -1,17 +1,67 @@
 #version 330 core
+#ifdef MULTI_VIEW
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_viewport_index : enable
+#endif
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
+layout (location = 2) in mat4 model; // Per draw
+layout (location = 6) in int materialIndex; // Per draw
+#ifndef MULTI_VIEW
+layout (location = 7) in int bakeBase; // Per draw
+#endif
 
 out vec3 Normal;
 out vec3 FragPos;
+flat out int MaterialIndex;
+#ifdef MULTI_VIEW
+flat out int ViewIndex;
+#else
+out vec3 Baked;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// The static point lights' ambient & diffuse, one texel per vertex from bakeBase on
+uniform samplerBuffer bakedLighting;
+uniform bool useBakedLighting;
+#endif
+
+// Same depth as the occluder prepass
+invariant gl_Position;
+
+#ifdef MULTI_VIEW
+// One entry per view, main copies its view's into globals named like the single view block's members
+struct CameraData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+layout (std140) uniform Camera {
+    CameraData cameras[MAX_VIEWS];
+};
+mat4 view;
+mat4 projection;
+vec3 viewPos;
+#else
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+#endif
 
 void main()
 {
+#ifdef MULTI_VIEW
+    // One instance per view, the per-draw attributes only step once per draw
+    view = cameras[gl_InstanceID].view;
+    projection = cameras[gl_InstanceID].projection;
+    gl_ViewportIndex = gl_InstanceID;
+    ViewIndex = gl_InstanceID;
+#endif
     gl_Position = projection * view *  model * vec4(position, 1.0f);
     FragPos = vec3(model * vec4(position, 1.0f));
     Normal = mat3(transpose(inverse(model))) * normal;
+    MaterialIndex = materialIndex;
+#ifndef MULTI_VIEW
+    Baked = useBakedLighting && bakeBase >= 0 ? texelFetch(bakedLighting, bakeBase + gl_VertexID).rgb : vec3(0.0);
+#endif
 } 
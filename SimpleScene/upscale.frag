@@ -0,0 +1,25 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D colorTexture; // The scaled down view, linearly filtered
+uniform float sharpness; // 0 for plain bilinear
+
+// Bilinear, then pushed away from the average of the source texels around it,
+// kept within their range so edges don't ring
+void main()
+{
+    vec3 center = texture(colorTexture, TexCoords).rgb;
+    if (sharpness > 0.0f)
+    {
+        vec2 texel = 1.0f / vec2(textureSize(colorTexture, 0));
+        vec3 up = texture(colorTexture, TexCoords + vec2(0.0f, texel.y)).rgb;
+        vec3 down = texture(colorTexture, TexCoords - vec2(0.0f, texel.y)).rgb;
+        vec3 left = texture(colorTexture, TexCoords - vec2(texel.x, 0.0f)).rgb;
+        vec3 right = texture(colorTexture, TexCoords + vec2(texel.x, 0.0f)).rgb;
+        vec3 low = min(center, min(min(up, down), min(left, right)));
+        vec3 high = max(center, max(max(up, down), max(left, right)));
+        center = clamp(center + sharpness * (center - 0.25f * (up + down + left + right)), low, high);
+    }
+    color = vec4(center, 1.0f);
+}